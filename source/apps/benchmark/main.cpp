@@ -0,0 +1,243 @@
+//! \file main.cpp
+//! \brief Headless benchmark of simulation step and colormap
+
+#include "common/colormap.h"
+#include "common/colors.h"
+#include "common/cpu_topology.h"
+#include "common/perf_counters.h"
+#include "common/presets.h"
+#include "common/slime_mold_simulation.h"
+#include "common/slime_mold_viewmodel.h"
+#include "common/slime_mold_volume.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+
+const char* phaseName(SlimeMoldSimulation::Phase phase)
+{
+    switch (phase) {
+    case SlimeMoldSimulation::PHASE_MOVE:      return "move     ";
+    case SlimeMoldSimulation::PHASE_DEPOSIT:   return "deposit  ";
+    case SlimeMoldSimulation::PHASE_SORT:      return "sort     ";
+    case SlimeMoldSimulation::PHASE_LIFECYCLE: return "lifecycle";
+    case SlimeMoldSimulation::PHASE_DIFFUSE:   return "diffuse  ";
+    default:                                   return "";
+    }
+}
+
+
+// Counter per agent or cell, "n/a" when counter could not be opened
+std::string perUnit(const PerfCounters& counters, const PhaseCounters::Totals& t, PerfCounters::Counter c, double units)
+{
+    if (!counters.available(c))
+        return "n/a";
+    return std::format("{:.3f}", t.values[c] / units);
+}
+
+} // anonymous namespace
+
+
+// Usage: slime_mold_benchmark [width height agents steps [cpus]]
+// cpus pins workers, "cores" is one per physical core, or list like "0-7,16"
+int main(int argc, char* argv[])
+{
+    size_t width  = 640;
+    size_t height = 480;
+    size_t agents = 250000;
+    size_t steps  = 500;
+    if (argc == 5 || argc == 6) {
+        width  = std::strtoul(argv[1], nullptr, 10);
+        height = std::strtoul(argv[2], nullptr, 10);
+        agents = std::strtoul(argv[3], nullptr, 10);
+        steps  = std::strtoul(argv[4], nullptr, 10);
+    }
+    if (argc == 6) {
+        const std::string_view arg = argv[5];
+        const std::vector<int> cpus = arg == "cores" ? cpusOnePerCore(cpuTopology()) : parseCpuList(arg);
+        if (cpus.empty()) {
+            std::println(stderr, "no CPUs in '{}'", arg);
+            return 1;
+        }
+        // Caller is not pinned, it takes place of last CPU
+        ThreadPool::global().resize(cpus.size(), cpus);
+    }
+    if ((width * height) % 8 != 0 || steps == 0) {
+        std::println(stderr, "width*height must be divisible by 8 and steps nonzero");
+        return 1;
+    }
+
+    std::println("Field {}x{}, {} agents, {} steps, {} threads",
+        width, height, agents, steps, ThreadPool::global().size());
+
+    // === Simulation only, cycle through presets, both agent formats and sensor sampling modes ===
+    for (const auto& [format, formatLabel] : {
+            std::pair{ SlimeMoldSimulation::AGENTS_FLOAT,   "float  " },
+            std::pair{ SlimeMoldSimulation::AGENTS_COMPACT, "compact" } }) {
+        for (const auto& [sampling, label] : {
+                std::pair{ SlimeMoldSimulation::SAMPLING_NEAREST,  "nearest " },
+                std::pair{ SlimeMoldSimulation::SAMPLING_BILINEAR, "bilinear" } }) {
+            SlimeMoldSimulation sim(width, height, agents);
+            if (!sim.setAgentFormat(format))
+                continue;
+            sim.setSampling(sampling);
+            const auto& presets = presetAgents();
+            const auto start = Clock::now();
+            for (size_t i = 0; i < steps; ++i)
+                sim.step(presets[(i * presets.size()) / steps]);
+            const double ms = elapsedMs(start);
+            std::println("step {} {}  {:8.3f} ms/step  {:8.1f} Magents/s",
+                formatLabel, label, ms / steps, agents * steps / ms / 1000.0);
+        }
+    }
+
+    // === Load of threads during simulation runs ===
+    double busiest = 0.0;
+    const auto workers = ThreadPool::global().stats();
+    for (const auto& w : workers)
+        busiest = std::max(busiest, w.busySeconds);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const auto& w = workers[i];
+        std::println("thread {:2} cpu {:>3}  busy {:5.1f} % of busiest  {:6} chunks, {:5.1f} % stolen",
+            i, w.cpu >= 0 ? std::to_string(w.cpu) : "-", busiest > 0.0 ? 100.0 * w.busySeconds / busiest : 0.0,
+            w.chunks, w.chunks ? 100.0 * w.stolenChunks / w.chunks : 0.0);
+    }
+
+    // === Hardware counters per phase, per agent and per cell for diffusion ===
+    {
+        const PerfCounters counters;
+        if (!counters.valid())
+            std::println("phase counters unavailable ({}), wall time only", counters.error());
+        else
+            std::println("phase counters on {} threads", counters.threads());
+        PhaseCounters phases(&counters, SlimeMoldSimulation::PHASE_END);
+        for (const auto& [format, formatLabel] : {
+                std::pair{ SlimeMoldSimulation::AGENTS_FLOAT,   "float  " },
+                std::pair{ SlimeMoldSimulation::AGENTS_COMPACT, "compact" } }) {
+            SlimeMoldSimulation sim(width, height, agents);
+            if (!sim.setAgentFormat(format))
+                continue;
+            sim.setPhaseCallback([&](SlimeMoldSimulation::Phase phase) { phases.mark(phase); });
+            phases.clear();
+            const auto& presets = presetAgents();
+            for (size_t i = 0; i < steps; ++i)
+                sim.step(presets[(i * presets.size()) / steps]);
+            for (size_t i = 0; i < SlimeMoldSimulation::PHASE_END; ++i) {
+                const auto phase = static_cast<SlimeMoldSimulation::Phase>(i);
+                const PhaseCounters::Totals& t = phases.totals()[i];
+                if (t.runs == 0)
+                    continue;
+                const bool perCell = phase == SlimeMoldSimulation::PHASE_DIFFUSE;
+                const double units = static_cast<double>(t.runs) * (perCell ? width * height : agents);
+                const bool ipc = counters.available(PerfCounters::CYCLES) && counters.available(PerfCounters::INSTRUCTIONS)
+                    && t.values[PerfCounters::CYCLES] > 0;
+                std::println("phase {} {}  {:8.3f} ms/step  per {}: {:>7} cycles {:>7} instructions {:>7} LLC misses {:>7} dTLB misses  IPC {}",
+                    formatLabel, phaseName(phase), t.seconds * 1000.0 / t.runs, perCell ? "cell " : "agent",
+                    perUnit(counters, t, PerfCounters::CYCLES, units),
+                    perUnit(counters, t, PerfCounters::INSTRUCTIONS, units),
+                    perUnit(counters, t, PerfCounters::LLC_MISSES, units),
+                    perUnit(counters, t, PerfCounters::DTLB_MISSES, units),
+                    ipc ? std::format("{:.2f}", double(t.values[PerfCounters::INSTRUCTIONS]) / t.values[PerfCounters::CYCLES]) : "n/a");
+            }
+        }
+    }
+
+    // === Colormap of field stepped above, plain and scaled to 4K display in row chunks as view model does ===
+    {
+        SlimeMoldSimulation sim(width, height, agents);
+        for (size_t i = 0; i < 100; ++i)
+            sim.step(presetAgents()[0]);
+        std::vector<uint8_t> lut(colormap::PALETTE_SIZE * 4);
+        for (size_t i = 0; i < lut.size(); ++i)
+            lut[i] = static_cast<uint8_t>(i);
+        constexpr size_t DISPLAY_WIDTH = 3840, DISPLAY_HEIGHT = 2160, ROW_CHUNK = 32, PIXEL_CHUNK = 16384;
+        std::vector<uint8_t> pixels(DISPLAY_WIDTH * DISPLAY_HEIGHT * 4);
+        std::vector<colormap::Stats> stats((DISPLAY_HEIGHT + ROW_CHUNK - 1) / ROW_CHUNK + width * height / PIXEL_CHUNK + 1);
+        const size_t frames = std::max<size_t>(steps / 5, 1);
+        auto start = Clock::now();
+        for (size_t f = 0; f < frames; ++f) {
+            ThreadPool::global().parallelFor(width * height, PIXEL_CHUNK, [&](size_t begin, size_t end) {
+                colormap::apply(sim.data() + begin, pixels.data() + begin * 4, end - begin, lut.data(), 10.0f,
+                    stats[begin / PIXEL_CHUNK]);
+            });
+        }
+        double ms = elapsedMs(start);
+        std::println("colormap {}x{}          {:8.3f} ms/frame", width, height, ms / frames);
+        for (const auto& [filter, label] : {
+                std::pair{ colormap::FILTER_NEAREST,  "nearest " },
+                std::pair{ colormap::FILTER_BILINEAR, "bilinear" },
+                std::pair{ colormap::FILTER_LANCZOS,  "lanczos " } }) {
+            const colormap::Scaler scaler = colormap::makeScaler(width, height, DISPLAY_WIDTH, DISPLAY_HEIGHT, filter);
+            start = Clock::now();
+            for (size_t f = 0; f < frames; ++f) {
+                ThreadPool::global().parallelFor(DISPLAY_HEIGHT, ROW_CHUNK, [&](size_t begin, size_t end) {
+                    colormap::applyScaled(scaler, sim.data(), pixels.data(), begin, end, lut.data(), 10.0f,
+                        stats[begin / ROW_CHUNK]);
+                });
+            }
+            ms = elapsedMs(start);
+            std::println("colormap to {}x{} {}  {:8.3f} ms/frame", DISPLAY_WIDTH, DISPLAY_HEIGHT, label, ms / frames);
+        }
+    }
+
+    // === Volume as in view model (agent per 16 voxels): steps, then projections to field sized image ===
+    for (size_t size : { size_t(128), size_t(256) }) {
+        const size_t volumeAgents = size * size * size / 16;
+        const size_t volumeSteps = std::max<size_t>(steps / 10, 1);
+        SlimeMoldVolume volume(size, size, size, volumeAgents);
+        auto start = Clock::now();
+        for (size_t i = 0; i < volumeSteps; ++i)
+            volume.step(presetAgents()[0]);
+        double ms = elapsedMs(start);
+        std::println("volume {}^3 step         {:8.3f} ms/step  {:8.1f} Magents/s",
+            size, ms / volumeSteps, volumeAgents * volumeSteps / ms / 1000.0);
+        std::vector<float> image(width * height);
+        for (const auto& [render, label] : {
+                std::pair{ SlimeMoldVolume::RENDER_MIP,      "maximum " },
+                std::pair{ SlimeMoldVolume::RENDER_EMISSION, "emission" } }) {
+            SlimeMoldVolume::Camera camera;
+            start = Clock::now();
+            for (size_t f = 0; f < volumeSteps; ++f) {
+                camera.yaw += 0.05f;
+                volume.render(image.data(), width, height, camera, render);
+            }
+            ms = elapsedMs(start);
+            std::println("volume {}^3 {}     {:8.3f} ms/frame", size, label, ms / volumeSteps);
+        }
+    }
+
+    // === View model: step and colormap (fixed agent count), in sequence and overlapped ===
+    // Same color conversions as UI
+    color::setUseLookupTables(true);
+    for (const auto& [pipelined, label] : { std::pair{ false, "frame    " }, std::pair{ true, "pipelined" } }) {
+        SlimeMoldViewModel vm(width, height);
+        vm.setPipelined(pipelined);
+        if (vm.pipelined() != pipelined)
+            continue;
+        std::vector<uint8_t> pixels(width * height * 4);
+        const auto start = Clock::now();
+        for (size_t i = 0; i < steps; ++i)
+            vm.updatePixels(pixels.data());
+        const double ms = elapsedMs(start);
+        std::println("{} {:8.3f} ms/frame {:8.1f} fps", label, ms / steps, steps * 1000.0 / ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,308 @@
+//! \file main.cpp
+//! \brief Headless parameter sweep, runs many small simulations concurrently
+//!
+//! Writes contact sheet `<out>.ppm` with one thumbnail per run (row-major, same order
+//! as in CSV) and `<out>.csv` with parameters and metrics of each run.
+
+#include "common/colors.h"
+#include "common/presets.h"
+#include "common/slime_mold_simulation.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Same ranges as sliders in UI
+struct ParamRange
+{
+    std::string_view name;
+    float AgentPreset::* member;
+    float min, max;
+};
+
+constexpr auto PARAM_RANGES = std::to_array<ParamRange>({
+    { "sensor_angle", &AgentPreset::sensor_angle, 0.0f, 2.0f  },
+    { "sensor_dist",  &AgentPreset::sensor_dist,  1.0f, 12.0f },
+    { "turn_angle",   &AgentPreset::turn_angle,   0.0f, 1.0f  },
+    { "step_size",    &AgentPreset::step_size,    0.1f, 5.0f  },
+    { "evaporate",    &AgentPreset::evaporate,    0.5f, 0.99f },
+});
+
+constexpr size_t THUMB_GAP = 2;
+constexpr size_t PALETTE_SIZE = 256;
+
+
+struct Options
+{
+    size_t width  = 160;
+    size_t height = 120;
+    size_t agents = 20000;
+    size_t steps  = 300;
+    size_t grid   = 0;      //!< values per parameter
+    size_t random = 0;      //!< number of random samples
+    size_t basePreset  = 0;
+    size_t basePalette = 0;
+    uint32_t seed = 1;
+    std::string out = "ensemble";
+};
+
+
+struct RunResult
+{
+    AgentPreset preset;
+    float mean, max;
+    float coverage;     //!< fraction of cells with value >= 1
+    float variation;    //!< stddev / mean, higher means more structure
+    double ms;
+};
+
+
+void printUsage()
+{
+    std::println(
+        "Usage: slime_mold_ensemble [options]\n"
+        "  --grid N        N values per parameter, N^5 runs (default 3)\n"
+        "  --random N      N random samples instead of grid\n"
+        "  --size WxH      field size (default 160x120)\n"
+        "  --agents N      agents per run (default 20000)\n"
+        "  --steps N       steps per run (default 300)\n"
+        "  --preset I      preset used for palette midpoint (default 0)\n"
+        "  --palette I     palette of thumbnails (default 0)\n"
+        "  --seed S        seed of agents and random samples (default 1)\n"
+        "  --out PREFIX    output file prefix (default ensemble)");
+}
+
+
+std::optional<Options> parseOptions(int argc, char* argv[])
+{
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc)
+            return std::nullopt;
+        const char* value = argv[++i];
+        const size_t n = std::strtoul(value, nullptr, 10);
+        if (arg == "--grid")
+            o.grid = n;
+        else if (arg == "--random")
+            o.random = n;
+        else if (arg == "--size") {
+            char* end = nullptr;
+            o.width = std::strtoul(value, &end, 10);
+            if (*end != 'x')
+                return std::nullopt;
+            o.height = std::strtoul(end + 1, nullptr, 10);
+        }
+        else if (arg == "--agents")
+            o.agents = n;
+        else if (arg == "--steps")
+            o.steps = n;
+        else if (arg == "--preset")
+            o.basePreset = n;
+        else if (arg == "--palette")
+            o.basePalette = n;
+        else if (arg == "--seed")
+            o.seed = static_cast<uint32_t>(n);
+        else if (arg == "--out")
+            o.out = value;
+        else
+            return std::nullopt;
+    }
+    if (o.grid == 0 && o.random == 0)
+        o.grid = 3;
+    if ((o.width * o.height) % 8 != 0 || o.width == 0 || o.height == 0)
+        return std::nullopt;
+    if (o.basePreset >= presetAgents().size() || o.basePalette >= presetPalettes().size())
+        return std::nullopt;
+    return o;
+}
+
+
+std::vector<AgentPreset> makeConfigurations(const Options& o)
+{
+    const AgentPreset base = presetAgents()[o.basePreset];
+    std::vector<AgentPreset> result;
+    if (o.random > 0) {
+        std::mt19937 rng(o.seed);
+        for (size_t i = 0; i < o.random; ++i) {
+            AgentPreset p = base;
+            for (const auto& r : PARAM_RANGES)
+                p.*r.member = std::uniform_real_distribution<float>(r.min, r.max)(rng);
+            result.push_back(p);
+        }
+        return result;
+    }
+
+    // Mixed radix counter over all parameters, first parameter changes slowest
+    size_t total = 1;
+    for (size_t i = 0; i < PARAM_RANGES.size(); ++i)
+        total *= o.grid;
+    for (size_t run = 0; run < total; ++run) {
+        AgentPreset p = base;
+        size_t rest = run;
+        for (size_t i = PARAM_RANGES.size(); i-- > 0; ) {
+            const auto& r = PARAM_RANGES[i];
+            const size_t k = rest % o.grid;
+            rest /= o.grid;
+            if (o.grid > 1)
+                p.*r.member = r.min + (r.max - r.min) * k / (o.grid - 1);
+        }
+        result.push_back(p);
+    }
+    return result;
+}
+
+
+std::vector<color::Rgb> makePalette(const Options& o)
+{
+    const auto& pal = presetPalettes()[o.basePalette].palette;
+    const size_t mid = static_cast<size_t>(presetAgents()[o.basePreset].palette_mid * PALETTE_SIZE);
+    auto result = color::gradientOkLch(pal[0], pal[1], mid);
+    const auto g2 = color::gradientOkLch(pal[1], pal[2], PALETTE_SIZE - mid);
+    result.insert(result.end(), g2.begin(), g2.end());
+    return result;
+}
+
+
+RunResult measure(const AgentPreset& preset, const float* field, size_t n)
+{
+    double sum = 0.0, sumSq = 0.0;
+    float maxValue = 0.0f;
+    size_t covered = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += field[i];
+        sumSq += field[i] * field[i];
+        maxValue = std::max(maxValue, field[i]);
+        covered += field[i] >= 1.0f;
+    }
+    const double mean = sum / n;
+    const double variance = std::max(0.0, sumSq / n - mean * mean);
+
+    RunResult r;
+    r.preset = preset;
+    r.mean = static_cast<float>(mean);
+    r.max = maxValue;
+    r.coverage = static_cast<float>(covered) / n;
+    r.variation = mean > 0.0 ? static_cast<float>(std::sqrt(variance) / mean) : 0.0f;
+    r.ms = 0.0;
+    return r;
+}
+
+
+// Colormap field into tile of contact sheet, same scale as view model
+void drawThumbnail(std::vector<uint8_t>& sheet, size_t sheetWidth, size_t x0, size_t y0,
+    const float* field, size_t width, size_t height, const std::vector<color::Rgb>& palette)
+{
+    constexpr float k = 10.0f * PALETTE_SIZE / 256.0f;
+    for (size_t y = 0; y < height; ++y) {
+        uint8_t* row = &sheet[((y0 + y) * sheetWidth + x0) * 3];
+        for (size_t x = 0; x < width; ++x) {
+            const size_t c = static_cast<size_t>(std::min(field[y * width + x] * k, PALETTE_SIZE - 1.0f));
+            row[x * 3 + 0] = static_cast<uint8_t>(palette[c].r * 255.0f);
+            row[x * 3 + 1] = static_cast<uint8_t>(palette[c].g * 255.0f);
+            row[x * 3 + 2] = static_cast<uint8_t>(palette[c].b * 255.0f);
+        }
+    }
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        printUsage();
+        return 1;
+    }
+    const Options& o = *options;
+    const auto configs = makeConfigurations(o);
+    const auto palette = makePalette(o);
+
+    // Contact sheet layout
+    const size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(configs.size()))));
+    const size_t rows = (configs.size() + columns - 1) / columns;
+    const size_t sheetWidth  = columns * (o.width + THUMB_GAP) - THUMB_GAP;
+    const size_t sheetHeight = rows * (o.height + THUMB_GAP) - THUMB_GAP;
+    std::vector<uint8_t> sheet(sheetWidth * sheetHeight * 3, 0);
+
+    std::println("{} runs, field {}x{}, {} agents, {} steps, {} threads",
+        configs.size(), o.width, o.height, o.agents, o.steps, ThreadPool::global().size());
+
+    // One task per run. Chunk of 1 lets idle threads pick next run as soon as
+    // they finish, simulations inside tasks run single threaded.
+    std::vector<RunResult> results(configs.size());
+    std::mutex printMutex;
+    size_t finished = 0;
+    const auto start = Clock::now();
+    ThreadPool::global().parallelFor(configs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t seed = o.seed + static_cast<uint32_t>(i);
+            const auto& p = configs[i];
+            const auto startRun = Clock::now();
+            SlimeMoldSimulation sim(o.width, o.height, o.agents, seed);
+            for (size_t s = 0; s < o.steps; ++s)
+                sim.step(p);
+            results[i] = measure(p, sim.data(), o.width * o.height);
+            results[i].ms = std::chrono::duration<double, std::milli>(Clock::now() - startRun).count();
+            // Tiles do not overlap, no locking needed
+            drawThumbnail(sheet, sheetWidth,
+                (i % columns) * (o.width + THUMB_GAP), (i / columns) * (o.height + THUMB_GAP),
+                sim.data(), o.width, o.height, palette);
+
+            std::lock_guard lock(printMutex);
+            ++finished;
+            std::print("\r{}/{}", finished, configs.size());
+        }
+    });
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::println("\nDone in {:.2f} s, {:.0f} runs/hour", seconds, configs.size() / seconds * 3600.0);
+
+    // === Contact sheet ===
+    {
+        std::ofstream f(o.out + ".ppm", std::ios::binary);
+        f << "P6\n" << sheetWidth << " " << sheetHeight << "\n255\n";
+        f.write(reinterpret_cast<const char*>(sheet.data()), sheet.size());
+        if (!f) {
+            std::println(stderr, "Failed to write {}.ppm", o.out);
+            return 1;
+        }
+    }
+
+    // === Metrics ===
+    {
+        std::ofstream f(o.out + ".csv");
+        f << "run,column,row";
+        for (const auto& r : PARAM_RANGES)
+            f << "," << r.name;
+        f << ",mean,max,coverage,variation,ms\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            f << i << "," << i % columns << "," << i / columns;
+            for (const auto& range : PARAM_RANGES)
+                f << "," << r.preset.*range.member;
+            f << "," << r.mean << "," << r.max << "," << r.coverage << "," << r.variation << "," << r.ms << "\n";
+        }
+        if (!f) {
+            std::println(stderr, "Failed to write {}.csv", o.out);
+            return 1;
+        }
+    }
+
+    std::println("Written {}.ppm and {}.csv", o.out, o.out);
+    return 0;
+}
@@ -0,0 +1,140 @@
+//! \file main.cpp
+//! \brief Inspects field stream written by slime_mold or slime_mold_replay
+//!
+//! Prints summary of stream, with --list also step, mean and max of every frame
+//! as CSV. Single frame selected by --frame or --step is written as PFM (float
+//! grayscale image readable by numpy, OpenCV, ImageMagick).
+
+#include "common/field_stream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    std::string path;
+    bool list = false;
+    std::optional<size_t> frame;
+    std::optional<uint64_t> step;
+    std::string out;
+};
+
+
+void printUsage()
+{
+    std::println(
+        "Usage: slime_mold_field_stream FILE [options]\n"
+        "  --list          print step, mean and max of every frame as CSV\n"
+        "  --frame I       select frame by index\n"
+        "  --step S        select first frame at or after step S\n"
+        "  --out PATH      write selected frame as PFM");
+}
+
+
+std::optional<Options> parseOptions(int argc, char* argv[])
+{
+    if (argc < 2)
+        return std::nullopt;
+    Options o;
+    o.path = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--list") {
+            o.list = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return std::nullopt;
+        const char* value = argv[++i];
+        if (arg == "--frame")
+            o.frame = std::strtoull(value, nullptr, 10);
+        else if (arg == "--step")
+            o.step = std::strtoull(value, nullptr, 10);
+        else if (arg == "--out")
+            o.out = value;
+        else
+            return std::nullopt;
+    }
+    if (!o.out.empty() && !o.frame && !o.step)
+        return std::nullopt;
+    return o;
+}
+
+
+// Little endian PFM stores rows bottom to top
+bool writePfm(const std::string& path, const float* field, size_t width, size_t height)
+{
+    std::ofstream f(path, std::ios::binary);
+    f << "Pf\n" << width << " " << height << "\n-1.0\n";
+    for (size_t y = height; y-- > 0; )
+        f.write(reinterpret_cast<const char*>(field + y * width), static_cast<std::streamsize>(width * sizeof(float)));
+    return static_cast<bool>(f);
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        printUsage();
+        return 1;
+    }
+    const Options& o = *options;
+
+    FieldStreamReader reader(o.path);
+    if (!reader.valid()) {
+        std::println(stderr, "Cannot read field stream {}", o.path);
+        return 1;
+    }
+    const size_t width = reader.width();
+    const size_t height = reader.height();
+    const size_t frames = reader.frameCount();
+    const double rawBytes = static_cast<double>(frames) * width * height * sizeof(float);
+    const auto fileBytes = std::filesystem::file_size(o.path);
+    std::println(stderr, "{}x{}, {} frames{}, {:.1f} MB, {:.1f}x smaller than raw",
+        width, height, frames,
+        frames > 0 ? std::format(" (steps {} to {})", reader.frameStep(0), reader.frameStep(frames - 1)) : "",
+        fileBytes / 1.0e6, rawBytes / std::max<uintmax_t>(fileBytes, 1));
+
+    std::vector<float> field(width * height);
+    if (o.list) {
+        // In order, so every frame is decoded once
+        std::println("step,mean,max");
+        for (size_t i = 0; i < frames; ++i) {
+            if (!reader.readFrame(i, field.data())) {
+                std::println(stderr, "Frame {} is corrupted", i);
+                return 1;
+            }
+            double sum = 0.0;
+            for (float v : field)
+                sum += v;
+            std::println("{},{},{}", reader.frameStep(i), sum / field.size(), *std::ranges::max_element(field));
+        }
+    }
+
+    if (o.frame || o.step) {
+        const size_t index = o.frame ? *o.frame : reader.findStep(*o.step);
+        if (!reader.readFrame(index, field.data())) {
+            std::println(stderr, "Cannot read frame {}", index);
+            return 1;
+        }
+        std::println(stderr, "Frame {} at step {}", index, reader.frameStep(index));
+        if (!o.out.empty() && !writePfm(o.out, field.data(), width, height)) {
+            std::println(stderr, "Failed to write {}", o.out);
+            return 1;
+        }
+    }
+    return 0;
+}
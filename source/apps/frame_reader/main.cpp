@@ -0,0 +1,70 @@
+//! \file main.cpp
+//! \brief Reads frames published by slime_mold from shared memory and reports latency
+
+#include "common/frame_server.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <print>
+#include <string>
+
+// Usage: slime_mold_frame_reader [name] [seconds]
+int main(int argc, char* argv[])
+{
+    const std::string name = argc > 1 ? argv[1] : "/slime_mold";
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    FrameSubscriber subscriber(name);
+    if (!subscriber.valid()) {
+        std::println(stderr, "Cannot open shared memory {}, is publishing enabled?", name);
+        return 1;
+    }
+    const size_t nCells = subscriber.width() * subscriber.height();
+    std::println("Reading {}x{} frames from {} for {} s", subscriber.width(), subscriber.height(), name, seconds);
+
+    uint64_t lastSequence = 0;
+    size_t frames = 0, dropped = 0, overwritten = 0;
+    double latencySumMs = 0.0, latencyMaxMs = 0.0;
+    int64_t firstNs = 0, lastNs = 0;
+    const int64_t endNs = FrameSubscriber::nowNs() + static_cast<int64_t>(seconds) * 1000000000;
+
+    FrameSubscriber::Frame frame;
+    while (FrameSubscriber::nowNs() < endNs) {
+        if (!subscriber.waitFrame(lastSequence, 1000, frame))
+            continue;
+        const double latencyMs = (FrameSubscriber::nowNs() - frame.timestampNs) / 1.0e6;
+
+        // Use data in place, this is where real consumer would blend or send it out
+        float maxValue = 0.0f;
+        if (frame.field) {
+            for (size_t i = 0; i < nCells; ++i)
+                maxValue = std::max(maxValue, frame.field[i]);
+        }
+        if (!subscriber.stillValid(frame)) {
+            ++overwritten;
+            continue;
+        }
+
+        if (lastSequence != 0)
+            dropped += frame.sequence - lastSequence - 1;
+        else
+            firstNs = frame.timestampNs;
+        lastNs = frame.timestampNs;
+        lastSequence = frame.sequence;
+        ++frames;
+        latencySumMs += latencyMs;
+        latencyMaxMs = std::max(latencyMaxMs, latencyMs);
+        (void)maxValue;
+    }
+
+    if (frames < 2) {
+        std::println("Not enough frames received");
+        return 1;
+    }
+    const double frameMs = (lastNs - firstNs) / 1.0e6 / (frames + dropped - 1);
+    const double avgMs = latencySumMs / frames;
+    std::println("{} frames, {} dropped, {} overwritten while reading", frames, dropped, overwritten);
+    std::println("Frame interval {:.3f} ms, latency avg {:.3f} ms, max {:.3f} ms", frameMs, avgMs, latencyMaxMs);
+    std::println("Latency {} one frame", latencyMaxMs < frameMs ? "stays under" : "exceeds");
+    return 0;
+}
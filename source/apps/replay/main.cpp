@@ -0,0 +1,226 @@
+//! \file main.cpp
+//! \brief Headless replay of event log recorded in UI
+
+#include "common/colors.h"
+#include "common/event_log.h"
+#include "common/field_stream.h"
+#include "common/presets.h"
+#include "common/slime_mold_simulation.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr size_t PALETTE_SIZE = 1024;
+
+void printUsage()
+{
+    std::println(
+        "Usage: slime_mold_replay LOG [options]\n"
+        "  --scale K       re-render at K times resolution, K^2 agents and K times\n"
+        "                  longer sensor distance and step (not bit-identical)\n"
+        "  --out PREFIX    write final frame to PREFIX.ppm (fixed scale, OkLCh palette)\n"
+        "  --fields PATH   write raw field stream (see field_stream.h), - is stdout\n"
+        "  --every N       steps between frames of field stream (default 10)\n"
+        "  --bits B        mantissa bits kept in field stream, 23 is lossless (default)");
+}
+
+
+// Fixed linear scale and OkLCh gradients, which are defaults of view model.
+// Tone mapping and interpolation are not in event log, frames of recordings
+// made with other settings differ from live render in colors.
+bool writeFrame(const std::string& path, const float* field, size_t width, size_t height,
+    const std::array<color::Rgb, 3>& palette, float paletteMid)
+{
+    color::setUseLookupTables(true);
+    const size_t mid = static_cast<size_t>(paletteMid * PALETTE_SIZE);
+    auto lut = color::gradientOkLch(palette[0], palette[1], mid);
+    const auto g2 = color::gradientOkLch(palette[1], palette[2], PALETTE_SIZE - mid);
+    lut.insert(lut.end(), g2.begin(), g2.end());
+
+    constexpr float k = 10.0f * PALETTE_SIZE / 256.0f;
+    std::vector<uint8_t> rgb(width * height * 3);
+    for (size_t i = 0; i < width * height; ++i) {
+        const size_t c = static_cast<size_t>(std::min(field[i] * k, PALETTE_SIZE - 1.0f));
+        rgb[i * 3 + 0] = static_cast<uint8_t>(lut[c].r * 255.0f);
+        rgb[i * 3 + 1] = static_cast<uint8_t>(lut[c].g * 255.0f);
+        rgb[i * 3 + 2] = static_cast<uint8_t>(lut[c].b * 255.0f);
+    }
+    std::ofstream f(path, std::ios::binary);
+    f << "P6\n" << width << " " << height << "\n255\n";
+    f.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+    return static_cast<bool>(f);
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    float scale = 1.0f;
+    std::string out;
+    std::string fieldsPath;
+    size_t every = 10;
+    unsigned mantissaBits = 23;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string_view arg = argv[i];
+        if (arg == "--scale")
+            scale = std::strtof(argv[i + 1], nullptr);
+        else if (arg == "--out")
+            out = argv[i + 1];
+        else if (arg == "--fields")
+            fieldsPath = argv[i + 1];
+        else if (arg == "--every")
+            every = std::max<size_t>(std::strtoul(argv[i + 1], nullptr, 10), 1);
+        else if (arg == "--bits")
+            mantissaBits = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    EventLog log;
+    if (!log.load(argv[1]) || log.events.empty() || log.events.back().type != EventLog::EVENT_END) {
+        std::println(stderr, "Cannot read complete event log {}", argv[1]);
+        return 1;
+    }
+
+    const bool rescaled = scale != 1.0f;
+    const size_t width  = static_cast<size_t>(log.width * scale);
+    const size_t height = static_cast<size_t>(log.height * scale);
+    const size_t agents = static_cast<size_t>(log.numAgents * scale * scale);
+    if (scale <= 0.0f || (width * height) % 8 != 0) {
+        std::println(stderr, "Scaled size {}x{} is not divisible by 8", width, height);
+        return 1;
+    }
+    // Progress goes to stderr when field stream is written to stdout
+    FILE* info = fieldsPath == "-" ? stderr : stdout;
+    std::println(info, "Replaying {} events, {}x{}, {} agents, seed {}",
+        log.events.size(), width, height, agents, log.seed);
+
+    std::unique_ptr<FieldStreamWriter> fields;
+    if (!fieldsPath.empty()) {
+        fields = std::make_unique<FieldStreamWriter>(fieldsPath, width, height,
+            FieldStreamWriter::FLAG_DELTA | FieldStreamWriter::FLAG_LZ, 32, mantissaBits);
+        if (!fields->valid()) {
+            std::println(stderr, "Cannot create field stream {}", fieldsPath);
+            return 1;
+        }
+    }
+
+    SlimeMoldSimulation sim(width, height, agents, log.seed);
+    // Recording started by reset with its spawn mode, constructor spawns uniformly
+    for (const auto& e : log.events) {
+        if (e.step == 0 && e.type == EventLog::EVENT_OPTION && e.option == EventLog::OPTION_SPAWN_MODE) {
+            sim.setSpawnMode(static_cast<SlimeMoldSimulation::SpawnMode>(e.value));
+            sim.reset(log.seed);
+        }
+    }
+    AgentPreset agent = presetAgents()[0];
+    std::array<color::Rgb, 3> palette = presetPalettes()[0].palette;
+    SlimeMoldSimulation::Lifecycle lifecycle;
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t next = 0;
+    uint64_t step = 0;
+    for (bool done = false; !done; ++step) {
+        for (; next < log.events.size() && log.events[next].step == step; ++next) {
+            const auto& e = log.events[next];
+            switch (e.type) {
+            case EventLog::EVENT_AGENT:
+                agent = e.agent;
+                agent.sensor_dist *= scale;
+                agent.step_size *= scale;
+                break;
+            case EventLog::EVENT_PALETTE:
+                palette = e.palette;
+                break;
+            case EventLog::EVENT_RESET:
+                sim.reset();
+                break;
+            case EventLog::EVENT_RESET_AGENTS:
+                sim.resetAgents();
+                break;
+            case EventLog::EVENT_OPTION:
+                switch (e.option) {
+                case EventLog::OPTION_SAMPLING:
+                    sim.setSampling(static_cast<SlimeMoldSimulation::Sampling>(e.value));
+                    break;
+                case EventLog::OPTION_LIFECYCLE:
+                    lifecycle.enabled = e.value != 0;
+                    break;
+                case EventLog::OPTION_MAX_AGE:
+                    lifecycle.maxAge = e.value;
+                    break;
+                case EventLog::OPTION_SPAWN_THRESHOLD:
+                    lifecycle.spawnThreshold = std::bit_cast<float>(e.value);
+                    break;
+                case EventLog::OPTION_SPAWN_MODE:
+                    sim.setSpawnMode(static_cast<SlimeMoldSimulation::SpawnMode>(e.value));
+                    break;
+                case EventLog::OPTION_AGENT_FORMAT:
+                    sim.setAgentFormat(static_cast<SlimeMoldSimulation::AgentFormat>(e.value));
+                    break;
+                case EventLog::OPTION_SENSOR_PYRAMID:
+                    sim.setSensorPyramid(e.value != 0);
+                    break;
+                case EventLog::OPTION_BOUNDARY:
+                    sim.setBoundary(static_cast<SlimeMoldSimulation::Boundary>(e.value));
+                    break;
+                }
+                sim.setLifecycle(lifecycle);
+                break;
+            case EventLog::EVENT_END:
+                done = true;
+                break;
+            }
+        }
+        if (!done) {
+            sim.step(agent);
+            if (fields && (step + 1) % every == 0)
+                fields->write(step + 1, sim.data());
+        }
+    }
+    --step;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::println(info, "{} steps in {:.2f} s ({:.0f} steps/s)", step, seconds, step / seconds);
+
+    if (fields) {
+        if (!fields->close()) {
+            std::println(stderr, "Failed to write field stream {}", fieldsPath);
+            return 1;
+        }
+        const double rawBytes = static_cast<double>(fields->frames()) * width * height * sizeof(float);
+        std::println(info, "Field stream: {} frames, {:.1f} MB, {:.1f}x smaller than raw",
+            fields->frames(), fields->bytes() / 1.0e6, rawBytes / std::max<uint64_t>(fields->bytes(), 1));
+    }
+
+    const uint64_t hash = EventLog::fieldHash(sim.data(), width * height);
+    if (!rescaled) {
+        const bool same = hash == log.events.back().fieldHash;
+        std::println(info, "Field hash {:016x}, {}", hash, same ? "bit-identical to recording" : "DIFFERS from recording");
+        if (!same)
+            return 2;
+    }
+
+    if (!out.empty() && !writeFrame(out + ".ppm", sim.data(), width, height, palette, agent.palette_mid)) {
+        std::println(stderr, "Failed to write {}.ppm", out);
+        return 1;
+    }
+    return 0;
+}
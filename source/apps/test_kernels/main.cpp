@@ -0,0 +1,526 @@
+//! \file main.cpp
+//! \brief Checks SIMD kernels against scalar reference kernels
+//!
+//! Runs simulation, colormap and volume cases with SIMD and scalar kernels and
+//! compares results, see comments of check functions. Cases are random, seed
+//! and counts are set by command line.
+//! Exit code is 1 if any check fails. In builds without SIMD both sides run
+//! scalar code, so it only checks determinism.
+
+#include "common/colormap.h"
+#include "common/input_map.h"
+#include "common/presets.h"
+#include "common/slime_mold_simulation.h"
+#include "common/slime_mold_volume.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    size_t cases = 200;
+    size_t steps = 50;
+    uint32_t seed = 1;
+    float tolerance = 0.0f;     //!< max absolute difference, 0 means bit-identical
+};
+
+
+struct Case
+{
+    size_t width, height, agents, activeAgents;
+    uint32_t seed;
+    AgentPreset preset;
+    SlimeMoldSimulation::Sampling sampling;
+    SlimeMoldSimulation::Boundary boundary;
+    SlimeMoldSimulation::SpawnMode spawnMode;
+    SlimeMoldSimulation::AgentFormat agentFormat;
+    bool sensorPyramid;
+    SlimeMoldSimulation::Lifecycle lifecycle;
+    InputMap inputs;
+};
+
+
+constexpr size_t MAX_SIZE = 96;
+constexpr size_t MAX_AGENTS = 10000;    // more than one agent chunk of thread pool
+constexpr size_t COLORMAP_CASES = 100;
+constexpr size_t SCALER_CASES = 100;
+constexpr size_t THREAD_CASES = 20;
+constexpr size_t VOLUME_CASES = 20;
+constexpr size_t MAX_VOLUME_BRICKS = 6;     // per axis
+constexpr std::array<size_t, 3> THREAD_COUNTS = { 1, 8, 64 };
+
+
+void printUsage()
+{
+    std::println(
+        "Usage: test_kernels [options]\n"
+        "  --cases N       number of random simulation cases (default 200)\n"
+        "  --steps N       steps per case (default 50)\n"
+        "  --seed S        seed of cases (default 1)\n"
+        "  --tolerance T   allowed absolute difference of field values (default 0)");
+}
+
+
+std::optional<Options> parseOptions(int argc, char* argv[])
+{
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc)
+            return std::nullopt;
+        const char* value = argv[++i];
+        if (arg == "--cases")
+            o.cases = std::strtoul(value, nullptr, 10);
+        else if (arg == "--steps")
+            o.steps = std::strtoul(value, nullptr, 10);
+        else if (arg == "--seed")
+            o.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--tolerance")
+            o.tolerance = std::strtof(value, nullptr);
+        else
+            return std::nullopt;
+    }
+    return o;
+}
+
+
+// Sizes which are not multiples of 8, agent counts leaving SIMD tails, sensors
+// reaching over edges (negative coordinates and wrap), all spawn modes, both
+// samplings and agent formats, all boundaries, sensor pyramid, input maps
+// and lifecycle
+Case makeCase(std::mt19937& rng)
+{
+    auto uniform = [&](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); };
+    auto below = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+
+    Case c;
+    // Any width, height is adjusted so that cell count is multiple of 8
+    c.width = 8 + below(MAX_SIZE - 8);
+    c.height = 8 + below(MAX_SIZE - 8);
+    while (c.width * c.height % 8 != 0)
+        ++c.height;
+    c.agents = 1 + below(MAX_AGENTS);
+    c.activeAgents = below(4) == 0 ? 1 + below(c.agents) : c.agents;
+    c.seed = rng() | 1;
+
+    // Same ranges as sliders in UI, sensors must stay within one wrap of field
+    c.sensorPyramid = below(3) == 0;
+    const float maxDist = std::min(c.sensorPyramid ? 48.0f : 12.0f, static_cast<float>(std::min(c.width, c.height) - 1));
+    c.preset = presetAgents()[below(presetAgents().size())];
+    c.preset.sensor_angle = uniform(0.0f, 2.0f);
+    c.preset.sensor_dist  = uniform(1.0f, maxDist);
+    c.preset.turn_angle   = uniform(0.0f, 1.0f);
+    c.preset.step_size    = uniform(0.1f, 5.0f);
+    c.preset.evaporate    = uniform(0.5f, 0.99f);
+
+    c.sampling = below(2) ? SlimeMoldSimulation::SAMPLING_BILINEAR : SlimeMoldSimulation::SAMPLING_NEAREST;
+    c.boundary = static_cast<SlimeMoldSimulation::Boundary>(below(SlimeMoldSimulation::BOUNDARY_END));
+    c.spawnMode = static_cast<SlimeMoldSimulation::SpawnMode>(below(SlimeMoldSimulation::SPAWN_END));
+    c.agentFormat = below(2) ? SlimeMoldSimulation::AGENTS_COMPACT : SlimeMoldSimulation::AGENTS_FLOAT;
+    c.lifecycle.enabled = below(4) == 0;
+    c.lifecycle.maxAge = static_cast<uint32_t>(below(100));
+    c.lifecycle.spawnThreshold = uniform(0.5f, 10.0f);
+
+    if (below(3) == 0 || c.spawnMode == SlimeMoldSimulation::SPAWN_IMAGE) {
+        c.inputs.width = c.width;
+        c.inputs.height = c.height;
+        const size_t n = c.width * c.height;
+        if (below(2)) {
+            c.inputs.obstacles.assign((n + 63) / 64, 0);
+            for (size_t i = 0; i < n; ++i) {
+                if (below(10) == 0)
+                    c.inputs.setObstacle(i);
+            }
+        }
+        if (below(2) || c.spawnMode == SlimeMoldSimulation::SPAWN_IMAGE) {
+            c.inputs.attractors.resize(n);
+            for (auto& a : c.inputs.attractors)
+                a = below(3) ? 0 : static_cast<uint8_t>(rng());
+            c.inputs.attractorStrength = uniform(-2.0f, 5.0f);
+        }
+    }
+    return c;
+}
+
+
+std::string describe(const Case& c)
+{
+    constexpr std::array<const char*, SlimeMoldSimulation::BOUNDARY_END> BOUNDARIES = { "wrap", "reflect", "absorb" };
+    return std::format("{}x{}, {}/{} {} agents, {}, {}, spawn {}{}{}{}",
+        c.width, c.height, c.activeAgents, c.agents,
+        c.agentFormat == SlimeMoldSimulation::AGENTS_COMPACT ? "compact" : "float",
+        c.sampling == SlimeMoldSimulation::SAMPLING_BILINEAR ? "bilinear" : "nearest",
+        BOUNDARIES[c.boundary],
+        static_cast<int>(c.spawnMode),
+        c.inputs.hasObstacles() || c.inputs.hasAttractors() ? ", inputs" : "",
+        c.lifecycle.enabled ? ", lifecycle" : "",
+        c.sensorPyramid ? std::format(", pyramid, sensors {:.1f}", c.preset.sensor_dist) : "");
+}
+
+
+void configure(SlimeMoldSimulation& sim, const Case& c, SlimeMoldSimulation::Kernels kernels)
+{
+    sim.setKernels(kernels);
+    sim.setInputMap(c.inputs);
+    sim.setSampling(c.sampling);
+    sim.setBoundary(c.boundary);
+    sim.setSpawnMode(c.spawnMode);
+    sim.setAgentFormat(c.agentFormat);
+    sim.setSensorPyramid(c.sensorPyramid);
+    sim.setActiveAgents(c.activeAgents);
+    // Agents spawned again, constructor used SIMD kernels and uniform spawn
+    sim.reset(c.seed);
+    sim.setLifecycle(c.lifecycle);
+}
+
+
+// Returns empty string if fields match
+std::string compareFields(const float* simd, const float* scalar, const Case& c, float tolerance)
+{
+    for (size_t i = 0; i < c.width * c.height; ++i) {
+        if (std::bit_cast<uint32_t>(simd[i]) == std::bit_cast<uint32_t>(scalar[i]))
+            continue;
+        // NaN fails too
+        if (!(std::abs(simd[i] - scalar[i]) <= tolerance))
+            return std::format("cell ({}, {}) {} vs {}", i % c.width, i / c.width, simd[i], scalar[i]);
+    }
+    return {};
+}
+
+
+// Two simulations with same seed, preset and inputs, one with SIMD kernels and
+// one with scalar ones, fields are compared after every step
+bool checkSimulation(const Case& c, size_t steps, float tolerance)
+{
+    SlimeMoldSimulation simd(c.width, c.height, c.agents, c.seed);
+    SlimeMoldSimulation scalar(c.width, c.height, c.agents, c.seed);
+    configure(simd, c, SlimeMoldSimulation::KERNELS_SIMD);
+    configure(scalar, c, SlimeMoldSimulation::KERNELS_SCALAR);
+
+    for (size_t s = 0; s < steps; ++s) {
+        // Spawn kernels again on field with trail
+        if (s == steps / 2) {
+            simd.resetAgents();
+            scalar.resetAgents();
+        }
+        simd.step(c.preset);
+        scalar.step(c.preset);
+        if (simd.activeAgents() != scalar.activeAgents()) {
+            std::println("\rFAIL {}: step {}, {} agents with simd, {} with scalar",
+                describe(c), s, simd.activeAgents(), scalar.activeAgents());
+            return false;
+        }
+        const auto error = compareFields(simd.data(), scalar.data(), c, tolerance);
+        if (!error.empty()) {
+            std::println("\rFAIL {}: step {}, {}", describe(c), s, error);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Same case on pools of THREAD_COUNTS threads, fields after last step must be bit-identical
+bool checkThreads(const Case& c, size_t steps)
+{
+    std::vector<float> reference;
+    size_t referenceAgents = 0;
+    bool passed = true;
+    for (size_t threads : THREAD_COUNTS) {
+        ThreadPool::global().resize(threads);
+        SlimeMoldSimulation sim(c.width, c.height, c.agents, c.seed);
+        configure(sim, c, SlimeMoldSimulation::KERNELS_SIMD);
+        for (size_t s = 0; s < steps; ++s) {
+            if (s == steps / 2)
+                sim.resetAgents();
+            sim.step(c.preset);
+        }
+        if (reference.empty()) {
+            reference.assign(sim.data(), sim.data() + c.width * c.height);
+            referenceAgents = sim.activeAgents();
+            continue;
+        }
+        if (sim.activeAgents() != referenceAgents) {
+            std::println("\rFAIL {}: {} agents on {} threads, {} on {}",
+                describe(c), sim.activeAgents(), threads, referenceAgents, THREAD_COUNTS[0]);
+            passed = false;
+            break;
+        }
+        const auto error = compareFields(sim.data(), reference.data(), c, 0.0f);
+        if (!error.empty()) {
+            std::println("\rFAIL {}: {} threads against {}, {}", describe(c), threads, THREAD_COUNTS[0], error);
+            passed = false;
+            break;
+        }
+    }
+    ThreadPool::global().resize(0);
+    return passed;
+}
+
+
+// Values around index boundaries, where rounding and truncation differ
+bool checkColormap(std::mt19937& rng)
+{
+    using colormap::PALETTE_SIZE;
+    const size_t count = 8 * (1 + rng() % 512);
+    const float scale = std::uniform_real_distribution<float>(0.5f, 100.0f)(rng);
+    std::vector<float> field(count);
+    for (auto& v : field) {
+        const float index = static_cast<float>(rng() % (PALETTE_SIZE + 64));
+        switch (rng() % 6) {
+        case 0: v = 0.0f; break;
+        case 1: v = index / scale; break;
+        case 2: v = (index + 0.5f) / scale; break;
+        case 3: v = std::nextafter((index + 1.0f) / scale, 0.0f); break;
+        case 4: v = std::numeric_limits<float>::denorm_min(); break;
+        default: v = std::uniform_real_distribution<float>(0.0f, 1e6f)(rng); break;
+        }
+    }
+    std::vector<uint8_t> lut(PALETTE_SIZE * 4);
+    for (auto& b : lut)
+        b = static_cast<uint8_t>(rng());
+
+    std::vector<uint8_t> pixelsSimd(count * 4), pixelsScalar(count * 4);
+    colormap::Stats statsSimd, statsScalar;
+    colormap::apply(field.data(), pixelsSimd.data(), count, lut.data(), scale, statsSimd,
+        SlimeMoldSimulation::KERNELS_SIMD);
+    colormap::apply(field.data(), pixelsScalar.data(), count, lut.data(), scale, statsScalar,
+        SlimeMoldSimulation::KERNELS_SCALAR);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (std::memcmp(&pixelsSimd[i * 4], &pixelsScalar[i * 4], 4) != 0) {
+            std::println("\rFAIL colormap: {} values, scale {}, value {} at {} maps to different color",
+                count, scale, field[i], i);
+            return false;
+        }
+    }
+    // Sum is accumulated in float lanes by SIMD kernels
+    const double sumError = std::abs(statsSimd.sum - statsScalar.sum) / std::max(statsScalar.sum, 1.0);
+    if (statsSimd.hist != statsScalar.hist || statsSimd.max != statsScalar.max || sumError > 1e-4) {
+        std::println("\rFAIL colormap: {} values, scale {}, stats differ (max {} vs {}, sum {} vs {})",
+            count, scale, statsSimd.max, statsScalar.max, statsSimd.sum, statsScalar.sum);
+        return false;
+    }
+    return true;
+}
+
+
+
+// Scaled colormap of random field, SIMD in random row ranges against scalar in one
+bool checkScaler(std::mt19937& rng)
+{
+    using colormap::PALETTE_SIZE;
+    auto below = [&](size_t n) { return rng() % n; };
+    const size_t srcWidth = 1 + below(MAX_SIZE), srcHeight = 1 + below(MAX_SIZE);
+    const size_t dstWidth = 1 + below(3 * MAX_SIZE), dstHeight = 1 + below(3 * MAX_SIZE);
+    const auto filter = static_cast<colormap::Filter>(below(colormap::FILTER_END));
+    const float scale = std::uniform_real_distribution<float>(0.5f, 100.0f)(rng);
+    std::vector<float> field(srcWidth * srcHeight);
+    for (auto& v : field)
+        v = below(4) ? 0.0f : std::uniform_real_distribution<float>(0.0f, 2.0f * PALETTE_SIZE / scale)(rng);
+    std::vector<uint8_t> lut(PALETTE_SIZE * 4);
+    for (auto& b : lut)
+        b = static_cast<uint8_t>(rng());
+
+    const colormap::Scaler scaler = colormap::makeScaler(srcWidth, srcHeight, dstWidth, dstHeight, filter);
+    std::vector<uint8_t> pixelsSimd(dstWidth * dstHeight * 4), pixelsScalar(dstWidth * dstHeight * 4);
+    colormap::Stats statsSimd, statsScalar;
+    for (size_t begin = 0; begin < dstHeight;) {
+        const size_t end = std::min(dstHeight, begin + 1 + below(dstHeight));
+        colormap::Stats stats;
+        colormap::applyScaled(scaler, field.data(), pixelsSimd.data(), begin, end, lut.data(), scale, stats,
+            SlimeMoldSimulation::KERNELS_SIMD);
+        statsSimd.max = std::max(statsSimd.max, stats.max);
+        for (size_t b = 0; b < colormap::HIST_BINS; ++b)
+            statsSimd.hist[b] += stats.hist[b];
+        begin = end;
+    }
+    colormap::applyScaled(scaler, field.data(), pixelsScalar.data(), 0, dstHeight, lut.data(), scale, statsScalar,
+        SlimeMoldSimulation::KERNELS_SCALAR);
+
+    const char* filterName = filter == colormap::FILTER_LANCZOS ? "lanczos"
+        : filter == colormap::FILTER_BILINEAR ? "bilinear" : "nearest";
+    if (pixelsSimd != pixelsScalar) {
+        std::println("\rFAIL scaler: {}x{} to {}x{} {}, pixels differ", srcWidth, srcHeight, dstWidth, dstHeight, filterName);
+        return false;
+    }
+    if (statsSimd.hist != statsScalar.hist || statsSimd.max != statsScalar.max) {
+        std::println("\rFAIL scaler: {}x{} to {}x{} {}, stats differ (max {} vs {})",
+            srcWidth, srcHeight, dstWidth, dstHeight, filterName, statsSimd.max, statsScalar.max);
+        return false;
+    }
+    return true;
+}
+
+
+// Volume stepped and rendered with SIMD and scalar kernels, then stepped with SIMD
+// on pools of THREAD_COUNTS threads, volumes and images must be bit-identical
+bool checkVolume(std::mt19937& rng, size_t steps)
+{
+    auto uniform = [&](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); };
+    auto below = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    const size_t width = SlimeMoldVolume::BRICK_SIZE * (1 + below(MAX_VOLUME_BRICKS));
+    const size_t height = SlimeMoldVolume::BRICK_SIZE * (1 + below(MAX_VOLUME_BRICKS));
+    const size_t depth = SlimeMoldVolume::BRICK_SIZE * (1 + below(MAX_VOLUME_BRICKS));
+    const size_t agents = 1 + below(MAX_AGENTS);
+    const uint32_t seed = rng() | 1;
+    AgentPreset preset = presetAgents()[below(presetAgents().size())];
+    preset.sensor_angle = uniform(0.0f, 2.0f);
+    preset.sensor_dist  = uniform(1.0f, 12.0f);
+    preset.turn_angle   = uniform(0.0f, 1.0f);
+    preset.step_size    = uniform(0.1f, 5.0f);
+    preset.evaporate    = uniform(0.5f, 0.99f);
+    SlimeMoldVolume::Camera camera;
+    camera.yaw = uniform(-4.0f, 4.0f);
+    camera.pitch = uniform(-1.5f, 1.5f);
+    camera.zoom = uniform(0.5f, 3.0f);
+    const size_t imageWidth = 1 + below(MAX_SIZE), imageHeight = 1 + below(MAX_SIZE);
+    const std::string label = std::format("volume {}x{}x{}, {} agents", width, height, depth, agents);
+
+    auto voxels = [&](const SlimeMoldVolume& v) {
+        std::vector<float> out;
+        out.reserve(width * height * depth);
+        for (size_t z = 0; z < depth; ++z)
+            for (size_t y = 0; y < height; ++y)
+                for (size_t x = 0; x < width; ++x)
+                    out.push_back(v.voxel(x, y, z));
+        return out;
+    };
+    auto images = [&](const SlimeMoldVolume& v) {
+        std::vector<float> out(imageWidth * imageHeight * SlimeMoldVolume::RENDER_END);
+        for (size_t r = 0; r < SlimeMoldVolume::RENDER_END; ++r)
+            v.render(out.data() + r * imageWidth * imageHeight, imageWidth, imageHeight, camera,
+                static_cast<SlimeMoldVolume::Render>(r));
+        return out;
+    };
+    auto same = [](const std::vector<float>& a, const std::vector<float>& b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+    };
+
+    SlimeMoldVolume simd(width, height, depth, agents, seed);
+    SlimeMoldVolume scalar(width, height, depth, agents, seed);
+    scalar.setKernels(SlimeMoldSimulation::KERNELS_SCALAR);
+    for (size_t s = 0; s < steps; ++s) {
+        simd.step(preset);
+        scalar.step(preset);
+        if (!same(voxels(simd), voxels(scalar))) {
+            std::println("\rFAIL {}: step {}, volumes differ", label, s);
+            return false;
+        }
+    }
+    const std::vector<float> reference = images(simd);
+    if (!same(reference, images(scalar))) {
+        std::println("\rFAIL {}: {}x{} images differ", label, imageWidth, imageHeight);
+        return false;
+    }
+
+    bool passed = true;
+    for (size_t threads : THREAD_COUNTS) {
+        ThreadPool::global().resize(threads);
+        SlimeMoldVolume volume(width, height, depth, agents, seed);
+        for (size_t s = 0; s < steps; ++s)
+            volume.step(preset);
+        if (!same(voxels(volume), voxels(simd)) || !same(images(volume), reference)) {
+            std::println("\rFAIL {}: {} threads differ", label, threads);
+            passed = false;
+            break;
+        }
+    }
+    ThreadPool::global().resize(0);
+    return passed;
+}
+
+
+// Agents spawned again when lifecycle is disabled after die-off must spread over
+// field, stale slots of dead agents would pile up in one cell
+bool checkLifecycleRevival(SlimeMoldSimulation::AgentFormat format)
+{
+    constexpr size_t SIZE = 64, AGENTS = 1000, STEPS = 50;
+    SlimeMoldSimulation sim(SIZE, SIZE, AGENTS, 1);
+    sim.setAgentFormat(format);
+    SlimeMoldSimulation::Lifecycle lifecycle;
+    lifecycle.enabled = true;
+    lifecycle.energyCost = 10.0f;
+    sim.setLifecycle(lifecycle);
+    sim.step(presetAgents()[0]);
+    const size_t survivors = sim.activeAgents();
+    lifecycle.enabled = false;
+    sim.setLifecycle(lifecycle);
+    for (size_t s = 0; s < STEPS; ++s)
+        sim.step(presetAgents()[0]);
+    double sum = 0.0;
+    float max = 0.0f;
+    for (size_t i = 0; i < SIZE * SIZE; ++i) {
+        sum += sim.data()[i];
+        max = std::max(max, sim.data()[i]);
+    }
+    if (sim.activeAgents() != AGENTS || max > 0.1 * sum) {
+        std::println("\rFAIL lifecycle revival ({}): {} survivors, {} agents after disabling, brightest cell has {:.1f} % of trail",
+            format == SlimeMoldSimulation::AGENTS_COMPACT ? "compact" : "float", survivors, sim.activeAgents(),
+            sum > 0.0 ? 100.0 * max / sum : 0.0);
+        return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        printUsage();
+        return 1;
+    }
+    const Options& o = *options;
+
+    size_t failed = 0;
+    std::mt19937 rng(o.seed);
+    for (size_t i = 0; i < COLORMAP_CASES; ++i)
+        failed += !checkColormap(rng);
+    std::println("Colormap: {} of {} cases passed", COLORMAP_CASES - failed, COLORMAP_CASES);
+
+    size_t failedScaler = 0;
+    for (size_t i = 0; i < SCALER_CASES; ++i)
+        failedScaler += !checkScaler(rng);
+    std::println("Scaler: {} of {} cases passed", SCALER_CASES - failedScaler, SCALER_CASES);
+
+    size_t failedSim = 0;
+    for (size_t i = 0; i < o.cases; ++i) {
+        const Case c = makeCase(rng);
+        failedSim += !checkSimulation(c, o.steps, o.tolerance);
+        std::print("\r{}/{}", i + 1, o.cases);
+    }
+    std::println("\nSimulation: {} of {} cases passed, {} steps each", o.cases - failedSim, o.cases, o.steps);
+
+    size_t failedThreads = 0;
+    for (size_t i = 0; i < THREAD_CASES; ++i)
+        failedThreads += !checkThreads(makeCase(rng), o.steps);
+    std::println("Threads: {} of {} cases passed", THREAD_CASES - failedThreads, THREAD_CASES);
+
+    const size_t failedRevival = !checkLifecycleRevival(SlimeMoldSimulation::AGENTS_FLOAT)
+        + !checkLifecycleRevival(SlimeMoldSimulation::AGENTS_COMPACT);
+    std::println("Lifecycle revival: {} of 2 cases passed", 2 - failedRevival);
+
+    size_t failedVolume = 0;
+    for (size_t i = 0; i < VOLUME_CASES; ++i)
+        failedVolume += !checkVolume(rng, o.steps);
+    std::println("Volume: {} of {} cases passed", VOLUME_CASES - failedVolume, VOLUME_CASES);
+    return failed + failedScaler + failedSim + failedThreads + failedRevival + failedVolume == 0 ? 0 : 1;
+}
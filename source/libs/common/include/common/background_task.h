@@ -0,0 +1,32 @@
+//! \file background_task.h
+//! \brief Worker thread running one task at a time, used to overlap pipeline stages
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+class BackgroundTask final
+{
+public:
+    using Function = std::function<void()>;
+
+    BackgroundTask();
+
+    //! \brief Waits for running task
+    ~BackgroundTask();
+
+    //! \brief Runs `fn` on worker thread, waits for previous task first
+    //! NOTE: Emscripten build without pthreads runs `fn` on caller thread.
+    void start(Function fn);
+
+    //! \brief Blocks until task started last is done, returns immediately if there is none
+    void wait();
+
+    //! \brief False when tasks run on caller thread, so there is nothing to overlap
+    [[nodiscard]] static bool concurrent() noexcept;
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
@@ -0,0 +1,74 @@
+//! \file colormap.h
+//! \brief Field to pixels kernel of view model
+//!
+//! Field values are scaled, clamped and truncated to index of palette LUT with
+//! PALETTE_SIZE entries in pixel format (4 bytes each). Statistics used by tone
+//! mapping are gathered in the same pass.
+//!
+//! Display of other size than field is resampled in the same pass too: field
+//! values are interpolated first and colormapped after, so palette does not
+//! blur and no display sized float image is stored.
+
+#pragma once
+
+#include "common/slime_mold_simulation.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace colormap {
+
+constexpr size_t PALETTE_SIZE = 1024;
+
+//! Histogram of palette indices
+constexpr size_t HIST_BINS = 64;
+constexpr size_t HIST_SHIFT = 4;     // PALETTE_SIZE / HIST_BINS == 1 << HIST_SHIFT
+static_assert(PALETTE_SIZE == HIST_BINS << HIST_SHIFT);
+
+struct Stats {
+    float max = 0.0f;
+    double sum = 0.0;
+    std::array<uint32_t, HIST_BINS> hist{};
+};
+
+//! \brief Colormaps `count` values of field into pixels and sets stats
+//! \param count must be multiple of 8 (AVX2 width)
+//! Pixels and histogram do not depend on kernels, sum may differ in rounding.
+void apply(const float* field, uint8_t* pixels, size_t count, const uint8_t* lut, float scale, Stats& stats,
+    SlimeMoldSimulation::Kernels kernels = SlimeMoldSimulation::KERNELS_SIMD);
+
+//! Resampling filter of scaled colormap
+enum Filter {
+    FILTER_NEAREST,     //!< blocky upscaling, drops cells on downscaling
+    FILTER_BILINEAR,    //!< triangle filter, widened to average cells on downscaling
+    FILTER_LANCZOS,     //!< Lanczos with 3 lobes, sharpest, widened on downscaling
+    FILTER_END
+};
+
+//! Taps of separable resampling from field to display, built once per size.
+//! Every display pixel is weighted sum of `taps` cells along each axis, cells
+//! past edges repeat edge ones. Weights sum to 1.
+struct Scaler {
+    size_t srcWidth = 0, srcHeight = 0;
+    size_t dstWidth = 0, dstHeight = 0;
+    size_t stride = 0;              //!< dstWidth rounded up to 8, padding taps have weight 0
+    size_t tapsX = 0, tapsY = 0;
+    std::vector<int32_t> indexX;    //!< source column, tap-major [tap * stride + x]
+    std::vector<float> weightX;
+    std::vector<int32_t> indexY;    //!< source row, [y * tapsY + tap]
+    std::vector<float> weightY;
+};
+
+Scaler makeScaler(size_t srcWidth, size_t srcHeight, size_t dstWidth, size_t dstHeight, Filter filter);
+
+//! \brief Colormaps rows [rowBegin, rowEnd) of display scaled from field and sets their stats
+//! \param pixels row 0 of display, dstWidth pixels per row
+//! Stats are of scaled values (negative Lanczos ringing is clamped to 0).
+//! Pixels and histogram do not depend on kernels nor on split into row ranges.
+void applyScaled(const Scaler& scaler, const float* field, uint8_t* pixels, size_t rowBegin, size_t rowEnd,
+    const uint8_t* lut, float scale, Stats& stats,
+    SlimeMoldSimulation::Kernels kernels = SlimeMoldSimulation::KERNELS_SIMD);
+
+} // namespace colormap
@@ -53,6 +53,16 @@ namespace color {
 
     // ==== Gradient Functions ============================================
 
+    //! Color space of gradient interpolation
+    enum Interpolation {
+        INTERP_RGB,
+        INTERP_CIELAB,
+        INTERP_CIELCH,
+        INTERP_OKLAB,
+        INTERP_OKLCH,
+        INTERP_END
+    };
+
     using GradientFunction = std::vector<Rgb>(*)(const Rgb&, const Rgb&, std::size_t);
 
     extern std::vector<Rgb> gradientRgb   (const Rgb& startRgb, const Rgb& endRgb, std::size_t length);
@@ -61,4 +71,19 @@ namespace color {
     extern std::vector<Rgb> gradientOkLab (const Rgb& startRgb, const Rgb& endRgb, std::size_t length);
     extern std::vector<Rgb> gradientOkLch (const Rgb& startRgb, const Rgb& endRgb, std::size_t length);
 
+    // ==== Lookup Tables =================================================
+
+    // NOTE: When enabled, sRGB<->linear conversions use precomputed 1D tables
+    //       and OkLab->RGB uses 3D LUT with trilinear lookup. Error is within
+    //       one step of 8-bit quantization. Disabled by default.
+    extern void setUseLookupTables(bool enable);
+    extern bool useLookupTables();
+
+    // ==== Gradient Cache ================================================
+
+    //! \brief Returns gradient generated by `gradientFn`, reusing recently generated ones
+    //! Cache is small, thread-safe and keeps least recently used gradients.
+    extern std::vector<Rgb> gradientCached(GradientFunction gradientFn, const Rgb& startRgb, const Rgb& endRgb, std::size_t length);
+    extern void clearGradientCache();
+
 } // namespace color
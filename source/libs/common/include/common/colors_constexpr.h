@@ -0,0 +1,398 @@
+//! \file colors_constexpr.h
+//! \brief Color conversions and gradients usable in constant expressions
+//!
+//! Mirrors exact (table free) conversions of colors.cpp, computed in double.
+//! Standard math functions are not constexpr, so pow, cbrt, sin, cos and atan2
+//! are evaluated by range reduction and series, accurate to about 1e-15. Meant
+//! for baking tables at compile time (see presetGradient in presets.h), too slow
+//! for runtime use.
+
+#pragma once
+
+#include "common/colors.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace color::ct {
+
+    // ==== Math ==========================================================
+
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double LN2 = 0.69314718055994530942;
+
+
+    // x * 2^e
+    constexpr double scale2(double x, int e)
+    {
+        for (; e > 0; --e)
+            x *= 2.0;
+        for (; e < 0; ++e)
+            x *= 0.5;
+        return x;
+    }
+
+
+    // e^r by Taylor series
+    constexpr double expSeries(double r, int terms)
+    {
+        double term = 1.0, sum = 1.0;
+        for (int n = 1; n < terms; ++n) {
+            term *= r / n;
+            sum += term;
+        }
+        return sum;
+    }
+
+
+    // 2 atanh(s) = log((1 + s) / (1 - s)) by series
+    constexpr double atanhSeries2(double s, int terms)
+    {
+        const double s2 = s * s;
+        double term = s, sum = 0.0;
+        for (int n = 1; n < 2 * terms; n += 2) {
+            sum += term / n;
+            term *= s2;
+        }
+        return 2.0 * sum;
+    }
+
+
+    // Tables for range reduction, evaluated once by slow series, so each
+    // exp and log needs only few terms. Keeps baking of gradients fast.
+    constexpr int TABLE_STEPS = 16;
+
+    // 2^(j / 16)
+    constexpr std::array<double, TABLE_STEPS> EXP2_TABLE = [] {
+        std::array<double, TABLE_STEPS> table{};
+        for (int j = 0; j < TABLE_STEPS; ++j)
+            table[j] = expSeries(j * LN2 / TABLE_STEPS, 30);
+        return table;
+    }();
+
+    // log(1 + j / 16)
+    constexpr std::array<double, TABLE_STEPS> LOG_TABLE = [] {
+        std::array<double, TABLE_STEPS> table{};
+        for (int j = 0; j < TABLE_STEPS; ++j) {
+            const double x = 1.0 + static_cast<double>(j) / TABLE_STEPS;
+            table[j] = atanhSeries2((x - 1.0) / (x + 1.0), 40);
+        }
+        return table;
+    }();
+
+
+    constexpr double exp(double x)
+    {
+        // x = (16 k + j) ln(2) / 16 + r, |r| <= ln(2) / 32, Taylor series to r^8 / 8!
+        const int i = static_cast<int>(x * TABLE_STEPS / LN2 + (x < 0.0 ? -0.5 : 0.5));
+        const double r = x - i * (LN2 / TABLE_STEPS);
+        const int j = (i % TABLE_STEPS + TABLE_STEPS) % TABLE_STEPS;
+        const double series = 1.0 + r * (1.0 + r / 2.0 * (1.0 + r / 3.0 * (1.0 + r / 4.0 * (1.0 + r / 5.0 * (1.0 + r / 6.0 * (1.0 + r / 7.0 * (1.0 + r / 8.0)))))));
+        return scale2(EXP2_TABLE[j] * series, (i - j) / TABLE_STEPS);
+    }
+
+
+    //! x > 0
+    constexpr double log(double x)
+    {
+        int e = 0;
+        for (; x >= 2.0; x *= 0.5)
+            ++e;
+        for (; x < 1.0; x *= 2.0)
+            --e;
+        // x = (1 + j / 16) y, 1 <= y < 1 + 1 / 16, log(y) = 2 atanh(t), |t| < 0.031, series to t^11 / 11
+        const int j = static_cast<int>((x - 1.0) * TABLE_STEPS);
+        const double y = x / (1.0 + static_cast<double>(j) / TABLE_STEPS);
+        const double t = (y - 1.0) / (y + 1.0);
+        const double t2 = t * t;
+        const double series = 2.0 * t * (1.0 + t2 * (1.0 / 3.0 + t2 * (1.0 / 5.0 + t2 * (1.0 / 7.0 + t2 * (1.0 / 9.0 + t2 / 11.0)))));
+        return series + LOG_TABLE[j] + e * LN2;
+    }
+
+
+    //! Zero for x <= 0
+    constexpr double pow(double x, double y)
+    {
+        return x > 0.0 ? exp(y * log(x)) : 0.0;
+    }
+
+
+    constexpr double cbrt(double x)
+    {
+        return x < 0.0 ? -pow(-x, 1.0 / 3.0) : pow(x, 1.0 / 3.0);
+    }
+
+
+    constexpr double sqrt(double x)
+    {
+        if (x <= 0.0)
+            return 0.0;
+        double r = exp(0.5 * log(x));
+        return 0.5 * (r + x / r);
+    }
+
+
+    // Series on [-pi, pi]
+    constexpr double reduceAngle(double x)
+    {
+        const double turns = x / (2.0 * PI);
+        const auto k = static_cast<long long>(turns + (turns < 0.0 ? -0.5 : 0.5));
+        return x - k * 2.0 * PI;
+    }
+
+
+    constexpr double sin(double x)
+    {
+        x = reduceAngle(x);
+        double term = x, sum = x;
+        for (int n = 1; n < 16; ++n) {
+            term *= -x * x / ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+
+    constexpr double cos(double x)
+    {
+        x = reduceAngle(x);
+        double term = 1.0, sum = 1.0;
+        for (int n = 1; n < 16; ++n) {
+            term *= -x * x / ((2 * n - 1) * (2 * n));
+            sum += term;
+        }
+        return sum;
+    }
+
+
+    constexpr double atan(double x)
+    {
+        if (x < 0.0)
+            return -atan(-x);
+        if (x > 1.0)
+            return PI / 2.0 - atan(1.0 / x);
+        // Halving argument twice, x <= tan(pi / 16)
+        x = x / (1.0 + sqrt(1.0 + x * x));
+        x = x / (1.0 + sqrt(1.0 + x * x));
+        double term = x, sum = 0.0;
+        for (int n = 1; n < 40; n += 2) {
+            sum += term / n;
+            term *= -x * x;
+        }
+        return 4.0 * sum;
+    }
+
+
+    constexpr double atan2(double y, double x)
+    {
+        if (x > 0.0)
+            return atan(y / x);
+        if (x < 0.0)
+            return y >= 0.0 ? atan(y / x) + PI : atan(y / x) - PI;
+        return y > 0.0 ? PI / 2.0 : (y < 0.0 ? -PI / 2.0 : 0.0);
+    }
+
+
+    constexpr double clamp01(double x)
+    {
+        return x < 0.0 ? 0.0 : (x > 1.0 ? 1.0 : x);
+    }
+
+
+    // ==== Conversions ===================================================
+
+    // Same components as color structures, in double
+    struct Vec3 { double x, y, z; };
+
+
+    constexpr double invGamma(double c)
+    {
+        return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+    }
+
+
+    // Gamma encode and clamp to 0..1
+    constexpr double gammaCorrectAndLimit(double c)
+    {
+        c = c <= 0.0031308 ? 12.92 * c : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+        return clamp01(c);
+    }
+
+
+    constexpr Vec3 cieLabFromRgb(const Rgb& rgb)
+    {
+        const double r = invGamma(rgb.r);
+        const double g = invGamma(rgb.g);
+        const double b = invGamma(rgb.b);
+        const double x = (r * 0.4124 + g * 0.3576 + b * 0.1805) / 0.95047;
+        const double y = (r * 0.2126 + g * 0.7152 + b * 0.0722) / 1.00000;
+        const double z = (r * 0.0193 + g * 0.1192 + b * 0.9505) / 1.08883;
+        auto f = [](double t) {
+            return t > 0.008856 ? cbrt(t) : 7.787 * t + 16.0 / 116.0;
+        };
+        return { 116.0 * f(y) - 16.0, 500.0 * (f(x) - f(y)), 200.0 * (f(y) - f(z)) };
+    }
+
+
+    constexpr Vec3 cieLabToRgb(const Vec3& lab)
+    {
+        double y = (lab.x + 16.0) / 116.0;
+        double x = lab.y / 500.0 + y;
+        double z = y - lab.z / 200.0;
+        auto f = [](double t) {
+            return t * t * t > 0.008856 ? t * t * t : (t - 16.0 / 116.0) / 7.787;
+        };
+        x = f(x) * 95.047;
+        y = f(y) * 100.000;
+        z = f(z) * 108.883;
+        return {
+            gammaCorrectAndLimit(x *  0.032406 + y * -0.015372 + z * -0.004986),
+            gammaCorrectAndLimit(x * -0.009689 + y *  0.018758 + z *  0.000415),
+            gammaCorrectAndLimit(x *  0.000557 + y * -0.002040 + z *  0.010570)
+        };
+    }
+
+
+    constexpr Vec3 okLabFromRgb(const Rgb& rgb)
+    {
+        const double r = invGamma(rgb.r);
+        const double g = invGamma(rgb.g);
+        const double b = invGamma(rgb.b);
+        const double l = cbrt(0.4122214708 * r + 0.5363325363 * g + 0.0514459929 * b);
+        const double m = cbrt(0.2119034982 * r + 0.6806995451 * g + 0.1073969566 * b);
+        const double s = cbrt(0.0883024619 * r + 0.2817188376 * g + 0.6299787005 * b);
+        return {
+            +0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s,
+            +1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s,
+            +0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s
+        };
+    }
+
+
+    constexpr Vec3 okLabToRgb(const Vec3& lab)
+    {
+        const double l_ = lab.x + 0.3963377774 * lab.y + 0.2158037573 * lab.z;
+        const double m_ = lab.x - 0.1055613458 * lab.y - 0.0638541728 * lab.z;
+        const double s_ = lab.x - 0.0894841775 * lab.y - 1.2914855480 * lab.z;
+        const double l = l_ * l_ * l_;
+        const double m = m_ * m_ * m_;
+        const double s = s_ * s_ * s_;
+        return {
+            gammaCorrectAndLimit(+4.0767416621 * l - 3.3077115913 * m + 0.2309699292 * s),
+            gammaCorrectAndLimit(-1.2684380046 * l + 2.6097574011 * m - 0.3413193965 * s),
+            gammaCorrectAndLimit(-0.0041960863 * l - 0.7034186147 * m + 1.7076147010 * s)
+        };
+    }
+
+
+    // Lab to LCh with hue in degrees 0..360
+    constexpr Vec3 labToLch(const Vec3& lab)
+    {
+        double h = atan2(lab.z, lab.y) * (180.0 / PI);
+        if (h < 0.0)
+            h += 360.0;
+        return { lab.x, sqrt(lab.y * lab.y + lab.z * lab.z), h };
+    }
+
+
+    constexpr Vec3 lchToLab(const Vec3& lch)
+    {
+        const double h = lch.z * (PI / 180.0);
+        return { lch.x, lch.y * cos(h), lch.y * sin(h) };
+    }
+
+
+    // ==== Gradients =====================================================
+
+    constexpr Vec3 lerp(const Vec3& a, const Vec3& b, double t)
+    {
+        return { (1.0 - t) * a.x + t * b.x, (1.0 - t) * a.y + t * b.y, (1.0 - t) * a.z + t * b.z };
+    }
+
+
+    // LCh from a by t of shorter hue arc towards b
+    constexpr Vec3 lerpLch(const Vec3& a, const Vec3& b, double t)
+    {
+        double deltaH = b.z - a.z;
+        if (deltaH > 180.0)
+            deltaH -= 360.0;
+        if (deltaH < -180.0)
+            deltaH += 360.0;
+        return { a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), a.z + t * deltaH };
+    }
+
+
+    //! \brief Gradient from `start` to `end`, same as color::gradient* functions
+    //! Ends are converted once, at() converts only result.
+    struct Gradient {
+        Interpolation interpolation;
+        Vec3 start, end;        //!< in color space of interpolation
+
+        // NOTE: Calls are qualified, argument dependent lookup would find runtime conversions too.
+        constexpr Gradient(Interpolation interp, const Rgb& startRgb, const Rgb& endRgb)
+            : interpolation(interp), start{ startRgb.r, startRgb.g, startRgb.b }, end{ endRgb.r, endRgb.g, endRgb.b }
+        {
+            if (interpolation == INTERP_CIELCH) {
+                start = labToLch(ct::cieLabFromRgb(startRgb));
+                end = labToLch(ct::cieLabFromRgb(endRgb));
+                if (start.y < 0.015 || end.y < 0.015)
+                    interpolation = INTERP_CIELAB;
+            }
+            else if (interpolation == INTERP_OKLCH) {
+                start = labToLch(ct::okLabFromRgb(startRgb));
+                end = labToLch(ct::okLabFromRgb(endRgb));
+                if (start.y < 1.0e-3 || end.y < 1.0e-3)
+                    interpolation = INTERP_OKLAB;
+            }
+            if (interpolation == INTERP_CIELAB) {
+                start = ct::cieLabFromRgb(startRgb);
+                end = ct::cieLabFromRgb(endRgb);
+            }
+            else if (interpolation == INTERP_OKLAB) {
+                start = ct::okLabFromRgb(startRgb);
+                end = ct::okLabFromRgb(endRgb);
+            }
+        }
+
+        //! \brief Color at `t` (0..1)
+        constexpr Vec3 at(double t) const
+        {
+            switch (interpolation) {
+            case INTERP_CIELAB:
+                return ct::cieLabToRgb(lerp(start, end, t));
+            case INTERP_CIELCH:
+                return ct::cieLabToRgb(lchToLab(lerpLch(start, end, t)));
+            case INTERP_OKLAB:
+                return ct::okLabToRgb(lerp(start, end, t));
+            case INTERP_OKLCH:
+                return ct::okLabToRgb(lchToLab(lerpLch(start, end, t)));
+            default:
+                return lerp(start, end, t);
+            }
+        }
+    };
+
+
+    //! \brief `N` colors of gradient with `length` colors from `first` on, as 16-bit fixed point (65535 is 1.0)
+    //! NOTE: Each color costs thousands of constexpr operations, large tables
+    //! should be baked in chunks, each as separate constant (see presets.cpp).
+    template <size_t N>
+    constexpr std::array<std::array<uint16_t, 3>, N> bakeGradient(Interpolation interpolation, const Rgb& start, const Rgb& end,
+        size_t length = N, size_t first = 0)
+    {
+        static_assert(N >= 1);
+        const Gradient gradient(interpolation, start, end);
+        std::array<std::array<uint16_t, 3>, N> result{};
+        for (size_t i = 0; i < N; ++i) {
+            const Vec3 c = gradient.at(static_cast<double>(first + i) / (length - 1));
+            result[i] = {
+                static_cast<uint16_t>(clamp01(c.x) * 65535.0 + 0.5),
+                static_cast<uint16_t>(clamp01(c.y) * 65535.0 + 0.5),
+                static_cast<uint16_t>(clamp01(c.z) * 65535.0 + 0.5)
+            };
+        }
+        return result;
+    }
+
+} // namespace color::ct
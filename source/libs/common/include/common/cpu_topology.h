@@ -0,0 +1,30 @@
+//! \file cpu_topology.h
+//! \brief Logical CPUs with their package, core and relative performance
+//!
+//! Read from Linux sysfs (/sys/devices/system/cpu). Performance is cpu_capacity
+//! where kernel provides it (ARM big.LITTLE), maximum frequency otherwise. Hybrid
+//! Intel parts list efficiency cores in /sys/devices/cpu_atom/cpus.
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct CpuInfo {
+    int id = 0;                 //!< logical CPU number
+    int package = 0;            //!< socket
+    int core = 0;               //!< core within package, SMT siblings share it
+    uint32_t capacity = 1024;   //!< relative performance, fastest CPU has 1024
+    bool efficient = false;     //!< efficiency core of hybrid CPU
+};
+
+//! \brief Online CPUs sorted by id, empty where sysfs is not available
+[[nodiscard]] std::vector<CpuInfo> cpuTopology();
+
+//! \brief One logical CPU per physical core, fastest first, packages taking turns
+[[nodiscard]] std::vector<int> cpusOnePerCore(const std::vector<CpuInfo>& cpus);
+
+//! \brief Parses CPU list in sysfs and taskset format, e.g. "0-3,8,10-11"
+//! \return empty vector if list is malformed
+[[nodiscard]] std::vector<int> parseCpuList(std::string_view list);
@@ -0,0 +1,79 @@
+//! \file event_log.h
+//! \brief Compact binary log of parameter changes for deterministic replay
+//!
+//! Log stores simulation size, agent count and seed followed by events. Event
+//! with step N is applied before N-th simulation step (steps counted from 0),
+//! events with same step are applied in order. Last event is EVENT_END with
+//! hash of final field, so replay can verify bit-identical result.
+//!
+//! File format (little endian): header of 6 uint32 (magic, version, width,
+//! height, agents, seed), then events as LEB128 step delta, uint8 type and
+//! type specific payload of floats (uint64 hash for EVENT_END, uint8 option
+//! and uint32 value for EVENT_OPTION). Version 1 logs have no EVENT_OPTION.
+
+#pragma once
+
+#include "common/colors.h"
+#include "common/presets.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct EventLog
+{
+    enum EventType : uint8_t {
+        EVENT_AGENT   = 1,  //!< agent parameters including palette midpoint
+        EVENT_PALETTE = 2,  //!< palette colors
+        EVENT_RESET   = 3,  //!< field cleared and agents re-randomized
+        EVENT_END     = 4,  //!< end of recording, carries field hash
+        EVENT_OPTION  = 5,  //!< simulation option which changes results
+        EVENT_RESET_AGENTS = 6, //!< agents spawned again, field kept
+    };
+
+    enum Option : uint8_t {
+        OPTION_SAMPLING = 1,    //!< value is SlimeMoldSimulation::Sampling
+        OPTION_LIFECYCLE = 2,   //!< 1 if lifecycle is enabled
+        OPTION_MAX_AGE = 3,     //!< Lifecycle::maxAge
+        OPTION_SPAWN_THRESHOLD = 4, //!< Lifecycle::spawnThreshold, float bits
+        OPTION_SPAWN_MODE = 5,  //!< SlimeMoldSimulation::SpawnMode
+        OPTION_AGENT_FORMAT = 6,    //!< SlimeMoldSimulation::AgentFormat
+        OPTION_SENSOR_PYRAMID = 7,  //!< 1 if sensors read field pyramid
+        OPTION_BOUNDARY = 8,    //!< SlimeMoldSimulation::Boundary
+    };
+
+    struct Event
+    {
+        uint64_t step = 0;
+        EventType type = EVENT_END;
+        AgentPreset agent{};                    //!< EVENT_AGENT, name is not stored
+        std::array<color::Rgb, 3> palette{};    //!< EVENT_PALETTE
+        uint64_t fieldHash = 0;                 //!< EVENT_END
+        Option option = OPTION_SAMPLING;        //!< EVENT_OPTION
+        uint32_t value = 0;                     //!< EVENT_OPTION
+    };
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t numAgents = 0;
+    uint32_t seed = 0;
+    std::vector<Event> events;
+
+    void addAgent(uint64_t step, const AgentPreset& agent);
+    void addPalette(uint64_t step, const std::array<color::Rgb, 3>& palette);
+    void addReset(uint64_t step);
+    void addResetAgents(uint64_t step);
+    void addOption(uint64_t step, Option option, uint32_t value);
+    void addEnd(uint64_t step, uint64_t fieldHash);
+
+    //! \brief Writes log to file, returns false on error
+    bool save(const std::string& path) const;
+    //! \brief Reads log from file, returns false if file is missing or malformed
+    bool load(const std::string& path);
+
+    //! \brief Hash of field bits, FNV-1a style over 32-bit words instead of bytes
+    //! Starts from 64-bit FNV offset basis, then for each float bit pattern w:
+    //! hash = (hash ^ w) * 1099511628211 (mod 2^64).
+    static uint64_t fieldHash(const float* field, size_t count);
+};
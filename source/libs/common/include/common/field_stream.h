@@ -0,0 +1,94 @@
+//! \file field_stream.h
+//! \brief Compressed stream of raw float fields for offline analysis
+//!
+//! File starts with header of 8 uint32 (magic, version, width, height, flags,
+//! keyframe interval, cells per block, mantissa bits), followed by frames. Frame
+//! is chunk header (uint32 magic, uint32 type, uint64 step, uint64 payload bytes)
+//! and payload of blocks of up to `cells per block` cells. Block is uint32 size (bit 31 set when
+//! stored uncompressed) and data. Index of frames (uint32 magic, uint64 count,
+//! count times uint64 step and uint64 offset with bit 63 set for keyframes) and
+//! trailer (uint64 index offset, uint32 magic) are written on close.
+//!
+//! Cells are stored as integer difference of float bits from prediction, which
+//! is left neighbour in keyframes and same cell of previous frame in delta frames
+//! (FLAG_DELTA), so unchanged cells and high bits vanish. Bytes of a block are
+//! split into 4 planes (all lowest bytes first), then compressed with LZ4-like
+//! byte oriented codec with FLAG_LZ. Encoding is lossless unless mantissa is
+//! rounded to fewer bits. Evaporation changes every cell every step, so lossless
+//! stream of a busy field is only slightly smaller than raw, while 8 mantissa bits
+//! (relative error below 0.2 %) zero the lowest byte plane and most of the next.
+//!
+//! Stream written to pipe is complete too, reader of truncated stream (without
+//! trailer) finds frames by scanning chunk headers. All values are little endian.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class FieldStreamWriter final
+{
+public:
+    enum Flags : uint32_t {
+        FLAG_DELTA = 1,     //!< difference from previous frame between keyframes
+        FLAG_LZ    = 2,     //!< LZ compression of byte planes
+    };
+
+    //! \brief Creates file `path`, "-" writes to standard output
+    //! \param keyframeInterval frames between keyframes, smaller makes random access cheaper
+    //! \param mantissaBits float mantissa bits kept (rounded), 23 is lossless
+    FieldStreamWriter(const std::string& path, size_t width, size_t height,
+        uint32_t flags = FLAG_DELTA | FLAG_LZ, size_t keyframeInterval = 32, unsigned mantissaBits = 23);
+
+    //! \brief Closes stream if it is still open
+    ~FieldStreamWriter();
+
+    [[nodiscard]] bool valid() const noexcept;
+
+    //! \brief Queues copy of field, encoding and writing run on background thread
+    //! Blocks only when writer is several frames behind.
+    //! \return false if stream is closed or writing failed
+    bool write(uint64_t step, const float* field);
+
+    //! \brief Writes pending frames and index
+    //! \return false if any write failed
+    bool close();
+
+    //! \brief Frames and bytes written so far (raw size is frames * width * height * 4)
+    [[nodiscard]] size_t frames() const noexcept;
+    [[nodiscard]] uint64_t bytes() const noexcept;
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
+
+
+class FieldStreamReader final
+{
+public:
+    //! \brief Opens stream file and reads its index
+    explicit FieldStreamReader(const std::string& path);
+    ~FieldStreamReader();
+
+    [[nodiscard]] bool valid() const noexcept;
+    [[nodiscard]] size_t width() const noexcept;
+    [[nodiscard]] size_t height() const noexcept;
+    [[nodiscard]] size_t frameCount() const noexcept;
+    [[nodiscard]] uint64_t frameStep(size_t index) const;
+
+    //! \brief Index of first frame with step >= `step`, frameCount() if there is none
+    [[nodiscard]] size_t findStep(uint64_t step) const;
+
+    //! \brief Decodes frame into `field` of width * height floats
+    //! Delta frame is decoded from nearest keyframe, unless previous call read
+    //! frame before it, so reading in order decodes every frame once.
+    //! \return false if index is out of range or file is corrupted
+    bool readFrame(size_t index, float* field);
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
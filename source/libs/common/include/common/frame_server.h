@@ -0,0 +1,113 @@
+//! \file frame_server.h
+//! \brief Publishing of frames to other processes through POSIX shared memory
+//!
+//! Shared memory object contains FrameRingHeader followed by `slotCount` slots.
+//! Each slot starts with FrameSlotHeader, followed by float field (width*height)
+//! and pixels (width*height*4 bytes, ARGB32 byte order as SDL texture) at given
+//! offsets. Publisher writes into oldest slot, so reader can use latest frame in
+//! place while publisher fills other slots. Reader checks slot sequence before
+//! and after use to detect frame overwritten meanwhile (seqlock).
+//!
+//! On Linux, `futexWord` is incremented after each frame and waiters are woken
+//! by futex, elsewhere readers have to poll `latestSequence`.
+//! Not available on Windows and WebAssembly, publisher is never valid there.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct FrameSlotHeader
+{
+    std::atomic<uint64_t> sequence;     //!< frame sequence number, 0 while being written
+    int64_t timestampNs;                //!< CLOCK_MONOTONIC time of publishing
+};
+
+
+struct FrameRingHeader
+{
+    static constexpr uint32_t MAGIC   = 0x534c4d46; // "SLMF"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t slotCount;
+    uint32_t contents;                  //!< FramePublisher::Content flags
+    uint64_t slotOffset;                //!< offset of first slot from start of shared memory
+    uint64_t slotStride;                //!< bytes between slots
+    uint64_t fieldOffset;               //!< float field offset within slot
+    uint64_t pixelsOffset;              //!< pixels offset within slot
+    std::atomic<uint32_t> futexWord;    //!< incremented on every publish
+    uint32_t reserved;
+    std::atomic<uint64_t> latestSequence; //!< last complete frame, 0 when none
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+    "Atomics in shared memory must be lock free");
+
+
+class FramePublisher final
+{
+public:
+    enum Content : uint32_t {
+        CONTENT_FIELD  = 1,
+        CONTENT_PIXELS = 2,
+    };
+
+    //! \brief Creates (or replaces) shared memory object `name` such as "/slime_mold"
+    FramePublisher(const std::string& name, size_t width, size_t height,
+        uint32_t contents = CONTENT_FIELD | CONTENT_PIXELS, size_t slotCount = 4);
+
+    //! \brief Unlinks shared memory object, mapped readers keep their mapping
+    ~FramePublisher();
+
+    [[nodiscard]] bool valid() const noexcept;
+
+    //! \brief Copies frame into next slot and wakes readers, null or missing content is skipped
+    void publish(const float* field, const uint8_t* pixels);
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
+
+
+class FrameSubscriber final
+{
+public:
+    //! Frame data pointing directly into shared memory
+    struct Frame
+    {
+        uint64_t sequence = 0;
+        int64_t timestampNs = 0;
+        const float* field = nullptr;
+        const uint8_t* pixels = nullptr;
+        const FrameSlotHeader* slot = nullptr;
+    };
+
+    //! \brief Opens shared memory object created by FramePublisher
+    explicit FrameSubscriber(const std::string& name);
+    ~FrameSubscriber();
+
+    [[nodiscard]] bool valid() const noexcept;
+    [[nodiscard]] size_t width() const noexcept;
+    [[nodiscard]] size_t height() const noexcept;
+
+    //! \brief Waits until frame newer than `lastSequence` is published or timeout expires
+    //! \return true and latest frame in `frame`, false on timeout
+    bool waitFrame(uint64_t lastSequence, int timeoutMs, Frame& frame);
+
+    //! \brief Returns true if frame data were not overwritten since waitFrame
+    [[nodiscard]] bool stillValid(const Frame& frame) const noexcept;
+
+    //! \brief Current CLOCK_MONOTONIC time, comparable with Frame::timestampNs
+    [[nodiscard]] static int64_t nowNs() noexcept;
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
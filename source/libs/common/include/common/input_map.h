@@ -0,0 +1,39 @@
+//! \file input_map.h
+//! \brief Static input layers of simulation: obstacles and attractors
+//!
+//! Obstacles block movement and keep trail at zero, so agents also sense them as
+//! empty space. Attractors add `attractorStrength * value / 255` to trail every
+//! step (negative strength repels), so sensing still reads only the trail field.
+//! Layers are optional, empty vector means layer is not used.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct InputMap
+{
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint64_t> obstacles;    //!< 1 bit per cell, row-major, bit i%64 of word i/64
+    std::vector<uint8_t> attractors;    //!< 1 byte per cell, row-major
+    float attractorStrength = 1.0f;
+
+    InputMap() = default;
+    InputMap(size_t width, size_t height);
+
+    bool hasObstacles() const { return !obstacles.empty(); }
+    bool hasAttractors() const { return !attractors.empty(); }
+
+    bool isObstacle(size_t idx) const { return (obstacles[idx >> 6] >> (idx & 63)) & 1; }
+    void setObstacle(size_t idx) { obstacles[idx >> 6] |= uint64_t(1) << (idx & 63); }
+
+    //! \brief Loads obstacles from image, pixels brighter than half are obstacles
+    //! Image is binary 8-bit PGM or PPM (P5/P6), scaled (nearest) to map size.
+    //! \return false if file is missing or not supported
+    bool loadObstacles(const std::string& path);
+    //! \brief Loads attractors from image, brightness is attractor value
+    bool loadAttractors(const std::string& path);
+};
@@ -0,0 +1,85 @@
+//! \file perf_counters.h
+//! \brief Hardware performance counters of whole process and their split into phases
+//!
+//! Counters are opened with Linux perf_event_open on every thread existing at
+//! construction, so pool workers must be started first (ThreadPool::global()).
+//! Threads started later are not counted, newThreads() tells when counters
+//! must be constructed again (view model checks it with every stats update).
+//! Kernel and hypervisor are excluded, which perf_event_paranoid up to 2 allows.
+//! Counters which cannot be opened (other systems, containers, missing PMU
+//! events) are reported unavailable and read as 0, wall time always works.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class PerfCounters final
+{
+public:
+    enum Counter {
+        CYCLES,
+        INSTRUCTIONS,
+        LLC_MISSES,         //!< last level cache misses
+        DTLB_MISSES,        //!< data TLB read misses
+        COUNTER_END
+    };
+    using Values = std::array<uint64_t, COUNTER_END>;
+
+    PerfCounters();
+    ~PerfCounters();
+
+    [[nodiscard]] bool available(Counter counter) const noexcept;
+    //! \brief True if any counter is available
+    [[nodiscard]] bool valid() const noexcept;
+    //! \brief Why counters are not available, empty if all are
+    [[nodiscard]] const std::string& error() const noexcept;
+    //! \brief Number of threads counters are open on
+    [[nodiscard]] size_t threads() const noexcept;
+    //! \brief Number of threads started since construction, which are not counted
+    [[nodiscard]] size_t newThreads() const;
+
+    //! \brief Counts since construction summed over threads, scaled up when
+    //! kernel multiplexes counters
+    [[nodiscard]] Values read() const;
+
+    [[nodiscard]] static const char* name(Counter counter) noexcept;
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
+
+
+//! \brief Counters and wall time between marks, accumulated per phase
+//! NOTE: Not thread-safe, marks and reads must not overlap.
+class PhaseCounters final
+{
+public:
+    struct Totals {
+        PerfCounters::Values values{};
+        double seconds = 0.0;
+        size_t runs = 0;
+    };
+
+    //! \param counters may be nullptr, only wall time is measured then
+    PhaseCounters(const PerfCounters* counters, size_t phases);
+
+    //! \brief Ends current phase and starts `phase`, phase past last one only ends current
+    void mark(size_t phase);
+    [[nodiscard]] const std::vector<Totals>& totals() const noexcept;
+    void clear();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    const PerfCounters* m_counters;
+    std::vector<Totals> m_totals;
+    size_t m_phase;
+    PerfCounters::Values m_startValues{};
+    Clock::time_point m_startTime;
+};
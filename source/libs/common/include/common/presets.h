@@ -25,3 +25,9 @@ struct AgentPreset {
 
 extern const std::vector<AgentPreset>&   presetAgents();
 extern const std::vector<PalettePreset>& presetPalettes();
+
+//! \brief Gradient from color `segment` to `segment` + 1 of preset palette `palette`
+//! Resampled from gradient baked at compile time, so it costs no color conversions.
+//! Matches gradient function of `interpolation` (with exact conversions) within
+//! rounding to 8 bits.
+extern std::vector<color::Rgb> presetGradient(size_t palette, size_t segment, color::Interpolation interpolation, size_t length);
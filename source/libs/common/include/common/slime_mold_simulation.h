@@ -2,21 +2,144 @@
 
 #pragma once
 
+#include "common/input_map.h"
 #include "common/presets.h"
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 
 class SlimeMoldSimulation final
 {
 public:
+    //! How sensors read the field
+    enum Sampling {
+        SAMPLING_NEAREST,   //!< nearest cell, cheapest
+        SAMPLING_BILINEAR,  //!< interpolated between 4 cells, less aliasing with short sensors
+    };
+
+    //! What happens at field edges. Sensors outside of field read nearest edge
+    //! cell with walls. Diffusion is per cell, so it does not depend on this.
+    enum Boundary {
+        BOUNDARY_WRAP,      //!< torus, agents leaving on one side enter on opposite side
+        BOUNDARY_REFLECT,   //!< wall, agent is clamped to edge and heading mirrored
+        BOUNDARY_ABSORB,    //!< wall, agent leaving is replaced by one at random position, same heading
+        BOUNDARY_END
+    };
+
+    //! Initial distribution of agents
+    enum SpawnMode {
+        SPAWN_UNIFORM,      //!< whole field, random heading
+        SPAWN_DISC,         //!< disc in center, random heading
+        SPAWN_RING,         //!< thin ring in center, heading inward
+        SPAWN_IMAGE,        //!< density of attractor layer of input map, uniform without it
+        SPAWN_POISSON,      //!< blue noise over whole field, serial and slow for many agents
+        SPAWN_END
+    };
+
+    //! Implementation of hot loops. Scalar kernels are reference for SIMD ones
+    //! (AVX2 or SIMD128 depending on build), results are bit-identical.
+    enum Kernels {
+        KERNELS_SIMD,       //!< fastest available, scalar in builds without SIMD
+        KERNELS_SCALAR,     //!< reference, for checking SIMD kernels (see apps/test_kernels)
+    };
+
+    //! Storage of agents. Compact agents move on 4096 headings by table lookups,
+    //! so results differ from float agents.
+    enum AgentFormat {
+        AGENTS_FLOAT,       //!< float position and direction, 16 bytes
+        AGENTS_COMPACT,     //!< fixed point position and heading index, 8 bytes, field up to 65536 cells wide and high
+    };
+
+    //! Birth and death of agents. Agent gains energy from trail under it and spends
+    //! some every step, it dies out of energy or of age. Agent with enough energy
+    //! on dense trail splits, child gets half of energy and random direction.
+    struct Lifecycle {
+        bool enabled = false;
+        uint32_t maxAge = 2000;         //!< steps, 0 means unlimited
+        float energyCost = 0.01f;       //!< energy spent per step
+        float energyGain = 0.002f;      //!< energy gained per unit of trail under agent
+        float spawnThreshold = 20.0f;   //!< trail under agent needed to split
+        float spawnEnergy = 1.0f;       //!< energy needed to split, initial energy is half of it
+    };
+
+    //! Parts of step, in order they run. Step without lifecycle skips it,
+    //! sorting runs only in builds with DO_SORTING.
+    enum Phase {
+        PHASE_MOVE,         //!< sensing and movement, with rebuild of sensor pyramid
+        PHASE_DEPOSIT,
+        PHASE_SORT,
+        PHASE_LIFECYCLE,
+        PHASE_DIFFUSE,      //!< diffusion and evaporation
+        PHASE_END           //!< step finished
+    };
+    using PhaseCallback = std::function<void(Phase)>;
+
     // WARNING: WIDTH*HEIGHT must be divisible by 8 due to vectorization code
-    SlimeMoldSimulation(size_t width, size_t height, size_t numAgents);
+    // NOTE: seed 0 means time based seed, same nonzero seed gives same agents
+    SlimeMoldSimulation(size_t width, size_t height, size_t numAgents, uint32_t seed = 0);
     ~SlimeMoldSimulation();
 
+    //! NOTE: Fields are bit-identical for any number of threads of ThreadPool::global()
+    //! (see apps/test_kernels). Work is split into fixed chunks, random numbers
+    //! are hashed from agent index and deposits do not depend on their order.
     void step(const AgentPreset&);
     void reset();
+    //! \brief Reset with new seed, agents are same as in new simulation with this seed
+    void reset(uint32_t seed);
+    //! \brief Spawns agents again, field is kept
+    void resetAgents();
     const float* data();
 
+    //! \brief Limits number of simulated agents (up to numAgents), inactive agents are frozen
+    //! With lifecycle, population may be smaller and it grows only by spawning.
+    void setActiveAgents(size_t count);
+    //! \brief Number of alive agents, these are always first in agent array
+    size_t activeAgents() const;
+    //! \brief Limit set by setActiveAgents
+    size_t agentLimit() const;
+    size_t maxAgents() const;
+
+    //! \brief Enabling resets energy and age of all agents, disabling spawns agents up to limit again with current spawn mode
+    void setLifecycle(const Lifecycle&);
+    const Lifecycle& lifecycle() const;
+
+    void setSampling(Sampling);
+    Sampling sampling() const;
+
+    void setBoundary(Boundary);
+    Boundary boundary() const;
+
+    //! \brief Distribution used by next reset
+    void setSpawnMode(SpawnMode);
+    SpawnMode spawnMode() const;
+
+    void setKernels(Kernels);
+    Kernels kernels() const;
+
+    //! \brief Converts agents, heading is rounded to nearest of 4096 on packing
+    //! \return false if field is too large for compact agents
+    bool setAgentFormat(AgentFormat);
+    AgentFormat agentFormat() const;
+
+    //! \brief Sensors 8 and more cells away read averaged levels of field halved
+    //! 1 to 3 times, so sensing cost does not grow with distance. Results differ
+    //! for such sensors. Level 1 is updated with evaporation.
+    //! \return false if field size is odd, it has no levels
+    bool setSensorPyramid(bool enabled);
+    bool sensorPyramid() const;
+
+    //! \brief Called on thread running step() when phase starts, for profiling
+    //! (see PhaseCounters). Empty callback removes it.
+    void setPhaseCallback(PhaseCallback callback);
+
+    //! \brief Sets obstacles and attractors, see input_map.h. Empty map removes them.
+    //! \return false if map size differs from simulation size
+    bool setInputMap(InputMap map);
+    const InputMap& inputMap() const;
+    //! \brief Sets only strength of attractors, layers of map stay
+    void setAttractorStrength(float strength);
+
 private:
     class Private;
     std::unique_ptr<Private> m_p;
@@ -2,10 +2,15 @@
 
 #pragma once
 
+#include "common/colormap.h"
 #include "common/presets.h"
+#include "common/slime_mold_simulation.h"
+#include "common/slime_mold_volume.h"
 
 #include <array>
 #include <memory>
+#include <string>
+#include <vector>
 
 class SlimeMoldViewModel final
 {
@@ -19,6 +24,23 @@ public:
         CMAP_INTERP_END
     };
 
+    enum ToneMapping {
+        TONEMAP_FIXED,          //!< fixed field scale
+        TONEMAP_PERCENTILE,     //!< field percentile maps to end of palette
+        TONEMAP_LOG,            //!< as percentile, with logarithmic curve
+        TONEMAP_END
+    };
+
+    //! Statistics of field gathered while applying palette, one frame old
+    struct FieldStats {
+        float max = 0.0f;
+        float mean = 0.0f;
+        float percentile = 0.0f;    //!< field value at tone mapping percentile (estimate)
+        float exposure = 0.0f;      //!< smoothed field value mapped to end of palette
+    };
+
+    //! NOTE: Palettes follow color::setUseLookupTables(), which is left to
+    //! application (UI enables tables at startup).
     SlimeMoldViewModel(size_t width, size_t height);
 
     ~SlimeMoldViewModel();
@@ -35,8 +57,159 @@ public:
     std::array<color::Rgb, 3> palette() const;
     void setPalette(const std::array<color::Rgb, 3>&);
 
+    //! \brief Moves agent parameters and palette to presets over `seconds`, field is kept
+    //! Palette LUT is blended between LUTs of both ends, edits cancel transition.
+    void morphToPresets(size_t agentIndex, size_t paletteIndex, float seconds);
+    bool morphing() const;
+    //! \brief Show cycling through presets, holds each for `holdSeconds` then morphs to next
+    void setShow(bool enabled, float holdSeconds, float morphSeconds);
+    bool showEnabled() const;
+
+    //! Frame time governor state, times are smoothed over frames
+    struct GovernorStats {
+        bool enabled = false;
+        float budgetMs = 0.0f;      //!< budget for simulation steps and colormap (slower of them when pipelined)
+        float stepMs = 0.0f;        //!< one simulation step
+        float colormapMs = 0.0f;
+        size_t stepsPerFrame = 1;
+        size_t activeAgents = 0;
+        size_t maxAgents = 0;
+    };
+
+    //! \brief When enabled, steps per frame and then active agents are reduced to fit budget
+    //! NOTE: Agent count is not changed while recording, replay would differ.
+    void setGovernor(bool enabled, float budgetMs);
+    //! \brief Requested simulation steps per frame, governor may do fewer
+    void setStepsPerFrame(size_t steps);
+    GovernorStats governorStats() const;
+
+    //! \brief Steps of next frame run in background while frame is colormapped and drawn
+    //! Frame time approaches the slower of steps and the rest of frame instead of
+    //! their sum, shown field is one frame behind simulation. Enabled by default
+    //! where threads are available, methods changing simulation wait for steps.
+    void setPipelined(bool enabled);
+    bool pipelined() const;
+
+    //! Load of thread pool thread over last second, see ThreadPool::stats
+    struct WorkerStats {
+        int cpu = -1;               //!< pinned CPU, -1 when not pinned
+        float utilization = 0.0f;   //!< fraction of time spent in loops
+        float stolen = 0.0f;        //!< fraction of chunks taken from other threads
+    };
+
+    //! \brief Thread pool with one thread per physical core, workers pinned to fastest cores
+    //! \return false if CPU topology is not known (outside Linux), pool is not pinned then
+    bool setPinnedThreads(bool enabled);
+    bool pinnedThreads() const;
+    //! \brief Index 0 is thread calling loops (frame or background steps), empty during first second
+    std::vector<WorkerStats> workerStats() const;
+
+    //! Cost of simulation phase over last second. Counters are per agent, or per
+    //! cell for diffusion, and negative when not available.
+    struct PhaseStats {
+        SlimeMoldSimulation::Phase phase = SlimeMoldSimulation::PHASE_MOVE;
+        bool perCell = false;
+        float msPerStep = 0.0f;
+        float cycles = -1.0f;
+        float instructions = -1.0f;
+        float llcMisses = -1.0f;
+        float dtlbMisses = -1.0f;
+        size_t threads = 0;         //!< threads hardware counters cover
+    };
+
+    //! \brief Measures simulation phases with hardware counters, see perf_counters.h
+    //! Steps do not overlap drawing while enabled, so counters of whole process
+    //! see only them.
+    //! \return false if counters are not available, only time of phases is measured then
+    bool setPhaseProfiling(bool enabled);
+    bool phaseProfiling() const;
+    //! \brief Phases which ran, empty when profiling is disabled and during its first second
+    std::vector<PhaseStats> phaseStats() const;
+
+    //! \brief Bilinear sensor sampling instead of nearest cell, see SlimeMoldSimulation::Sampling
+    void setBilinearSampling(bool enabled);
+    bool bilinearSampling() const;
+
+    void setBoundary(SlimeMoldSimulation::Boundary);
+    SlimeMoldSimulation::Boundary boundary() const;
+
+    //! \brief Agents in 8 bytes with quantized headings, see SlimeMoldSimulation::AgentFormat
+    void setCompactAgents(bool enabled);
+    bool compactAgents() const;
+
+    //! \brief Far sensors read coarser field, see SlimeMoldSimulation::setSensorPyramid
+    void setSensorPyramid(bool enabled);
+    bool sensorPyramid() const;
+
+    //! \brief Loads obstacles and attractors from PGM/PPM images, see input_map.h
+    //! Layer whose file is missing stays empty.
+    //! NOTE: Input maps are not part of event log, so they cannot be loaded while recording.
+    //! \return false if neither layer could be loaded or recording
+    bool loadInputMap(const std::string& obstaclesPath, const std::string& attractorsPath);
+    void clearInputMap();
+    bool hasInputMap() const;
+    //! \brief Trail added by brightest attractor per step, negative repels
+    //! Ignored while recording, like input map it is not part of event log.
+    void setAttractorStrength(float);
+    float attractorStrength() const;
+
+    //! \brief Birth and death of agents, see SlimeMoldSimulation::Lifecycle
+    void setLifecycle(bool enabled, uint32_t maxAge, float spawnThreshold);
+    bool lifecycleEnabled() const;
+
+    void setToneMapping(ToneMapping);
+    ToneMapping toneMapping() const;
+    FieldStats fieldStats() const;
+
+    //! \brief Size of pixels written by updatePixels, field is resampled to it in colormap pass
+    //! Display of field size is plain colormap with any filter. Tone mapping uses
+    //! stats of displayed values. Published frames still carry field sized pixels.
+    void setDisplay(size_t width, size_t height, colormap::Filter filter);
+    size_t displayWidth() const;
+    size_t displayHeight() const;
+    colormap::Filter displayFilter() const;
+
+    //! \brief Volumetric mode, trail volume of `size`^3 voxels replaces field, 0 returns to 2D
+    //! Shown field is projection of volume (see slime_mold_volume.h), agent preset
+    //! and palette apply to it. 2D simulation is paused and kept. Steps and
+    //! projection run in sequence, governor, recording and field stream see only 2D steps.
+    //! WARNING: size must be multiple of SlimeMoldVolume::BRICK_SIZE
+    void setVolume(size_t size);
+    size_t volumeSize() const;
+    void setVolumeView(const SlimeMoldVolume::Camera&, SlimeMoldVolume::Render);
+    SlimeMoldVolume::Camera volumeCamera() const;
+    SlimeMoldVolume::Render volumeRender() const;
+
+    //! \param pixels displayWidth * displayHeight pixels
     void updatePixels(uint8_t* pixels);
+    //! \brief Restarts simulation, or volume in volumetric mode
     void reset();
+    //! \brief Spawns agents again with current spawn mode, field is kept
+    void resetAgents();
+    void setSpawnMode(SlimeMoldSimulation::SpawnMode);
+    SlimeMoldSimulation::SpawnMode spawnMode() const;
+
+    //! \brief Publishes every frame (field and pixels) to shared memory object `name`
+    //! \return false if shared memory is not supported or could not be created
+    bool startPublishing(const std::string& name);
+    void stopPublishing();
+    bool publishing() const;
+
+    //! \brief Writes raw field every `everySteps` steps to compressed stream, see field_stream.h
+    //! Frame steps are counted as steps of recording when recording.
+    //! \return false if file could not be created
+    bool startFieldStream(const std::string& path, size_t everySteps);
+    //! \return false if not streaming or writing failed
+    bool stopFieldStream();
+    bool fieldStreaming() const;
+
+    //! \brief Restarts simulation with new seed and records all changes from now on
+    //! \return false if input map is loaded, event log could not replay it
+    bool startRecording();
+    //! \brief Stops recording and writes event log, see event_log.h
+    //! \return false if not recording or file could not be written
+    bool stopRecording(const std::string& path);
+    bool recording() const;
 
 private:
     class Private;
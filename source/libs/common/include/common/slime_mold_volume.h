@@ -0,0 +1,72 @@
+//! \file slime_mold_volume.h
+//! \brief Volumetric slime mold with CPU ray-marched projection
+//!
+//! Agents move in torus of width x height x depth voxels. Each senses trail in
+//! a cone ahead of it, one sensor along heading and four tilted by sensor angle
+//! around it, and turns toward the strongest one. Trail diffuses by separable
+//! 3-tap filter along each axis and evaporates.
+//!
+//! Volume is stored in bricks of 8^3 voxels, so neighbours along every axis are
+//! near in memory, and maximum of every brick lets renderer skip empty space.
+//! Renderer projects volume to image of trail values, which is colormapped as
+//! 2D field.
+
+#pragma once
+
+#include "common/presets.h"
+#include "common/slime_mold_simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class SlimeMoldVolume final
+{
+public:
+    //! Edge of brick in voxels
+    static constexpr size_t BRICK_SIZE = 8;
+
+    enum Render {
+        RENDER_MIP,         //!< maximum along ray, bricks not above maximum so far are skipped
+        RENDER_EMISSION,    //!< trail glows and absorbs front to back, empty bricks are skipped, opaque rays end
+        RENDER_END
+    };
+
+    //! Orthographic camera orbiting center of volume, y is up
+    struct Camera {
+        float yaw = 0.6f;       //!< radians around vertical axis
+        float pitch = 0.4f;     //!< radians above horizontal plane
+        float zoom = 1.0f;      //!< 1 fits whole volume in any direction
+    };
+
+    //! WARNING: sizes must be multiples of BRICK_SIZE
+    //! NOTE: seed 0 means time based seed, same nonzero seed gives same agents
+    SlimeMoldVolume(size_t width, size_t height, size_t depth, size_t numAgents, uint32_t seed = 0);
+    ~SlimeMoldVolume();
+
+    //! NOTE: Volume is bit-identical for any number of threads and for both
+    //! kernels (see apps/test_kernels), as in SlimeMoldSimulation::step.
+    void step(const AgentPreset&);
+    //! \brief Clears volume and spawns agents uniformly with random headings
+    void reset();
+    void reset(uint32_t seed);
+
+    void setKernels(SlimeMoldSimulation::Kernels);
+    SlimeMoldSimulation::Kernels kernels() const;
+
+    size_t width() const;
+    size_t height() const;
+    size_t depth() const;
+    size_t numAgents() const;
+
+    //! \brief Trail at voxel, for checks
+    float voxel(size_t x, size_t y, size_t z) const;
+
+    //! \brief Projects volume to `width` x `height` image of trail values, rows top down
+    //! Rays run on ThreadPool::global(), image does not depend on kernels nor number of threads.
+    void render(float* image, size_t width, size_t height, const Camera&, Render) const;
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
@@ -0,0 +1,61 @@
+//! \file thread_pool.h
+//! \brief Worker pool for data-parallel loops
+//!
+//! Each thread starts a loop with contiguous range of chunks, sized by capacity
+//! of CPU it is pinned to (see cpu_topology.h), and takes chunks from its front.
+//! Thread which runs out steals upper half of largest remaining range, so fast
+//! cores of hybrid CPUs are not left waiting for slow ones, while each thread
+//! mostly works on same part of data in every loop.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ThreadPool final
+{
+public:
+    //! Function processing range [begin, end)
+    using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+    //! \brief Creates pool with `numThreads` threads including caller, 0 means hardware concurrency
+    //! NOTE: Emscripten build without pthreads always runs everything on caller thread.
+    explicit ThreadPool(size_t numThreads = 0);
+    ~ThreadPool();
+
+    //! \brief Number of threads working on loops including caller
+    [[nodiscard]] size_t size() const noexcept;
+
+    //! Counters of thread since last resize
+    struct WorkerStats {
+        int cpu = -1;               //!< pinned CPU, -1 when not pinned
+        double busySeconds = 0.0;   //!< time spent running chunks
+        size_t chunks = 0;          //!< chunks run, including stolen ones
+        size_t stolenChunks = 0;    //!< chunks taken from ranges of other threads
+    };
+
+    //! \brief Restarts workers with `numThreads` threads including caller, 0 means hardware concurrency
+    //! Worker i is pinned to cpus[i % cpus.size()] unless `cpus` is empty, caller
+    //! thread is not pinned. Pinning works on Linux only, elsewhere it is ignored.
+    //! Must not be called while other threads use pool or from within loop.
+    void resize(size_t numThreads, const std::vector<int>& cpus = {});
+
+    //! \brief Splits [0, count) into chunks of `chunkSize` and processes them in parallel.
+    //! Blocks until all chunks are done, caller thread takes part. Nested calls
+    //! (from within `fn`) and calls while pool is busy run serially on caller thread.
+    //! Chunks are same for any number of threads and for serial runs, so loops
+    //! whose chunks do not depend on each other give same results on any thread count.
+    void parallelFor(size_t count, size_t chunkSize, const RangeFunction& fn);
+
+    //! \brief Counters of caller (index 0, it takes part in loops) and workers
+    [[nodiscard]] std::vector<WorkerStats> stats() const;
+
+    //! \brief Shared pool used by simulation and view model
+    static ThreadPool& global();
+
+private:
+    class Private;
+    std::unique_ptr<Private> m_p;
+};
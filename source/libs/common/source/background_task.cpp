@@ -0,0 +1,94 @@
+//! \file background_task.cpp
+#include "common/background_task.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define BACKGROUND_TASK_SERIAL 1
+#else
+#define BACKGROUND_TASK_SERIAL 0
+#endif
+
+
+class BackgroundTask::Private final
+{
+public:
+    void workerLoop();
+
+    std::mutex mutex;
+    std::condition_variable startCv;
+    std::condition_variable doneCv;
+    Function task;          //!< set while task is queued or running
+    bool stop = false;
+    std::thread worker;
+};
+
+
+void BackgroundTask::Private::workerLoop()
+{
+    std::unique_lock lock(mutex);
+    for (;;) {
+        startCv.wait(lock, [&] { return stop || task; });
+        if (!task)
+            return;
+        lock.unlock();
+        task();
+        lock.lock();
+        task = nullptr;
+        doneCv.notify_all();
+    }
+}
+
+
+BackgroundTask::BackgroundTask()
+    : m_p(std::make_unique<Private>())
+{
+#if !BACKGROUND_TASK_SERIAL
+    m_p->worker = std::thread([this] { m_p->workerLoop(); });
+#endif
+}
+
+
+BackgroundTask::~BackgroundTask()
+{
+#if !BACKGROUND_TASK_SERIAL
+    {
+        // Worker finishes queued task before it sees stop
+        std::lock_guard lock(m_p->mutex);
+        m_p->stop = true;
+    }
+    m_p->startCv.notify_one();
+    m_p->worker.join();
+#endif
+}
+
+
+void BackgroundTask::start(Function fn)
+{
+#if BACKGROUND_TASK_SERIAL
+    fn();
+#else
+    std::unique_lock lock(m_p->mutex);
+    m_p->doneCv.wait(lock, [&] { return !m_p->task; });
+    m_p->task = std::move(fn);
+    lock.unlock();
+    m_p->startCv.notify_one();
+#endif
+}
+
+
+void BackgroundTask::wait()
+{
+#if !BACKGROUND_TASK_SERIAL
+    std::unique_lock lock(m_p->mutex);
+    m_p->doneCv.wait(lock, [&] { return !m_p->task; });
+#endif
+}
+
+
+bool BackgroundTask::concurrent() noexcept
+{
+    return !BACKGROUND_TASK_SERIAL;
+}
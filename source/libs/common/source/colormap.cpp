@@ -0,0 +1,411 @@
+//! \file colormap.cpp
+#include "common/colormap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(USE_AVX2)
+#include <immintrin.h>
+#elif defined(USE_WASM_SIMD)
+#include <wasm_simd128.h>
+#endif
+
+namespace colormap {
+
+namespace {
+
+constexpr double LANCZOS_LOBES = 3.0;
+//! Weights below this at ends of filter are dropped, zeros of Lanczos come out
+//! of sin with rounding and would add taps to unscaled axis
+constexpr double MIN_WEIGHT = 1e-6;
+
+struct Tap {
+    int32_t index;
+    float weight;
+};
+
+//! Histogram per SIMD lane. Neighbouring cells (and upscaled rows even more)
+//! repeat indices, increments of one bin would wait on each other in single histogram.
+using LaneHistograms = std::array<std::array<uint32_t, HIST_BINS>, 8>;
+
+
+void mergeBins(Stats& stats, const LaneHistograms& hist)
+{
+    for (const auto& h : hist) {
+        for (size_t b = 0; b < HIST_BINS; ++b)
+            stats.hist[b] += h[b];
+    }
+}
+
+#if defined(USE_AVX2)
+// Bins are extracted from register, reloading them from 256-bit store stalls
+// store forwarding and made histogram slower than scaling
+inline void countBins(LaneHistograms& hist, __m256i bins)
+{
+    const __m128i lo = _mm256_castsi256_si128(bins);
+    const __m128i hi = _mm256_extracti128_si256(bins, 1);
+    ++hist[0][_mm_cvtsi128_si32(lo)];
+    ++hist[1][_mm_extract_epi32(lo, 1)];
+    ++hist[2][_mm_extract_epi32(lo, 2)];
+    ++hist[3][_mm_extract_epi32(lo, 3)];
+    ++hist[4][_mm_cvtsi128_si32(hi)];
+    ++hist[5][_mm_extract_epi32(hi, 1)];
+    ++hist[6][_mm_extract_epi32(hi, 2)];
+    ++hist[7][_mm_extract_epi32(hi, 3)];
+}
+#endif
+
+
+double filterSupport(Filter filter)
+{
+    return filter == FILTER_LANCZOS ? LANCZOS_LOBES : 1.0;
+}
+
+
+double filterWeight(Filter filter, double x)
+{
+    x = std::abs(x);
+    if (filter == FILTER_BILINEAR)
+        return x < 1.0 ? 1.0 - x : 0.0;
+    if (x == 0.0)
+        return 1.0;
+    if (x >= LANCZOS_LOBES)
+        return 0.0;
+    const double px = std::numbers::pi * x;
+    return LANCZOS_LOBES * std::sin(px) * std::sin(px / LANCZOS_LOBES) / (px * px);
+}
+
+
+//! Taps of every destination position along one axis, indices are contiguous
+//! before clamping to edges
+std::vector<std::vector<Tap>> axisTaps(size_t src, size_t dst, Filter filter)
+{
+    std::vector<std::vector<Tap>> taps(dst);
+    const double ratio = static_cast<double>(src) / dst;
+    const int64_t last = static_cast<int64_t>(src) - 1;
+    if (filter == FILTER_NEAREST) {
+        for (size_t i = 0; i < dst; ++i)
+            taps[i].push_back({ static_cast<int32_t>(std::min<int64_t>(static_cast<int64_t>((i + 0.5) * ratio), last)), 1.0f });
+        return taps;
+    }
+    // Downscaling widens filter, so every cell contributes
+    const double widen = std::max(1.0, ratio);
+    const double support = filterSupport(filter) * widen;
+    std::vector<double> weights;
+    for (size_t i = 0; i < dst; ++i) {
+        const double center = (i + 0.5) * ratio;
+        const int64_t begin = static_cast<int64_t>(std::floor(center - support));
+        const int64_t end = static_cast<int64_t>(std::ceil(center + support));
+        weights.clear();
+        for (int64_t j = begin; j <= end; ++j)
+            weights.push_back(filterWeight(filter, (j + 0.5 - center) / widen));
+        size_t first = 0, count = weights.size();
+        while (std::abs(weights[first]) < MIN_WEIGHT)
+            ++first;
+        while (std::abs(weights[count - 1]) < MIN_WEIGHT)
+            --count;
+        double sum = 0.0;
+        for (size_t k = first; k < count; ++k)
+            sum += weights[k];
+        for (size_t k = first; k < count; ++k) {
+            const int64_t j = std::clamp<int64_t>(begin + static_cast<int64_t>(k), 0, last);
+            taps[i].push_back({ static_cast<int32_t>(j), static_cast<float>(weights[k] / sum) });
+        }
+    }
+    return taps;
+}
+
+
+//! Horizontal pass of one source row into `stride` values
+void scaleRow(const Scaler& s, const float* src, float* dst, bool simd)
+{
+    size_t x = 0;
+    if (simd) {
+#if defined(USE_AVX2)
+        for (; x < s.stride; x += 8) {
+            __m256 acc = _mm256_setzero_ps();
+            for (size_t k = 0; k < s.tapsX; ++k) {
+                const size_t t = k * s.stride + x;
+                const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s.indexX.data() + t));
+                const __m256 weight = _mm256_loadu_ps(s.weightX.data() + t);
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_i32gather_ps(src, index, 4), weight));
+            }
+            _mm256_storeu_ps(dst + x, acc);
+        }
+#elif defined(USE_WASM_SIMD)
+        // No gather instruction, cells are loaded one by one
+        for (; x < s.stride; x += 4) {
+            v128_t acc = wasm_f32x4_splat(0.0f);
+            for (size_t k = 0; k < s.tapsX; ++k) {
+                const size_t t = k * s.stride + x;
+                const int32_t* index = s.indexX.data() + t;
+                const v128_t cells = wasm_f32x4_make(src[index[0]], src[index[1]], src[index[2]], src[index[3]]);
+                acc = wasm_f32x4_add(acc, wasm_f32x4_mul(cells, wasm_v128_load(s.weightX.data() + t)));
+            }
+            wasm_v128_store(dst + x, acc);
+        }
+#endif
+    }
+    for (; x < s.stride; ++x) {
+        float acc = 0.0f;
+        for (size_t k = 0; k < s.tapsX; ++k) {
+            const size_t t = k * s.stride + x;
+            acc += src[s.indexX[t]] * s.weightX[t];
+        }
+        dst[x] = acc;
+    }
+}
+
+
+//! Vertical pass of horizontally scaled rows and colormap of one display row
+void colormapRow(const float* const* rows, const float* weights, size_t taps, size_t width, uint8_t* pixels,
+    const uint8_t* lut, float scale, Stats& stats, LaneHistograms& hist, bool simd)
+{
+    size_t x = 0;
+    if (simd) {
+#if defined(USE_AVX2)
+        const __m256 kVec   = _mm256_set1_ps(scale);
+        const __m256 maxIdx = _mm256_set1_ps(static_cast<float>(PALETTE_SIZE - 1));
+        const __m256 zero   = _mm256_setzero_ps();
+        __m256 maxVec = zero;
+        __m256 sumVec = zero;
+        for (; x + 8 <= width; x += 8) {
+            __m256 v = zero;
+            for (size_t k = 0; k < taps; ++k)
+                v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + x), _mm256_set1_ps(weights[k])));
+            v = _mm256_max_ps(v, zero);
+            maxVec = _mm256_max_ps(maxVec, v);
+            sumVec = _mm256_add_ps(sumVec, v);
+            const __m256i indices = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_mul_ps(v, kVec), maxIdx));
+            const __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), indices, 4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + x * 4), colors);
+            countBins(hist, _mm256_srli_epi32(indices, HIST_SHIFT));
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, maxVec);
+        stats.max = std::max(stats.max, *std::max_element(lanes, lanes + 8));
+        _mm256_store_ps(lanes, sumVec);
+        for (float v : lanes)
+            stats.sum += v;
+#elif defined(USE_WASM_SIMD)
+        const v128_t kVec   = wasm_f32x4_splat(scale);
+        const v128_t maxIdx = wasm_f32x4_splat(static_cast<float>(PALETTE_SIZE - 1));
+        const v128_t zero   = wasm_f32x4_splat(0.0f);
+        const uint32_t* lutU32 = reinterpret_cast<const uint32_t*>(lut);
+        v128_t maxVec = zero;
+        v128_t sumVec = zero;
+        for (; x + 4 <= width; x += 4) {
+            v128_t v = zero;
+            for (size_t k = 0; k < taps; ++k)
+                v = wasm_f32x4_add(v, wasm_f32x4_mul(wasm_v128_load(rows[k] + x), wasm_f32x4_splat(weights[k])));
+            // pmax(0, v) is (0 < v) ? v : 0, same as scalar code below
+            v = wasm_f32x4_pmax(zero, v);
+            maxVec = wasm_f32x4_max(maxVec, v);
+            sumVec = wasm_f32x4_add(sumVec, v);
+            alignas(16) int32_t indices[4];
+            wasm_v128_store(indices, wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_min(wasm_f32x4_mul(v, kVec), maxIdx)));
+            const v128_t colors = wasm_u32x4_make(
+                lutU32[indices[0]], lutU32[indices[1]],
+                lutU32[indices[2]], lutU32[indices[3]]);
+            wasm_v128_store(pixels + x * 4, colors);
+            for (size_t lane = 0; lane < 4; ++lane)
+                ++hist[lane][indices[lane] >> HIST_SHIFT];
+        }
+        alignas(16) float lanes[4];
+        wasm_v128_store(lanes, maxVec);
+        stats.max = std::max(stats.max, *std::max_element(lanes, lanes + 4));
+        wasm_v128_store(lanes, sumVec);
+        for (float v : lanes)
+            stats.sum += v;
+#endif
+    }
+    const uint32_t* lutU32 = reinterpret_cast<const uint32_t*>(lut);
+    uint32_t* pixelsU32 = reinterpret_cast<uint32_t*>(pixels);
+    for (; x < width; ++x) {
+        float v = 0.0f;
+        for (size_t k = 0; k < taps; ++k)
+            v += rows[k][x] * weights[k];
+        // Lanczos rings below zero, written as maxps so that -0 matches
+        v = v > 0.0f ? v : 0.0f;
+        stats.max = std::max(stats.max, v);
+        stats.sum += v;
+        int c = std::min(v * scale, static_cast<float>(PALETTE_SIZE - 1));
+        pixelsU32[x] = lutU32[c];
+        ++hist[0][c >> HIST_SHIFT];
+    }
+}
+
+} // anonymous namespace
+
+
+void apply(const float* field, uint8_t* pixels, size_t count, const uint8_t* lut, float scale, Stats& stats,
+    SlimeMoldSimulation::Kernels kernels)
+{
+    stats = {};
+    if (kernels == SlimeMoldSimulation::KERNELS_SIMD) {
+#if defined(USE_AVX2)
+        // Initialize scale and clamp
+        const __m256 kVec   = _mm256_set1_ps(scale);
+        const __m256 maxIdx = _mm256_set1_ps(static_cast<float>(PALETTE_SIZE - 1));
+        __m256 maxVec = _mm256_setzero_ps();
+        __m256 sumVec = _mm256_setzero_ps();
+        LaneHistograms hist{};
+
+        // Process 8 pixels at a time
+        constexpr size_t avxWidth = 8;
+        for (size_t i = 0; i < count; i += avxWidth) {
+            // Load 8 field values
+            __m256 fieldVals = _mm256_loadu_ps(field + i);
+            maxVec = _mm256_max_ps(maxVec, fieldVals);
+            sumVec = _mm256_add_ps(sumVec, fieldVals);
+            // Scale and clamp
+            fieldVals = _mm256_mul_ps(fieldVals, kVec);
+            fieldVals = _mm256_min_ps(fieldVals, maxIdx);
+            // Convert to integers (palette indices), truncation matches scalar code
+            __m256i indices = _mm256_cvttps_epi32(fieldVals);
+            // Fetch colors as uint32_t
+            __m256i colors = _mm256_i32gather_epi32(
+                reinterpret_cast<const int*>(lut),  // base pointer (cast to int*)
+                indices,                            // the 8 indices
+                4                                   // scale: each index * 4 bytes
+            );
+            // Store colors to pixels
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4), colors);
+            // Histogram of indices
+            countBins(hist, _mm256_srli_epi32(indices, HIST_SHIFT));
+        }
+        mergeBins(stats, hist);
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, maxVec);
+        stats.max = *std::max_element(lanes, lanes + 8);
+        _mm256_store_ps(lanes, sumVec);
+        for (float v : lanes)
+            stats.sum += v;
+        return;
+#elif defined(USE_WASM_SIMD)
+        const v128_t kVec   = wasm_f32x4_splat(scale);
+        const v128_t maxIdx = wasm_f32x4_splat(static_cast<float>(PALETTE_SIZE - 1));
+        const uint32_t* lutU32 = reinterpret_cast<const uint32_t*>(lut);
+        v128_t maxVec = wasm_f32x4_splat(0.0f);
+        v128_t sumVec = wasm_f32x4_splat(0.0f);
+
+        // Process 4 pixels at a time, truncation matches scalar code
+        constexpr size_t simdWidth = 4;
+        for (size_t i = 0; i < count; i += simdWidth) {
+            v128_t fieldVals = wasm_v128_load(field + i);
+            maxVec = wasm_f32x4_max(maxVec, fieldVals);
+            sumVec = wasm_f32x4_add(sumVec, fieldVals);
+            fieldVals = wasm_f32x4_min(wasm_f32x4_mul(fieldVals, kVec), maxIdx);
+            alignas(16) int32_t indices[4];
+            wasm_v128_store(indices, wasm_i32x4_trunc_sat_f32x4(fieldVals));
+            // No gather instruction, fetch colors one by one
+            const v128_t colors = wasm_u32x4_make(
+                lutU32[indices[0]], lutU32[indices[1]],
+                lutU32[indices[2]], lutU32[indices[3]]);
+            wasm_v128_store(pixels + i * 4, colors);
+            for (int32_t j : indices)
+                ++stats.hist[j >> HIST_SHIFT];
+        }
+        alignas(16) float lanes[4];
+        wasm_v128_store(lanes, maxVec);
+        stats.max = *std::max_element(lanes, lanes + 4);
+        wasm_v128_store(lanes, sumVec);
+        for (float v : lanes)
+            stats.sum += v;
+        return;
+#endif
+    }
+
+    const float k = scale;
+    const uint32_t* lutU32 = reinterpret_cast<const uint32_t*>(lut);
+    uint32_t* pixelsU32 = reinterpret_cast<uint32_t*>(pixels);
+    float maxValue = 0.0f;
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        maxValue = std::max(maxValue, field[i]);
+        sum += field[i];
+        int c = std::min(field[i] * k, static_cast<float>(PALETTE_SIZE - 1));
+        pixelsU32[i] = lutU32[c];
+        ++stats.hist[c >> HIST_SHIFT];
+    }
+    stats.max = maxValue;
+    stats.sum = sum;
+}
+
+
+
+Scaler makeScaler(size_t srcWidth, size_t srcHeight, size_t dstWidth, size_t dstHeight, Filter filter)
+{
+    Scaler s;
+    s.srcWidth = srcWidth;
+    s.srcHeight = srcHeight;
+    s.dstWidth = dstWidth;
+    s.dstHeight = dstHeight;
+    s.stride = (dstWidth + 7) & ~size_t(7);
+
+    // Axes have as many taps as widest position, shorter ones are padded with
+    // weight 0 on their last cell
+    const auto tapsX = axisTaps(srcWidth, dstWidth, filter);
+    const auto tapsY = axisTaps(srcHeight, dstHeight, filter);
+    for (const auto& t : tapsX)
+        s.tapsX = std::max(s.tapsX, t.size());
+    for (const auto& t : tapsY)
+        s.tapsY = std::max(s.tapsY, t.size());
+
+    s.indexX.assign(s.tapsX * s.stride, 0);
+    s.weightX.assign(s.tapsX * s.stride, 0.0f);
+    for (size_t x = 0; x < dstWidth; ++x) {
+        for (size_t k = 0; k < s.tapsX; ++k) {
+            const bool pad = k >= tapsX[x].size();
+            s.indexX[k * s.stride + x] = pad ? tapsX[x].back().index : tapsX[x][k].index;
+            s.weightX[k * s.stride + x] = pad ? 0.0f : tapsX[x][k].weight;
+        }
+    }
+    s.indexY.assign(dstHeight * s.tapsY, 0);
+    s.weightY.assign(dstHeight * s.tapsY, 0.0f);
+    for (size_t y = 0; y < dstHeight; ++y) {
+        for (size_t k = 0; k < s.tapsY; ++k) {
+            const bool pad = k >= tapsY[y].size();
+            s.indexY[y * s.tapsY + k] = pad ? tapsY[y].back().index : tapsY[y][k].index;
+            s.weightY[y * s.tapsY + k] = pad ? 0.0f : tapsY[y][k].weight;
+        }
+    }
+    return s;
+}
+
+
+void applyScaled(const Scaler& scaler, const float* field, uint8_t* pixels, size_t rowBegin, size_t rowEnd,
+    const uint8_t* lut, float scale, Stats& stats, SlimeMoldSimulation::Kernels kernels)
+{
+    stats = {};
+    const Scaler& s = scaler;
+    const bool simd = kernels == SlimeMoldSimulation::KERNELS_SIMD;
+    // Horizontally scaled source rows, row r is kept in slot r % tapsY. Rows of
+    // one display row are contiguous (or repeated edge), so they do not evict
+    // each other, and consecutive display rows reuse most of them.
+    const size_t slots = s.tapsY;
+    std::vector<float> rows(slots * s.stride);
+    std::vector<int32_t> slotRow(slots, -1);
+    std::vector<const float*> tapRows(s.tapsY);
+    LaneHistograms hist{};
+    for (size_t y = rowBegin; y < rowEnd; ++y) {
+        // === Step 1: Horizontal pass of source rows not scaled yet ===
+        for (size_t k = 0; k < s.tapsY; ++k) {
+            const int32_t r = s.indexY[y * s.tapsY + k];
+            const size_t slot = static_cast<size_t>(r) % slots;
+            float* row = rows.data() + slot * s.stride;
+            if (slotRow[slot] != r) {
+                scaleRow(s, field + static_cast<size_t>(r) * s.srcWidth, row, simd);
+                slotRow[slot] = r;
+            }
+            tapRows[k] = row;
+        }
+        // === Step 2: Vertical pass fused with colormap ===
+        colormapRow(tapRows.data(), s.weightY.data() + y * s.tapsY, s.tapsY, s.dstWidth,
+            pixels + y * s.dstWidth * 4, lut, scale, stats, hist, simd);
+    }
+    mergeBins(stats, hist);
+}
+
+} // namespace colormap
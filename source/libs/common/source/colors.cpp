@@ -9,7 +9,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <list>
+#include <mutex>
 
 namespace {
 
@@ -35,8 +38,58 @@ inline float gammaCorrect(float c)
 }
 
 
+// ==== Lookup tables ====================================================
+
+std::atomic<bool> g_useLookupTables = false;
+
+// Number of intervals, table has one more entry
+constexpr size_t GAMMA_LUT_SIZE = 4096;
+
+struct GammaTables
+{
+    std::array<float, GAMMA_LUT_SIZE + 1> toLinear;
+    std::array<float, GAMMA_LUT_SIZE + 1> toSrgb;
+};
+
+
+const GammaTables& gammaTables()
+{
+    static const GammaTables tables = [] {
+        GammaTables t;
+        for (size_t i = 0; i <= GAMMA_LUT_SIZE; ++i) {
+            const float c = static_cast<float>(i) / GAMMA_LUT_SIZE;
+            t.toLinear[i] = invGamma(c);
+            t.toSrgb[i]   = gammaCorrect(c);
+        }
+        return t;
+    }();
+    return tables;
+}
+
+
+// Linear interpolation in table of GAMMA_LUT_SIZE+1 entries, input is clamped to 0..1
+inline float lookupGamma(const std::array<float, GAMMA_LUT_SIZE + 1>& table, float c)
+{
+    c = std::clamp(c, 0.0f, 1.0f) * GAMMA_LUT_SIZE;
+    const size_t i = std::min(static_cast<size_t>(c), GAMMA_LUT_SIZE - 1);
+    const float f = c - static_cast<float>(i);
+    return table[i] + f * (table[i + 1] - table[i]);
+}
+
+
+// sRGB → Linear RGB, uses table if enabled
+inline float decodeGamma(float c)
+{
+    return g_useLookupTables
+        ? lookupGamma(gammaTables().toLinear, c)
+        : invGamma(c);
+}
+
+
 inline float gammaCorrectAndLimit(float c)
 {
+    if (g_useLookupTables)
+        return lookupGamma(gammaTables().toSrgb, c);
     c = gammaCorrect(c);
     c = std::clamp(c, 0.0f, 1.0f);
     return c;
@@ -49,6 +102,117 @@ inline color::Rgb gammaCorrectAndLimit(const color::Rgb &color)
 }
 
 
+// OkLab → linear RGB (without clamping)
+inline color::Rgb okLabToLinear(const color::OkLab& lab)
+{
+    // 1. OKLab → LMS nonlinear
+    const float l_ = lab.L + 0.3963377774f * lab.a + 0.2158037573f * lab.b;
+    const float m_ = lab.L - 0.1055613458f * lab.a - 0.0638541728f * lab.b;
+    const float s_ = lab.L - 0.0894841775f * lab.a - 1.2914855480f * lab.b;
+
+    // 2. Remove nonlinearity (cube)
+    const float l = l_ * l_ * l_;
+    const float m = m_ * m_ * m_;
+    const float s = s_ * s_ * s_;
+
+    // 3. LMS → linear sRGB
+    return {
+        +4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s,
+        -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s,
+        -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s
+    };
+}
+
+
+// OkLab → linear RGB grid, L in 0..1, a and b in -0.5..0.5 (sRGB gamut is well inside)
+constexpr size_t OKLAB_LUT_SIZE = 33;
+constexpr float  OKLAB_LUT_AB_MIN = -0.5f;
+constexpr float  OKLAB_LUT_AB_RANGE = 1.0f;
+
+using OkLabLut = std::vector<color::Rgb>;
+
+
+const OkLabLut& okLabLut()
+{
+    static const OkLabLut lut = [] {
+        constexpr size_t n = OKLAB_LUT_SIZE;
+        constexpr float step = 1.0f / (n - 1);
+        OkLabLut t(n * n * n);
+        for (size_t iL = 0; iL < n; ++iL) {
+            for (size_t ia = 0; ia < n; ++ia) {
+                for (size_t ib = 0; ib < n; ++ib) {
+                    const color::OkLab lab{
+                        iL * step,
+                        OKLAB_LUT_AB_MIN + ia * step * OKLAB_LUT_AB_RANGE,
+                        OKLAB_LUT_AB_MIN + ib * step * OKLAB_LUT_AB_RANGE
+                    };
+                    t[(iL * n + ia) * n + ib] = okLabToLinear(lab);
+                }
+            }
+        }
+        return t;
+    }();
+    return lut;
+}
+
+
+// Trilinear lookup in OkLab LUT, coordinates outside of grid are clamped
+color::Rgb okLabToLinearLut(const color::OkLab& lab)
+{
+    constexpr size_t n = OKLAB_LUT_SIZE;
+    const OkLabLut& lut = okLabLut();
+
+    auto gridCoord = [](float v, size_t& i, float& f) {
+        v = std::clamp(v, 0.0f, 1.0f) * (n - 1);
+        i = std::min(static_cast<size_t>(v), n - 2);
+        f = v - static_cast<float>(i);
+    };
+    size_t iL, ia, ib;
+    float fL, fa, fb;
+    gridCoord(lab.L, iL, fL);
+    gridCoord((lab.a - OKLAB_LUT_AB_MIN) / OKLAB_LUT_AB_RANGE, ia, fa);
+    gridCoord((lab.b - OKLAB_LUT_AB_MIN) / OKLAB_LUT_AB_RANGE, ib, fb);
+
+    auto lerp = [](const color::Rgb& p, const color::Rgb& q, float t) -> color::Rgb {
+        return { p.r + t * (q.r - p.r), p.g + t * (q.g - p.g), p.b + t * (q.b - p.b) };
+    };
+    auto at = [&](size_t dL, size_t da, size_t db) -> const color::Rgb& {
+        return lut[((iL + dL) * n + ia + da) * n + ib + db];
+    };
+
+    const color::Rgb c00 = lerp(at(0, 0, 0), at(0, 0, 1), fb);
+    const color::Rgb c01 = lerp(at(0, 1, 0), at(0, 1, 1), fb);
+    const color::Rgb c10 = lerp(at(1, 0, 0), at(1, 0, 1), fb);
+    const color::Rgb c11 = lerp(at(1, 1, 0), at(1, 1, 1), fb);
+    return lerp(lerp(c00, c01, fa), lerp(c10, c11, fa), fL);
+}
+
+
+// ==== Gradient cache ===================================================
+
+constexpr size_t GRADIENT_CACHE_CAPACITY = 32;
+
+struct GradientCacheEntry
+{
+    color::GradientFunction gradientFn;
+    color::Rgb startRgb, endRgb;
+    std::size_t length;
+    bool useLookupTables;
+    std::vector<color::Rgb> gradient;
+};
+
+
+inline bool sameRgb(const color::Rgb& a, const color::Rgb& b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+
+std::mutex g_gradientCacheMutex;
+// Most recently used first
+std::list<GradientCacheEntry> g_gradientCache;
+
+
 std::array<float, 3> lchDeltas(const float* lchStart, const float* lchEnd, size_t steps)
 {
     const float deltaL = lchEnd[0] - lchStart[0];
@@ -118,9 +282,9 @@ OkLch okLabToLch(const OkLab& lab)
 
 CieLab cieLabFromRgb(const Rgb& rgb)
 {
-    const float r = invGamma(rgb.r);
-    const float g = invGamma(rgb.g);
-    const float b = invGamma(rgb.b);
+    const float r = decodeGamma(rgb.r);
+    const float g = decodeGamma(rgb.g);
+    const float b = decodeGamma(rgb.b);
 
     // Convert to XYZ (sRGB D65)
     float x = r * 0.4124f + g * 0.3576f + b * 0.1805f;
@@ -184,9 +348,9 @@ Rgb cieLabToRgb(const CieLab& lab)
 OkLab okLabFromRgb(const Rgb& rgb)
 {
     // 1. sRGB → linear
-    const float r = invGamma(rgb.r);
-    const float g = invGamma(rgb.g);
-    const float b = invGamma(rgb.b);
+    const float r = decodeGamma(rgb.r);
+    const float g = decodeGamma(rgb.g);
+    const float b = decodeGamma(rgb.b);
 
     // 2. Linear sRGB → LMS
     const float l = 0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b;
@@ -209,24 +373,10 @@ OkLab okLabFromRgb(const Rgb& rgb)
 
 Rgb okLabToRgb(const OkLab& lab)
 {
-    // 1. OKLab → LMS nonlinear
-    const float l_ = lab.L + 0.3963377774f * lab.a + 0.2158037573f * lab.b;
-    const float m_ = lab.L - 0.1055613458f * lab.a - 0.0638541728f * lab.b;
-    const float s_ = lab.L - 0.0894841775f * lab.a - 1.2914855480f * lab.b;
-
-    // 2. Remove nonlinearity (cube)
-    const float l = l_ * l_ * l_;
-    const float m = m_ * m_ * m_;
-    const float s = s_ * s_ * s_;
-
-    // 3. LMS → linear sRGB
-    const Rgb rgb{
-        +4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s,
-        -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s,
-        -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s
-    };
-
-    // 4. Linear → sRGB (gamma encode)
+    // OKLab → linear sRGB, then gamma encode
+    const Rgb rgb = g_useLookupTables
+        ? okLabToLinearLut(lab)
+        : okLabToLinear(lab);
     return gammaCorrectAndLimit(rgb);
 }
 
@@ -360,4 +510,53 @@ std::vector<Rgb> gradientRgb(const Rgb& startRgb, const Rgb& endRgb, std::size_t
     return gradient;
 }
 
+
+void setUseLookupTables(bool enable)
+{
+    g_useLookupTables = enable;
+}
+
+
+bool useLookupTables()
+{
+    return g_useLookupTables;
+}
+
+
+std::vector<Rgb> gradientCached(GradientFunction gradientFn, const Rgb& startRgb, const Rgb& endRgb, std::size_t length)
+{
+    const bool lut = g_useLookupTables;
+    {
+        std::lock_guard lock(g_gradientCacheMutex);
+        auto it = std::ranges::find_if(g_gradientCache, [&](const GradientCacheEntry& e) {
+            return e.gradientFn == gradientFn
+                && e.length == length
+                && e.useLookupTables == lut
+                && sameRgb(e.startRgb, startRgb)
+                && sameRgb(e.endRgb, endRgb);
+        });
+        if (it != g_gradientCache.end()) {
+            // move to front
+            g_gradientCache.splice(g_gradientCache.begin(), g_gradientCache, it);
+            return it->gradient;
+        }
+    }
+
+    // Generate outside of lock, concurrent misses of same key just insert duplicate
+    std::vector<Rgb> gradient = gradientFn(startRgb, endRgb, length);
+
+    std::lock_guard lock(g_gradientCacheMutex);
+    g_gradientCache.push_front({ gradientFn, startRgb, endRgb, length, lut, gradient });
+    if (g_gradientCache.size() > GRADIENT_CACHE_CAPACITY)
+        g_gradientCache.pop_back();
+    return gradient;
+}
+
+
+void clearGradientCache()
+{
+    std::lock_guard lock(g_gradientCacheMutex);
+    g_gradientCache.clear();
+}
+
 } // namespace color
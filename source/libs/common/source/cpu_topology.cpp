@@ -0,0 +1,133 @@
+//! \file cpu_topology.cpp
+#include "common/cpu_topology.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <utility>
+
+namespace {
+
+#if defined(__linux__)
+const std::string SYSFS_CPU = "/sys/devices/system/cpu/";
+
+
+// First line of sysfs file, empty if it does not exist
+std::string readLine(const std::string& path)
+{
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+
+// Number in sysfs file, `fallback` if it does not exist
+long readNumber(const std::string& path, long fallback)
+{
+    const std::string line = readLine(path);
+    long value = 0;
+    const auto [end, ec] = std::from_chars(line.data(), line.data() + line.size(), value);
+    return ec == std::errc() ? value : fallback;
+}
+#endif
+
+
+bool parseInt(std::string_view s, int& value)
+{
+    const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && end == s.data() + s.size() && value >= 0;
+}
+
+} // anonymous namespace
+
+
+std::vector<int> parseCpuList(std::string_view list)
+{
+    std::vector<int> cpus;
+    while (!list.empty() && (list.back() == '\n' || list.back() == ' '))
+        list.remove_suffix(1);
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        const std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+        const size_t dash = item.find('-');
+        int first = 0, last = 0;
+        if (!parseInt(item.substr(0, dash), first))
+            return {};
+        last = first;
+        if (dash != std::string_view::npos && (!parseInt(item.substr(dash + 1), last) || last < first))
+            return {};
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    std::ranges::sort(cpus);
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+
+std::vector<CpuInfo> cpuTopology()
+{
+    std::vector<CpuInfo> result;
+#if defined(__linux__)
+    const std::vector<int> online = parseCpuList(readLine(SYSFS_CPU + "online"));
+    const std::vector<int> atoms = parseCpuList(readLine("/sys/devices/cpu_atom/cpus"));
+    long maxPerformance = 0;
+    std::vector<long> performance;
+    for (int id : online) {
+        const std::string dir = SYSFS_CPU + "cpu" + std::to_string(id) + "/";
+        CpuInfo cpu;
+        cpu.id = id;
+        cpu.package = static_cast<int>(readNumber(dir + "topology/physical_package_id", 0));
+        cpu.core = static_cast<int>(readNumber(dir + "topology/core_id", id));
+        cpu.efficient = std::ranges::binary_search(atoms, id);
+        // Capacity is already scaled to 1024, frequency is scaled below
+        long p = readNumber(dir + "cpu_capacity", -1);
+        if (p < 0)
+            p = readNumber(dir + "cpufreq/cpuinfo_max_freq", 0);
+        performance.push_back(p);
+        maxPerformance = std::max(maxPerformance, p);
+        result.push_back(cpu);
+    }
+    for (size_t i = 0; i < result.size(); ++i) {
+        if (maxPerformance > 0 && performance[i] > 0)
+            result[i].capacity = static_cast<uint32_t>(performance[i] * 1024 / maxPerformance);
+        // Big.LITTLE parts have no atom list
+        result[i].efficient = result[i].efficient || result[i].capacity < 768;
+    }
+#endif
+    return result;
+}
+
+
+std::vector<int> cpusOnePerCore(const std::vector<CpuInfo>& cpus)
+{
+    // First SMT sibling of each core
+    std::vector<CpuInfo> cores;
+    for (const CpuInfo& cpu : cpus) {
+        if (std::ranges::none_of(cores, [&](const CpuInfo& c) { return c.package == cpu.package && c.core == cpu.core; }))
+            cores.push_back(cpu);
+    }
+    // Rank of core within its package, so that packages alternate
+    std::ranges::stable_sort(cores, [](const CpuInfo& a, const CpuInfo& b) { return a.capacity > b.capacity; });
+    std::vector<std::pair<size_t, size_t>> order;   // (rank, index)
+    for (size_t i = 0; i < cores.size(); ++i) {
+        const auto rank = std::count_if(cores.begin(), cores.begin() + i, [&](const CpuInfo& c) {
+            return c.package == cores[i].package && c.capacity == cores[i].capacity;
+        });
+        order.emplace_back(static_cast<size_t>(rank), i);
+    }
+    // Faster cores first, within same capacity packages take turns
+    std::ranges::stable_sort(order, [&](const auto& a, const auto& b) {
+        const uint32_t ca = cores[a.second].capacity, cb = cores[b.second].capacity;
+        if (ca != cb)
+            return ca > cb;
+        return a.first != b.first ? a.first < b.first : cores[a.second].package < cores[b.second].package;
+    });
+    std::vector<int> result;
+    for (const auto& [rank, index] : order)
+        result.push_back(cores[index].id);
+    return result;
+}
@@ -0,0 +1,253 @@
+//! \file event_log.cpp
+#include "common/event_log.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+constexpr uint32_t MAGIC   = 0x474c4d53; // "SMLG"
+constexpr uint32_t VERSION = 2;  // 2 added EVENT_OPTION, 1 is still readable
+
+constexpr size_t AGENT_FLOATS   = 6;
+constexpr size_t PALETTE_FLOATS = 9;
+
+
+// NOTE: values are written in host byte order, all supported targets are little endian
+template<typename T>
+void put(std::vector<uint8_t>& out, T value)
+{
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+
+class Reader
+{
+public:
+    explicit Reader(const std::vector<uint8_t>& data) : m_data(data) {}
+
+    template<typename T>
+    bool get(T& value)
+    {
+        if (m_pos + sizeof(T) > m_data.size())
+            return false;
+        std::memcpy(&value, &m_data[m_pos], sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool getVarint(uint64_t& value)
+    {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            uint8_t b;
+            if (!get(b))
+                return false;
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool atEnd() const { return m_pos == m_data.size(); }
+
+private:
+    const std::vector<uint8_t>& m_data;
+    size_t m_pos = 0;
+};
+
+} // anonymous namespace
+
+
+void EventLog::addAgent(uint64_t step, const AgentPreset& agent)
+{
+    Event e;
+    e.step = step;
+    e.type = EVENT_AGENT;
+    e.agent = agent;
+    e.agent.name = {};
+    events.push_back(e);
+}
+
+
+void EventLog::addPalette(uint64_t step, const std::array<color::Rgb, 3>& palette)
+{
+    Event e;
+    e.step = step;
+    e.type = EVENT_PALETTE;
+    e.palette = palette;
+    events.push_back(e);
+}
+
+
+void EventLog::addReset(uint64_t step)
+{
+    Event e;
+    e.step = step;
+    e.type = EVENT_RESET;
+    events.push_back(e);
+}
+
+
+void EventLog::addResetAgents(uint64_t step)
+{
+    Event e;
+    e.step = step;
+    e.type = EVENT_RESET_AGENTS;
+    events.push_back(e);
+}
+
+
+void EventLog::addOption(uint64_t step, Option option, uint32_t value)
+{
+    Event e;
+    e.step = step;
+    e.type = EVENT_OPTION;
+    e.option = option;
+    e.value = value;
+    events.push_back(e);
+}
+
+
+void EventLog::addEnd(uint64_t step, uint64_t fieldHash)
+{
+    Event e;
+    e.step = step;
+    e.type = EVENT_END;
+    e.fieldHash = fieldHash;
+    events.push_back(e);
+}
+
+
+bool EventLog::save(const std::string& path) const
+{
+    std::vector<uint8_t> out;
+    for (uint32_t v : { MAGIC, VERSION, width, height, numAgents, seed })
+        put(out, v);
+
+    uint64_t lastStep = 0;
+    for (const auto& e : events) {
+        putVarint(out, e.step - lastStep);
+        lastStep = e.step;
+        put(out, static_cast<uint8_t>(e.type));
+        switch (e.type) {
+        case EVENT_AGENT:
+            for (float v : { e.agent.sensor_angle, e.agent.sensor_dist, e.agent.turn_angle,
+                             e.agent.step_size, e.agent.evaporate, e.agent.palette_mid })
+                put(out, v);
+            break;
+        case EVENT_PALETTE:
+            for (const auto& c : e.palette) {
+                put(out, c.r);
+                put(out, c.g);
+                put(out, c.b);
+            }
+            break;
+        case EVENT_END:
+            put(out, e.fieldHash);
+            break;
+        case EVENT_OPTION:
+            put(out, static_cast<uint8_t>(e.option));
+            put(out, e.value);
+            break;
+        case EVENT_RESET:
+        case EVENT_RESET_AGENTS:
+            break;
+        }
+    }
+
+    std::ofstream f(path, std::ios::binary);
+    f.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(f);
+}
+
+
+bool EventLog::load(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        return false;
+    const std::vector<uint8_t> data{ std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+    Reader r(data);
+
+    uint32_t magic = 0, version = 0;
+    if (!r.get(magic) || !r.get(version) || magic != MAGIC || version == 0 || version > VERSION)
+        return false;
+    if (!r.get(width) || !r.get(height) || !r.get(numAgents) || !r.get(seed))
+        return false;
+
+    events.clear();
+    uint64_t step = 0;
+    while (!r.atEnd()) {
+        uint64_t delta;
+        uint8_t type;
+        if (!r.getVarint(delta) || !r.get(type))
+            return false;
+        step += delta;
+        Event e;
+        e.step = step;
+        e.type = static_cast<EventType>(type);
+        bool ok = true;
+        switch (e.type) {
+        case EVENT_AGENT: {
+            float v[AGENT_FLOATS];
+            for (float& x : v)
+                ok = ok && r.get(x);
+            e.agent = { {}, v[0], v[1], v[2], v[3], v[4], v[5] };
+            break;
+        }
+        case EVENT_PALETTE: {
+            float v[PALETTE_FLOATS];
+            for (float& x : v)
+                ok = ok && r.get(x);
+            for (size_t i = 0; i < 3; ++i)
+                e.palette[i] = { v[i * 3], v[i * 3 + 1], v[i * 3 + 2] };
+            break;
+        }
+        case EVENT_END:
+            ok = r.get(e.fieldHash);
+            break;
+        case EVENT_OPTION: {
+            uint8_t option = 0;
+            ok = r.get(option) && r.get(e.value);
+            e.option = static_cast<Option>(option);
+            break;
+        }
+        case EVENT_RESET:
+        case EVENT_RESET_AGENTS:
+            break;
+        default:
+            ok = false;
+        }
+        if (!ok)
+            return false;
+        events.push_back(e);
+    }
+    return true;
+}
+
+
+uint64_t EventLog::fieldHash(const float* field, size_t count)
+{
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t bits;
+        std::memcpy(&bits, &field[i], sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,675 @@
+//! \file field_stream.cpp
+#include "common/field_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define FIELD_STREAM_SERIAL 1
+#else
+#define FIELD_STREAM_SERIAL 0
+#endif
+
+namespace {
+
+constexpr uint32_t MAGIC         = 0x53464d53; // "SMFS"
+constexpr uint32_t VERSION       = 1;
+constexpr uint32_t CHUNK_MAGIC   = 0x454d5246; // "FRME"
+constexpr uint32_t INDEX_MAGIC   = 0x58444e49; // "INDX"
+constexpr uint32_t TRAILER_MAGIC = 0x444e4553; // "SEND"
+
+constexpr size_t HEADER_BYTES  = 8 * sizeof(uint32_t);
+constexpr size_t CHUNK_BYTES   = 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+constexpr size_t INDEX_BYTES   = sizeof(uint32_t) + sizeof(uint64_t);
+constexpr size_t ENTRY_BYTES   = 2 * sizeof(uint64_t);
+constexpr size_t TRAILER_BYTES = sizeof(uint64_t) + sizeof(uint32_t);
+
+constexpr size_t BLOCK_CELLS = 65536;
+constexpr uint32_t BLOCK_STORED = 0x80000000u;
+constexpr uint64_t KEYFRAME_BIT = uint64_t(1) << 63;
+constexpr unsigned MANTISSA_BITS = 23;
+
+//! Limits of field read from header, corrupted header must not allocate gigabytes
+constexpr uint32_t MAX_SIDE = 65536;
+constexpr uint64_t MAX_CELLS = uint64_t(1) << 28;
+//! Codec decodes at most 255 bytes per byte read (length continuation), frame
+//! of N bytes takes more than N / MAX_EXPANSION bytes of file
+constexpr uint64_t MAX_EXPANSION = 256;
+
+//! Frames queued for background thread before write() blocks
+constexpr size_t MAX_PENDING = 4;
+
+enum FrameType : uint32_t {
+    FRAME_KEY   = 0,
+    FRAME_DELTA = 1,
+};
+
+
+// NOTE: values are written in host byte order, all supported targets are little endian
+template<typename T>
+void put(std::vector<uint8_t>& out, T value)
+{
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+
+template<typename T>
+T get(const uint8_t* p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+
+// ==== LZ codec =========================================================
+// Sequences as in LZ4 block format: token with literal count (high nibble) and
+// match length - MIN_MATCH (low nibble), value 15 continues in bytes up to 255,
+// literals, uint16 offset. Last sequence has literals only.
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t HASH_BITS = 14;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr uint32_t NO_POSITION = 0xffffffffu;
+
+
+void putLength(std::vector<uint8_t>& out, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        out.push_back(255);
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+
+void lzCompress(const uint8_t* src, size_t n, std::vector<uint8_t>& out, std::vector<uint32_t>& table)
+{
+    table.assign(size_t(1) << HASH_BITS, NO_POSITION);
+    auto hash = [](uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); };
+    auto emitLiterals = [&](size_t anchor, size_t end, size_t matchCode) {
+        const size_t count = end - anchor;
+        out.push_back(static_cast<uint8_t>((std::min<size_t>(count, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (count >= 15)
+            putLength(out, count - 15);
+        out.insert(out.end(), src + anchor, src + end);
+    };
+
+    out.clear();
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + MIN_MATCH <= n) {
+        const uint32_t v = get<uint32_t>(src + i);
+        const uint32_t h = hash(v);
+        const uint32_t candidate = table[h];
+        table[h] = static_cast<uint32_t>(i);
+        if (candidate == NO_POSITION || i - candidate > MAX_OFFSET || get<uint32_t>(src + candidate) != v) {
+            // Skip faster through data without matches
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+        size_t length = MIN_MATCH;
+        while (i + length < n && src[candidate + length] == src[i + length])
+            ++length;
+        const size_t offset = i - candidate;
+        emitLiterals(anchor, i, length - MIN_MATCH);
+        out.push_back(static_cast<uint8_t>(offset));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+        if (length - MIN_MATCH >= 15)
+            putLength(out, length - MIN_MATCH - 15);
+        i += length;
+        anchor = i;
+    }
+    emitLiterals(anchor, n, 0);
+}
+
+
+// Checks all bounds, file may be corrupted
+bool lzDecompress(const uint8_t* src, size_t n, uint8_t* dst, size_t dstSize)
+{
+    size_t ip = 0, op = 0;
+    auto getLength = [&](size_t& length) {
+        uint8_t b;
+        do {
+            if (ip >= n)
+                return false;
+            b = src[ip++];
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+    for (;;) {
+        if (ip >= n)
+            return false;
+        const uint8_t token = src[ip++];
+        size_t count = token >> 4;
+        if (count == 15 && !getLength(count))
+            return false;
+        if (count > n - ip || count > dstSize - op)
+            return false;
+        std::memcpy(dst + op, src + ip, count);
+        ip += count;
+        op += count;
+        if (ip == n)
+            return op == dstSize;
+
+        if (n - ip < 2)
+            return false;
+        const size_t offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        size_t length = token & 15;
+        if (length == 15 && !getLength(length))
+            return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > op || length > dstSize - op)
+            return false;
+        if (offset >= length)
+            std::memcpy(dst + op, dst + op - offset, length);
+        else {
+            // Overlapping match repeats last `offset` bytes
+            for (size_t k = 0; k < length; ++k)
+                dst[op + k] = dst[op + k - offset];
+        }
+        op += length;
+    }
+}
+
+} // anonymous namespace
+
+
+// ==== Writer ===========================================================
+
+class FieldStreamWriter::Private final
+{
+public:
+    void writeBytes(const void* data, size_t n);
+    void encodeAndWrite(uint64_t step, const float* field);
+    void workerLoop();
+
+    std::FILE* file = nullptr;
+    bool ownsFile = false;
+    size_t cells = 0;
+    uint32_t flags = 0;
+    size_t keyframeInterval = 1;
+    uint32_t roundBias = 0;                 // rounding of dropped mantissa bits
+    uint32_t keepMask = ~0u;
+
+    //! Written by background thread, read by frames() and bytes()
+    std::atomic<uint64_t> offset = 0;
+    std::atomic<size_t> framesWritten = 0;
+    std::atomic<bool> failed = false;
+    std::vector<uint64_t> index;            // step, offset pairs
+
+    //! Encoder state and scratch buffers
+    std::vector<uint32_t> previous;
+    std::vector<uint8_t> planes, compressed, chunk;
+    std::vector<uint32_t> hashTable;
+
+    //! Queue of copied fields, buffers are reused
+    struct Pending {
+        uint64_t step;
+        std::vector<float> field;
+    };
+    std::mutex mutex;
+    std::condition_variable workCv;
+    std::condition_variable spaceCv;
+    std::deque<Pending> queue;
+    std::vector<std::vector<float>> freeBuffers;
+    bool closing = false;
+    std::thread worker;
+};
+
+
+void FieldStreamWriter::Private::writeBytes(const void* data, size_t n)
+{
+    if (std::fwrite(data, 1, n, file) != n)
+        failed = true;
+    offset += n;
+}
+
+
+void FieldStreamWriter::Private::encodeAndWrite(uint64_t step, const float* field)
+{
+    const size_t frame = framesWritten;
+    const bool key = !(flags & FLAG_DELTA) || frame % keyframeInterval == 0;
+
+    // === Step 1: Blocks of differences split to byte planes, compressed when it helps ===
+    // Keyframe predicts cell from its left neighbour, delta frame from previous frame
+    chunk.assign(CHUNK_BYTES, 0);
+    for (size_t begin = 0; begin < cells; begin += BLOCK_CELLS) {
+        const size_t count = std::min(BLOCK_CELLS, cells - begin);
+        planes.resize(count * 4);
+        uint32_t left = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t bits = (std::bit_cast<uint32_t>(field[begin + i]) + roundBias) & keepMask;
+            const uint32_t v = bits - (key ? left : previous[begin + i]);
+            left = bits;
+            previous[begin + i] = bits;
+            planes[i]             = static_cast<uint8_t>(v);
+            planes[count + i]     = static_cast<uint8_t>(v >> 8);
+            planes[count * 2 + i] = static_cast<uint8_t>(v >> 16);
+            planes[count * 3 + i] = static_cast<uint8_t>(v >> 24);
+        }
+        if (flags & FLAG_LZ) {
+            lzCompress(planes.data(), planes.size(), compressed, hashTable);
+            if (compressed.size() < planes.size()) {
+                put(chunk, static_cast<uint32_t>(compressed.size()));
+                chunk.insert(chunk.end(), compressed.begin(), compressed.end());
+                continue;
+            }
+        }
+        put(chunk, static_cast<uint32_t>(planes.size()) | BLOCK_STORED);
+        chunk.insert(chunk.end(), planes.begin(), planes.end());
+    }
+
+    // === Step 2: Chunk header and write ===
+    const uint32_t type = key ? FRAME_KEY : FRAME_DELTA;
+    const uint64_t payload = chunk.size() - CHUNK_BYTES;
+    std::memcpy(&chunk[0], &CHUNK_MAGIC, 4);
+    std::memcpy(&chunk[4], &type, 4);
+    std::memcpy(&chunk[8], &step, 8);
+    std::memcpy(&chunk[16], &payload, 8);
+    index.push_back(step);
+    index.push_back(offset | (key ? KEYFRAME_BIT : 0));
+    writeBytes(chunk.data(), chunk.size());
+    ++framesWritten;
+}
+
+
+void FieldStreamWriter::Private::workerLoop()
+{
+    std::unique_lock lock(mutex);
+    for (;;) {
+        workCv.wait(lock, [this] { return !queue.empty() || closing; });
+        if (queue.empty())
+            return;
+        // Frame stays in queue while encoded, so it counts as pending
+        Pending& p = queue.front();
+        lock.unlock();
+        encodeAndWrite(p.step, p.field.data());
+        lock.lock();
+        freeBuffers.push_back(std::move(p.field));
+        queue.pop_front();
+        spaceCv.notify_one();
+    }
+}
+
+
+FieldStreamWriter::FieldStreamWriter(const std::string& path, size_t width, size_t height, uint32_t flags,
+    size_t keyframeInterval, unsigned mantissaBits)
+    : m_p(std::make_unique<Private>())
+{
+    if (path == "-") {
+#if defined(_WIN32)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        m_p->file = stdout;
+    }
+    else {
+        m_p->file = std::fopen(path.c_str(), "wb");
+        m_p->ownsFile = true;
+    }
+    if (!m_p->file)
+        return;
+
+    m_p->cells = width * height;
+    m_p->flags = flags;
+    m_p->keyframeInterval = std::max<size_t>(keyframeInterval, 1);
+    m_p->previous.resize(m_p->cells);
+    // Rounding may carry into exponent, which is still nearest representable value
+    mantissaBits = std::min(mantissaBits, MANTISSA_BITS);
+    const unsigned dropped = MANTISSA_BITS - mantissaBits;
+    m_p->roundBias = dropped > 0 ? uint32_t(1) << (dropped - 1) : 0;
+    m_p->keepMask = ~((uint32_t(1) << dropped) - 1);
+
+    std::vector<uint8_t> header;
+    for (uint32_t v : { MAGIC, VERSION, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+                        flags, static_cast<uint32_t>(m_p->keyframeInterval), static_cast<uint32_t>(BLOCK_CELLS),
+                        static_cast<uint32_t>(mantissaBits) })
+        put(header, v);
+    m_p->writeBytes(header.data(), header.size());
+#if !FIELD_STREAM_SERIAL
+    m_p->worker = std::thread([this] { m_p->workerLoop(); });
+#endif
+}
+
+
+FieldStreamWriter::~FieldStreamWriter()
+{
+    close();
+}
+
+
+bool FieldStreamWriter::valid() const noexcept
+{
+    return m_p->file != nullptr && !m_p->failed;
+}
+
+
+bool FieldStreamWriter::write(uint64_t step, const float* field)
+{
+    if (!m_p->file || m_p->failed)
+        return false;
+#if FIELD_STREAM_SERIAL
+    m_p->encodeAndWrite(step, field);
+#else
+    std::vector<float> buffer;
+    {
+        std::unique_lock lock(m_p->mutex);
+        m_p->spaceCv.wait(lock, [this] { return m_p->queue.size() < MAX_PENDING; });
+        if (!m_p->freeBuffers.empty()) {
+            buffer = std::move(m_p->freeBuffers.back());
+            m_p->freeBuffers.pop_back();
+        }
+    }
+    buffer.assign(field, field + m_p->cells);
+    {
+        std::lock_guard lock(m_p->mutex);
+        m_p->queue.push_back({ step, std::move(buffer) });
+    }
+    m_p->workCv.notify_one();
+#endif
+    return !m_p->failed;
+}
+
+
+bool FieldStreamWriter::close()
+{
+    if (!m_p->file)
+        return !m_p->failed;
+#if !FIELD_STREAM_SERIAL
+    {
+        std::lock_guard lock(m_p->mutex);
+        m_p->closing = true;
+    }
+    m_p->workCv.notify_one();
+    m_p->worker.join();
+#endif
+
+    // === Index and trailer ===
+    std::vector<uint8_t> tail;
+    const uint64_t indexOffset = m_p->offset;
+    put(tail, INDEX_MAGIC);
+    put(tail, static_cast<uint64_t>(m_p->index.size() / 2));
+    for (uint64_t v : m_p->index)
+        put(tail, v);
+    put(tail, indexOffset);
+    put(tail, TRAILER_MAGIC);
+    m_p->writeBytes(tail.data(), tail.size());
+
+    if (std::fflush(m_p->file) != 0)
+        m_p->failed = true;
+    if (m_p->ownsFile && std::fclose(m_p->file) != 0)
+        m_p->failed = true;
+    m_p->file = nullptr;
+    return !m_p->failed;
+}
+
+
+size_t FieldStreamWriter::frames() const noexcept
+{
+    return m_p->framesWritten;
+}
+
+
+uint64_t FieldStreamWriter::bytes() const noexcept
+{
+    return m_p->offset;
+}
+
+
+// ==== Reader ===========================================================
+
+class FieldStreamReader::Private final
+{
+public:
+    struct Entry {
+        uint64_t step;
+        uint64_t offset;
+        bool key;
+    };
+
+    bool readAt(uint64_t pos, void* dst, size_t n);
+    bool loadIndex();
+    void scanChunks();
+    bool decode(size_t index);
+
+    static constexpr size_t NONE = ~size_t(0);
+
+    std::ifstream file;
+    uint64_t fileSize = 0;
+    size_t width = 0, height = 0;
+    size_t blockCells = 0;
+    std::vector<Entry> entries;
+
+    //! Last decoded frame, base of next delta frame
+    std::vector<uint32_t> bits;
+    size_t decoded = NONE;
+    std::vector<uint8_t> payload, planes;
+};
+
+
+bool FieldStreamReader::Private::readAt(uint64_t pos, void* dst, size_t n)
+{
+    if (pos > fileSize || n > fileSize - pos)
+        return false;
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(pos));
+    file.read(static_cast<char*>(dst), static_cast<std::streamsize>(n));
+    return static_cast<size_t>(file.gcount()) == n;
+}
+
+
+bool FieldStreamReader::Private::loadIndex()
+{
+    if (fileSize < HEADER_BYTES + INDEX_BYTES + TRAILER_BYTES)
+        return false;
+    uint8_t trailer[TRAILER_BYTES];
+    if (!readAt(fileSize - TRAILER_BYTES, trailer, TRAILER_BYTES) || get<uint32_t>(trailer + 8) != TRAILER_MAGIC)
+        return false;
+    const uint64_t indexOffset = get<uint64_t>(trailer);
+    uint8_t header[INDEX_BYTES];
+    if (indexOffset < HEADER_BYTES || !readAt(indexOffset, header, INDEX_BYTES) || get<uint32_t>(header) != INDEX_MAGIC)
+        return false;
+    const uint64_t count = get<uint64_t>(header + 4);
+    if (count > (fileSize - indexOffset) / ENTRY_BYTES
+        || indexOffset + INDEX_BYTES + count * ENTRY_BYTES + TRAILER_BYTES != fileSize)
+        return false;
+
+    std::vector<uint8_t> data(count * ENTRY_BYTES);
+    if (!readAt(indexOffset + INDEX_BYTES, data.data(), data.size()))
+        return false;
+    entries.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t offset = get<uint64_t>(&data[i * ENTRY_BYTES + 8]);
+        entries[i] = { get<uint64_t>(&data[i * ENTRY_BYTES]), offset & ~KEYFRAME_BIT, (offset & KEYFRAME_BIT) != 0 };
+    }
+    return true;
+}
+
+
+// Stream without trailer, e.g. pipe closed early
+void FieldStreamReader::Private::scanChunks()
+{
+    entries.clear();
+    uint64_t pos = HEADER_BYTES;
+    uint8_t chunk[CHUNK_BYTES];
+    while (readAt(pos, chunk, CHUNK_BYTES) && get<uint32_t>(chunk) == CHUNK_MAGIC) {
+        const uint64_t payloadBytes = get<uint64_t>(chunk + 16);
+        if (payloadBytes > fileSize - pos - CHUNK_BYTES)
+            break;
+        entries.push_back({ get<uint64_t>(chunk + 8), pos, get<uint32_t>(chunk + 4) == FRAME_KEY });
+        pos += CHUNK_BYTES + payloadBytes;
+    }
+}
+
+
+bool FieldStreamReader::Private::decode(size_t index)
+{
+    const Entry& e = entries[index];
+    uint8_t chunk[CHUNK_BYTES];
+    if (!readAt(e.offset, chunk, CHUNK_BYTES) || get<uint32_t>(chunk) != CHUNK_MAGIC)
+        return false;
+    const bool key = get<uint32_t>(chunk + 4) == FRAME_KEY;
+    const uint64_t payloadBytes = get<uint64_t>(chunk + 16);
+    const size_t cells = width * height;
+    const size_t blocks = (cells + blockCells - 1) / blockCells;
+    // Stored blocks are largest possible payload
+    if (payloadBytes > cells * 4 + blocks * 4)
+        return false;
+    payload.resize(payloadBytes);
+    if (!readAt(e.offset + CHUNK_BYTES, payload.data(), payload.size()))
+        return false;
+
+    size_t pos = 0;
+    for (size_t begin = 0; begin < cells; begin += blockCells) {
+        const size_t count = std::min(blockCells, cells - begin);
+        if (payload.size() - pos < 4)
+            return false;
+        const uint32_t size = get<uint32_t>(&payload[pos]);
+        pos += 4;
+        const size_t bytes = size & ~BLOCK_STORED;
+        if (bytes > payload.size() - pos)
+            return false;
+        planes.resize(count * 4);
+        if (size & BLOCK_STORED) {
+            if (bytes != planes.size())
+                return false;
+            std::memcpy(planes.data(), &payload[pos], bytes);
+        }
+        else if (!lzDecompress(&payload[pos], bytes, planes.data(), planes.size()))
+            return false;
+        pos += bytes;
+
+        uint32_t left = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t v = planes[i]
+                | (uint32_t(planes[count + i]) << 8)
+                | (uint32_t(planes[count * 2 + i]) << 16)
+                | (uint32_t(planes[count * 3 + i]) << 24);
+            bits[begin + i] = v + (key ? left : bits[begin + i]);
+            left = bits[begin + i];
+        }
+    }
+    return pos == payload.size();
+}
+
+
+FieldStreamReader::FieldStreamReader(const std::string& path)
+    : m_p(std::make_unique<Private>())
+{
+    m_p->file.open(path, std::ios::binary | std::ios::ate);
+    if (!m_p->file)
+        return;
+    m_p->fileSize = static_cast<uint64_t>(m_p->file.tellg());
+
+    uint8_t header[HEADER_BYTES];
+    if (!m_p->readAt(0, header, HEADER_BYTES)
+        || get<uint32_t>(header) != MAGIC || get<uint32_t>(header + 4) != VERSION) {
+        m_p->file.close();
+        return;
+    }
+    const uint32_t width = get<uint32_t>(header + 8);
+    const uint32_t height = get<uint32_t>(header + 12);
+    const uint64_t cells = uint64_t(width) * height;
+    m_p->blockCells = get<uint32_t>(header + 24);
+    if (width == 0 || height == 0 || width > MAX_SIDE || height > MAX_SIDE || cells > MAX_CELLS
+        || m_p->blockCells == 0) {
+        m_p->file.close();
+        return;
+    }
+    m_p->width = width;
+    m_p->height = height;
+    if (!m_p->loadIndex())
+        m_p->scanChunks();
+    if (m_p->entries.empty())
+        return;
+    // Any frame must fit into file even compressed, so memory is bounded by file size
+    if (cells * 4 / MAX_EXPANSION > m_p->fileSize) {
+        m_p->entries.clear();
+        m_p->width = m_p->height = 0;
+        m_p->file.close();
+        return;
+    }
+    m_p->bits.resize(cells);
+}
+
+
+FieldStreamReader::~FieldStreamReader() = default;
+
+
+bool FieldStreamReader::valid() const noexcept
+{
+    return m_p->file.is_open();
+}
+
+
+size_t FieldStreamReader::width() const noexcept
+{
+    return m_p->width;
+}
+
+
+size_t FieldStreamReader::height() const noexcept
+{
+    return m_p->height;
+}
+
+
+size_t FieldStreamReader::frameCount() const noexcept
+{
+    return m_p->entries.size();
+}
+
+
+uint64_t FieldStreamReader::frameStep(size_t index) const
+{
+    return index < m_p->entries.size() ? m_p->entries[index].step : 0;
+}
+
+
+size_t FieldStreamReader::findStep(uint64_t step) const
+{
+    const auto it = std::ranges::lower_bound(m_p->entries, step, {}, &Private::Entry::step);
+    return static_cast<size_t>(it - m_p->entries.begin());
+}
+
+
+bool FieldStreamReader::readFrame(size_t index, float* field)
+{
+    if (!valid() || index >= m_p->entries.size())
+        return false;
+
+    // Continue from last decoded frame if there is no keyframe in between
+    size_t key = index;
+    while (key > 0 && !m_p->entries[key].key)
+        --key;
+    if (!m_p->entries[key].key)
+        return false;
+    const size_t last = m_p->decoded;
+    const size_t first = (last != Private::NONE && last >= key && last <= index) ? last + 1 : key;
+
+    for (size_t i = first; i <= index; ++i) {
+        if (!m_p->decode(i)) {
+            m_p->decoded = Private::NONE;
+            return false;
+        }
+        m_p->decoded = i;
+    }
+    std::memcpy(field, m_p->bits.data(), m_p->bits.size() * sizeof(float));
+    return true;
+}
@@ -0,0 +1,354 @@
+//! \file frame_server.cpp
+#include "common/frame_server.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define FRAME_SERVER_SUPPORTED 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#define FRAME_SERVER_SUPPORTED 0
+#endif
+
+#if FRAME_SERVER_SUPPORTED && defined(__linux__)
+#define FRAME_SERVER_FUTEX 1
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#define FRAME_SERVER_FUTEX 0
+#endif
+
+namespace {
+
+constexpr size_t ALIGNMENT = 64;
+
+constexpr size_t alignUp(size_t n)
+{
+    return (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+
+int64_t monotonicNs()
+{
+#if FRAME_SERVER_SUPPORTED
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+#if FRAME_SERVER_FUTEX
+// NOTE: not FUTEX_PRIVATE_FLAG, waiters are in other processes
+void futexWakeAll(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+
+void futexWait(const std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs)
+{
+    timespec ts{ timeoutMs / 1000, (timeoutMs % 1000) * 1000000L };
+    syscall(SYS_futex, reinterpret_cast<const uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+#endif
+
+} // anonymous namespace
+
+
+// ==== Publisher ========================================================
+
+class FramePublisher::Private final
+{
+public:
+    FrameSlotHeader& slot(size_t i)
+    {
+        return *reinterpret_cast<FrameSlotHeader*>(base + header->slotOffset + i * header->slotStride);
+    }
+
+    std::string name;
+    uint8_t* base = nullptr;
+    size_t size = 0;
+    FrameRingHeader* header = nullptr;
+    uint64_t sequence = 0;
+    size_t fieldBytes = 0;
+    size_t pixelBytes = 0;
+};
+
+
+FramePublisher::FramePublisher(const std::string& name, size_t width, size_t height, uint32_t contents, size_t slotCount)
+    : m_p(std::make_unique<Private>())
+{
+#if FRAME_SERVER_SUPPORTED
+    m_p->name = name;
+    m_p->fieldBytes = (contents & CONTENT_FIELD) ? width * height * sizeof(float) : 0;
+    m_p->pixelBytes = (contents & CONTENT_PIXELS) ? width * height * 4 : 0;
+    const size_t fieldOffset  = alignUp(sizeof(FrameSlotHeader));
+    const size_t pixelsOffset = fieldOffset + alignUp(m_p->fieldBytes);
+    const size_t slotStride   = alignUp(pixelsOffset + m_p->pixelBytes);
+    const size_t slotOffset   = alignUp(sizeof(FrameRingHeader));
+    m_p->size = slotOffset + slotCount * slotStride;
+
+    // Replace stale object left by crashed process
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return;
+    if (ftruncate(fd, static_cast<off_t>(m_p->size)) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        return;
+    }
+    void* mem = mmap(nullptr, m_p->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return;
+    }
+
+    // Memory from ftruncate is zeroed, so all atomics start at 0
+    m_p->base = static_cast<uint8_t*>(mem);
+    m_p->header = reinterpret_cast<FrameRingHeader*>(mem);
+    auto& h = *m_p->header;
+    h.version = FrameRingHeader::VERSION;
+    h.width = static_cast<uint32_t>(width);
+    h.height = static_cast<uint32_t>(height);
+    h.slotCount = static_cast<uint32_t>(slotCount);
+    h.contents = contents;
+    h.slotOffset = slotOffset;
+    h.slotStride = slotStride;
+    h.fieldOffset = fieldOffset;
+    h.pixelsOffset = pixelsOffset;
+    // Magic last, reader checks it before anything else
+    std::atomic_thread_fence(std::memory_order_release);
+    h.magic = FrameRingHeader::MAGIC;
+#else
+    (void)name; (void)width; (void)height; (void)contents; (void)slotCount;
+#endif
+}
+
+
+FramePublisher::~FramePublisher()
+{
+#if FRAME_SERVER_SUPPORTED
+    if (m_p->base) {
+        munmap(m_p->base, m_p->size);
+        shm_unlink(m_p->name.c_str());
+    }
+#endif
+}
+
+
+bool FramePublisher::valid() const noexcept
+{
+    return m_p->base != nullptr;
+}
+
+
+void FramePublisher::publish(const float* field, const uint8_t* pixels)
+{
+    if (!m_p->base)
+        return;
+    auto& h = *m_p->header;
+    const uint64_t seq = ++m_p->sequence;
+    auto& slot = m_p->slot(seq % h.slotCount);
+    uint8_t* slotData = reinterpret_cast<uint8_t*>(&slot);
+
+    // === Seqlock write: mark slot as being written, copy, publish sequence ===
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (field && m_p->fieldBytes)
+        std::memcpy(slotData + h.fieldOffset, field, m_p->fieldBytes);
+    if (pixels && m_p->pixelBytes)
+        std::memcpy(slotData + h.pixelsOffset, pixels, m_p->pixelBytes);
+    slot.timestampNs = monotonicNs();
+    slot.sequence.store(seq, std::memory_order_release);
+
+    h.latestSequence.store(seq, std::memory_order_release);
+    h.futexWord.fetch_add(1, std::memory_order_release);
+#if FRAME_SERVER_FUTEX
+    futexWakeAll(&h.futexWord);
+#endif
+}
+
+
+// ==== Subscriber =======================================================
+
+class FrameSubscriber::Private final
+{
+public:
+    //! Layout copied from header when it was validated, other process may change header later
+    struct Layout {
+        uint32_t width = 0, height = 0;
+        uint32_t slotCount = 0;
+        uint32_t contents = 0;
+        uint64_t slotOffset = 0, slotStride = 0;
+        uint64_t fieldOffset = 0, pixelsOffset = 0;
+    };
+
+    //! Slots and their payloads must lie within mapping of `size` bytes
+    static bool validLayout(const Layout& l, size_t size);
+
+    const FrameSlotHeader& slot(size_t i) const
+    {
+        return *reinterpret_cast<const FrameSlotHeader*>(base + layout.slotOffset + i * layout.slotStride);
+    }
+
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+    const FrameRingHeader* header = nullptr;
+    Layout layout;
+};
+
+
+bool FrameSubscriber::Private::validLayout(const Layout& l, size_t size)
+{
+    constexpr uint64_t align = alignof(FrameSlotHeader);
+    if (l.slotCount == 0 || l.slotOffset < sizeof(FrameRingHeader) || l.slotOffset > size
+        || l.slotStride < sizeof(FrameSlotHeader) || l.slotOffset % align != 0 || l.slotStride % align != 0)
+        return false;
+    // slotOffset + slotCount * slotStride <= size without overflow
+    if (l.slotStride > (size - l.slotOffset) / l.slotCount)
+        return false;
+    // Sides are 32-bit, so cells and their bytes fit in 64 bits
+    const uint64_t cells = uint64_t(l.width) * l.height;
+    auto fits = [&](uint64_t offset, uint64_t bytes) {
+        return offset >= sizeof(FrameSlotHeader) && offset % alignof(float) == 0
+            && offset <= l.slotStride && bytes <= l.slotStride - offset;
+    };
+    if ((l.contents & FramePublisher::CONTENT_FIELD) && !fits(l.fieldOffset, cells * sizeof(float)))
+        return false;
+    if ((l.contents & FramePublisher::CONTENT_PIXELS) && !fits(l.pixelsOffset, cells * 4))
+        return false;
+    return true;
+}
+
+
+FrameSubscriber::FrameSubscriber(const std::string& name)
+    : m_p(std::make_unique<Private>())
+{
+#if FRAME_SERVER_SUPPORTED
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FrameRingHeader)) {
+        close(fd);
+        return;
+    }
+    m_p->size = static_cast<size_t>(st.st_size);
+    void* mem = mmap(nullptr, m_p->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+        return;
+
+    const auto* h = static_cast<const FrameRingHeader*>(mem);
+    const Private::Layout layout{ h->width, h->height, h->slotCount, h->contents,
+        h->slotOffset, h->slotStride, h->fieldOffset, h->pixelsOffset };
+    const bool ok = h->magic == FrameRingHeader::MAGIC
+        && h->version == FrameRingHeader::VERSION
+        && Private::validLayout(layout, m_p->size);
+    if (!ok) {
+        munmap(mem, m_p->size);
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    m_p->base = static_cast<const uint8_t*>(mem);
+    m_p->header = h;
+    m_p->layout = layout;
+#else
+    (void)name;
+#endif
+}
+
+
+FrameSubscriber::~FrameSubscriber()
+{
+#if FRAME_SERVER_SUPPORTED
+    if (m_p->base)
+        munmap(const_cast<uint8_t*>(m_p->base), m_p->size);
+#endif
+}
+
+
+bool FrameSubscriber::valid() const noexcept
+{
+    return m_p->base != nullptr;
+}
+
+
+size_t FrameSubscriber::width() const noexcept
+{
+    return m_p->layout.width;
+}
+
+
+size_t FrameSubscriber::height() const noexcept
+{
+    return m_p->layout.height;
+}
+
+
+bool FrameSubscriber::waitFrame(uint64_t lastSequence, int timeoutMs, Frame& frame)
+{
+    if (!m_p->base)
+        return false;
+    const auto& h = *m_p->header;
+    const int64_t deadline = monotonicNs() + static_cast<int64_t>(timeoutMs) * 1000000;
+    for (;;) {
+        // Read futex word before sequence, so publish in between is not missed
+        const uint32_t word = h.futexWord.load(std::memory_order_acquire);
+        const uint64_t latest = h.latestSequence.load(std::memory_order_acquire);
+        if (latest > lastSequence) {
+            const auto& l = m_p->layout;
+            const auto& slot = m_p->slot(latest % l.slotCount);
+            if (slot.sequence.load(std::memory_order_acquire) == latest) {
+                const uint8_t* slotData = reinterpret_cast<const uint8_t*>(&slot);
+                frame.sequence = latest;
+                frame.timestampNs = slot.timestampNs;
+                frame.field  = (l.contents & FramePublisher::CONTENT_FIELD)
+                    ? reinterpret_cast<const float*>(slotData + l.fieldOffset) : nullptr;
+                frame.pixels = (l.contents & FramePublisher::CONTENT_PIXELS)
+                    ? slotData + l.pixelsOffset : nullptr;
+                frame.slot = &slot;
+                return true;
+            }
+            // Overwritten meanwhile, newer frame is already there
+            continue;
+        }
+        const int64_t remainingMs = (deadline - monotonicNs()) / 1000000;
+        if (remainingMs <= 0)
+            return false;
+#if FRAME_SERVER_FUTEX
+        futexWait(&h.futexWord, word, static_cast<int>(remainingMs));
+#else
+        (void)word;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+}
+
+
+bool FrameSubscriber::stillValid(const Frame& frame) const noexcept
+{
+    if (!frame.slot)
+        return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return frame.slot->sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
+
+
+int64_t FrameSubscriber::nowNs() noexcept
+{
+    return monotonicNs();
+}
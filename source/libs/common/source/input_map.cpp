@@ -0,0 +1,106 @@
+//! \file input_map.cpp
+#include "common/input_map.h"
+
+#include <fstream>
+#include <limits>
+#include <optional>
+
+namespace {
+
+//! Limits of image read from header, corrupted header must not allocate gigabytes
+constexpr size_t MAX_SIDE = 65536;
+constexpr size_t MAX_CELLS = size_t(1) << 28;
+
+// Reads binary PGM/PPM with maxval 255, color is converted to luma
+std::optional<std::vector<uint8_t>> readNetpbm(const std::string& path, size_t& width, size_t& height)
+{
+    std::ifstream f(path, std::ios::binary);
+    std::string magic;
+    size_t maxval = 0;
+    f >> magic;
+    // Skip comments between header fields
+    auto field = [&](size_t& value) {
+        while (f >> std::ws && f.peek() == '#')
+            f.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        f >> value;
+    };
+    field(width);
+    field(height);
+    field(maxval);
+    f.get();    // single whitespace before pixel data
+    const size_t channels = magic == "P5" ? 1 : magic == "P6" ? 3 : 0;
+    if (!f || channels == 0 || maxval != 255 || width == 0 || height == 0
+        || width > MAX_SIDE || height > MAX_SIDE || width * height > MAX_CELLS)
+        return std::nullopt;
+    // Pixel data must be in file before it is allocated
+    const auto start = f.tellg();
+    f.seekg(0, std::ios::end);
+    const auto available = f.tellg() - start;
+    f.seekg(start);
+    if (!f || available < 0 || static_cast<size_t>(available) < width * height * channels)
+        return std::nullopt;
+
+    std::vector<uint8_t> raw(width * height * channels);
+    f.read(reinterpret_cast<char*>(raw.data()), static_cast<std::streamsize>(raw.size()));
+    if (!f)
+        return std::nullopt;
+    if (channels == 1)
+        return raw;
+    std::vector<uint8_t> gray(width * height);
+    for (size_t i = 0; i < gray.size(); ++i)
+        gray[i] = static_cast<uint8_t>((raw[i * 3] * 77 + raw[i * 3 + 1] * 150 + raw[i * 3 + 2] * 29) >> 8);
+    return gray;
+}
+
+
+// Nearest neighbour scaling of image to map size
+template<typename Fn>
+bool forEachScaledPixel(const std::string& path, size_t width, size_t height, Fn fn)
+{
+    if (width == 0 || height == 0)
+        return false;
+    size_t imageWidth = 0, imageHeight = 0;
+    const auto image = readNetpbm(path, imageWidth, imageHeight);
+    if (!image)
+        return false;
+    for (size_t y = 0; y < height; ++y) {
+        const uint8_t* row = &(*image)[(y * imageHeight / height) * imageWidth];
+        for (size_t x = 0; x < width; ++x)
+            fn(y * width + x, row[x * imageWidth / width]);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+
+InputMap::InputMap(size_t width, size_t height)
+    : width(width)
+    , height(height)
+{
+}
+
+
+bool InputMap::loadObstacles(const std::string& path)
+{
+    std::vector<uint64_t> bits((width * height + 63) / 64, 0);
+    const bool ok = forEachScaledPixel(path, width, height, [&](size_t idx, uint8_t value) {
+        if (value >= 128)
+            bits[idx >> 6] |= uint64_t(1) << (idx & 63);
+    });
+    if (ok)
+        obstacles = std::move(bits);
+    return ok;
+}
+
+
+bool InputMap::loadAttractors(const std::string& path)
+{
+    std::vector<uint8_t> values(width * height, 0);
+    const bool ok = forEachScaledPixel(path, width, height, [&](size_t idx, uint8_t value) {
+        values[idx] = value;
+    });
+    if (ok)
+        attractors = std::move(values);
+    return ok;
+}
@@ -0,0 +1,255 @@
+//! \file perf_counters.cpp
+#include "common/perf_counters.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_COUNTERS_SUPPORTED 1
+#else
+#define PERF_COUNTERS_SUPPORTED 0
+#endif
+
+namespace {
+
+#if PERF_COUNTERS_SUPPORTED
+struct EventType {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr std::array<EventType, PerfCounters::COUNTER_END> EVENTS = {{
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+}};
+
+
+int openEvent(const EventType& event, pid_t tid, int groupFd)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+        | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, 0));
+}
+
+std::vector<pid_t> listThreads(std::error_code& ec)
+{
+    std::vector<pid_t> tids;
+    for (const auto& entry : std::filesystem::directory_iterator("/proc/self/task", ec))
+        tids.push_back(static_cast<pid_t>(std::stol(entry.path().filename().string())));
+    std::ranges::sort(tids);
+    return tids;
+}
+#endif
+
+} // anonymous namespace
+
+
+class PerfCounters::Private final
+{
+public:
+    //! Group of counters on one thread, leader is first opened counter
+    struct Group {
+        int leader = -1;
+        std::array<int, COUNTER_END> fds;
+        std::array<uint64_t, COUNTER_END> ids{};
+    };
+
+    ~Private();
+
+    std::vector<Group> groups;
+#if PERF_COUNTERS_SUPPORTED
+    //! Sorted threads existing at construction, including those counters failed on
+    std::vector<pid_t> tids;
+#endif
+    std::array<bool, COUNTER_END> available{};
+    std::string error;
+};
+
+
+PerfCounters::Private::~Private()
+{
+#if PERF_COUNTERS_SUPPORTED
+    for (const Group& g : groups) {
+        for (int fd : g.fds) {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+#endif
+}
+
+
+PerfCounters::PerfCounters()
+    : m_p(std::make_unique<Private>())
+{
+#if PERF_COUNTERS_SUPPORTED
+    std::error_code ec;
+    m_p->tids = listThreads(ec);
+    for (const pid_t tid : m_p->tids) {
+        Private::Group g;
+        g.fds.fill(-1);
+        for (size_t c = 0; c < COUNTER_END; ++c) {
+            const int fd = openEvent(EVENTS[c], tid, g.leader);
+            if (fd < 0) {
+                if (m_p->error.empty())
+                    m_p->error = std::string(name(static_cast<Counter>(c))) + ": " + std::strerror(errno);
+                continue;
+            }
+            if (g.leader < 0)
+                g.leader = fd;
+            g.fds[c] = fd;
+            ioctl(fd, PERF_EVENT_IOC_ID, &g.ids[c]);
+        }
+        if (g.leader >= 0)
+            m_p->groups.push_back(g);
+    }
+    if (ec)
+        m_p->error = "/proc/self/task: " + ec.message();
+    // Counter counts only if it could be opened on every thread
+    for (size_t c = 0; c < COUNTER_END; ++c) {
+        m_p->available[c] = !m_p->groups.empty() && std::ranges::all_of(m_p->groups,
+            [c](const Private::Group& g) { return g.fds[c] >= 0; });
+    }
+    for (const Private::Group& g : m_p->groups) {
+        ioctl(g.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(g.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+    m_p->error = "perf_event_open is Linux only";
+#endif
+}
+
+
+PerfCounters::~PerfCounters() = default;
+
+
+bool PerfCounters::available(Counter counter) const noexcept
+{
+    return m_p->available[counter];
+}
+
+
+bool PerfCounters::valid() const noexcept
+{
+    return std::ranges::any_of(m_p->available, [](bool a) { return a; });
+}
+
+
+const std::string& PerfCounters::error() const noexcept
+{
+    return m_p->error;
+}
+
+
+size_t PerfCounters::threads() const noexcept
+{
+    return m_p->groups.size();
+}
+
+
+size_t PerfCounters::newThreads() const
+{
+#if PERF_COUNTERS_SUPPORTED
+    std::error_code ec;
+    const std::vector<pid_t> current = listThreads(ec);
+    return static_cast<size_t>(std::ranges::count_if(current,
+        [this](pid_t tid) { return !std::ranges::binary_search(m_p->tids, tid); }));
+#else
+    return 0;
+#endif
+}
+
+
+PerfCounters::Values PerfCounters::read() const
+{
+    Values result{};
+#if PERF_COUNTERS_SUPPORTED
+    // nr, time enabled, time running, then value and id of each member
+    std::array<uint64_t, 3 + 2 * COUNTER_END> buffer;
+    for (const Private::Group& g : m_p->groups) {
+        if (::read(g.leader, buffer.data(), sizeof(buffer)) <= 0)
+            continue;
+        const uint64_t n = std::min<uint64_t>(buffer[0], COUNTER_END);
+        const uint64_t enabled = buffer[1];
+        const uint64_t running = buffer[2];
+        if (running == 0)
+            continue;
+        for (uint64_t i = 0; i < n; ++i) {
+            const uint64_t value = buffer[3 + 2 * i];
+            const uint64_t id = buffer[4 + 2 * i];
+            for (size_t c = 0; c < COUNTER_END; ++c) {
+                if (g.fds[c] >= 0 && g.ids[c] == id && m_p->available[c])
+                    result[c] += running == enabled ? value
+                        : static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+            }
+        }
+    }
+#endif
+    return result;
+}
+
+
+const char* PerfCounters::name(Counter counter) noexcept
+{
+    switch (counter) {
+    case CYCLES:       return "cycles";
+    case INSTRUCTIONS: return "instructions";
+    case LLC_MISSES:   return "LLC misses";
+    case DTLB_MISSES:  return "dTLB misses";
+    default:           return "";
+    }
+}
+
+
+PhaseCounters::PhaseCounters(const PerfCounters* counters, size_t phases)
+    : m_counters(counters)
+    , m_totals(phases)
+    , m_phase(phases)
+{
+}
+
+
+void PhaseCounters::mark(size_t phase)
+{
+    const auto now = Clock::now();
+    const PerfCounters::Values values = m_counters ? m_counters->read() : PerfCounters::Values{};
+    if (m_phase < m_totals.size()) {
+        Totals& t = m_totals[m_phase];
+        // Scaled counts of multiplexed counters are estimates, they may go down
+        for (size_t c = 0; c < values.size(); ++c)
+            t.values[c] += values[c] > m_startValues[c] ? values[c] - m_startValues[c] : 0;
+        t.seconds += std::chrono::duration<double>(now - m_startTime).count();
+        ++t.runs;
+    }
+    m_phase = phase;
+    m_startValues = values;
+    m_startTime = now;
+}
+
+
+const std::vector<PhaseCounters::Totals>& PhaseCounters::totals() const noexcept
+{
+    return m_totals;
+}
+
+
+void PhaseCounters::clear()
+{
+    m_totals.assign(m_totals.size(), Totals{});
+}
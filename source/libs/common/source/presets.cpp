@@ -1,4 +1,9 @@
 #include "common/presets.h"
+#include "common/colors_constexpr.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
 
 const std::vector<AgentPreset>& presetAgents() {
     static const std::vector<AgentPreset> presets {
@@ -16,19 +21,92 @@ const std::vector<AgentPreset>& presetAgents() {
     return presets;
 }
 
+
+namespace {
+
+constexpr std::array<PalettePreset, 11> PALETTES{{
+    { "Candy Shop", {{ { 0.31f, 0.14f, 0.33f }, { 0.87f, 0.85f, 0.65f }, { 0.54f, 0.99f, 0.77f }}} },
+    { "Biolab", {{{0.12f, 0.07f, 0.15f}, {0.10f, 0.31f, 0.20f}, {0.87f, 0.93f, 0.53f}}} },
+    { "Forest", {{{0.13f, 0.11f, 0.0f}, {0.4f, 0.7f, 0.2f}, {0.9f, 1.0f, 0.6f}}} },
+    { "Tropical Reef", {{{0.05f, 0.10f, 0.20f}, {0.15f, 0.70f, 0.60f}, {0.95f, 0.90f, 0.55f}}} },
+    { "Deep Ocean", {{{0.0f, 0.1f, 0.3f}, {0.2f, 0.6f, 0.8f}, {0.95f, 0.95f, 0.8f}}} },
+    { "Cold Snap", {{{0.0f, 0.07f, 0.12f}, {0.3f, 0.55f, 0.7f}, {0.95f, 0.98f, 1.0f}}} },
+    { "Amethyst Dawn",{{{0.18f, 0.08f, 0.25f}, {0.65f, 0.40f, 0.55f}, {0.95f, 0.88f, 0.80f}}} },
+    { "Rosewood Sky", {{{0.15f, 0.05f, 0.07f}, {0.40f, 0.30f, 0.55f}, {0.92f, 0.88f, 0.98f}}} },
+    { "Neon Rust", {{{.2f, 0.07f, 0.037f}, {0.72f, 0.41f, 0.17f}, {0.6f,.95f, 0.94f}}} },
+    { "Heat Wave", {{{0.15f, 0.0f, 0.15f}, {0.8f, 0.5f, 0.3f}, {1.0f, 0.9f, 0.66f}}} },
+    { "Core Meltdown", {{{ 0.22f, 0.05f, 0.27f}, { .8f, .66f,.2f}, { .985f, 0.985f, 0.7f}}} },
+}};
+
+
+// Gradient segments of every palette and interpolation, baked at compile time.
+// Every chunk of segment is evaluated as separate constant, which keeps it well
+// within constexpr step limits of compilers (about 1M in clang and with GCC
+// -fconstexpr-ops-limit=1048576 whole segment would not fit).
+constexpr size_t BAKED_GRADIENT_SIZE = 256;
+constexpr size_t BAKED_CHUNK_SIZE = 64;
+using BakedGradient = std::array<std::array<uint16_t, 3>, BAKED_GRADIENT_SIZE>;
+using BakedChunk = std::array<std::array<uint16_t, 3>, BAKED_CHUNK_SIZE>;
+
+template <size_t Palette, size_t Segment, color::Interpolation Interp, size_t Chunk>
+constexpr BakedChunk BAKED_CHUNK = color::ct::bakeGradient<BAKED_CHUNK_SIZE>(
+    Interp, PALETTES[Palette].palette[Segment], PALETTES[Palette].palette[Segment + 1],
+    BAKED_GRADIENT_SIZE, Chunk * BAKED_CHUNK_SIZE);
+
+template <size_t Palette, size_t Segment, color::Interpolation Interp, size_t... Chunk>
+constexpr BakedGradient joinChunks(std::index_sequence<Chunk...>)
+{
+    BakedGradient result{};
+    size_t i = 0;
+    for (const BakedChunk* chunk : { &BAKED_CHUNK<Palette, Segment, Interp, Chunk>... })
+        for (const auto& c : *chunk)
+            result[i++] = c;
+    return result;
+}
+
+template <size_t Palette, size_t Segment, color::Interpolation Interp>
+constexpr BakedGradient BAKED_GRADIENT = joinChunks<Palette, Segment, Interp>(
+    std::make_index_sequence<BAKED_GRADIENT_SIZE / BAKED_CHUNK_SIZE>());
+
+template <size_t... I>
+constexpr std::array<const BakedGradient*, sizeof...(I)> bakedGradients(std::index_sequence<I...>)
+{
+    return { &BAKED_GRADIENT<I / (2 * color::INTERP_END), I / color::INTERP_END % 2,
+        static_cast<color::Interpolation>(I % color::INTERP_END)>... };
+}
+
+constexpr auto BAKED_GRADIENTS = bakedGradients(std::make_index_sequence<PALETTES.size() * 2 * color::INTERP_END>());
+
+} // anonymous namespace
+
+
 const std::vector<PalettePreset>& presetPalettes() {
-    static const std::vector<PalettePreset> presets{
-        { "Candy Shop", {{ { 0.31f, 0.14f, 0.33f }, { 0.87f, 0.85f, 0.65f }, { 0.54f, 0.99f, 0.77f }}} },
-        { "Biolab", {{{0.12f, 0.07f, 0.15f}, {0.10f, 0.31f, 0.20f}, {0.87f, 0.93f, 0.53f}}} },
-        { "Forest", {{{0.13f, 0.11f, 0.0f}, {0.4f, 0.7f, 0.2f}, {0.9f, 1.0f, 0.6f}}} },
-        { "Tropical Reef", {{{0.05f, 0.10f, 0.20f}, {0.15f, 0.70f, 0.60f}, {0.95f, 0.90f, 0.55f}}} },
-        { "Deep Ocean", {{{0.0f, 0.1f, 0.3f}, {0.2f, 0.6f, 0.8f}, {0.95f, 0.95f, 0.8f}}} },
-        { "Cold Snap", {{{0.0f, 0.07f, 0.12f}, {0.3f, 0.55f, 0.7f}, {0.95f, 0.98f, 1.0f}}} },
-        { "Amethyst Dawn",{{{0.18f, 0.08f, 0.25f}, {0.65f, 0.40f, 0.55f}, {0.95f, 0.88f, 0.80f}}} },
-        { "Rosewood Sky", {{{0.15f, 0.05f, 0.07f}, {0.40f, 0.30f, 0.55f}, {0.92f, 0.88f, 0.98f}}} },
-        { "Neon Rust", {{{.2f, 0.07f, 0.037f}, {0.72f, 0.41f, 0.17f}, {0.6f,.95f, 0.94f}}} },
-        { "Heat Wave", {{{0.15f, 0.0f, 0.15f}, {0.8f, 0.5f, 0.3f}, {1.0f, 0.9f, 0.66f}}} },
-        { "Core Meltdown", {{{ 0.22f, 0.05f, 0.27f}, { .8f, .66f,.2f}, { .985f, 0.985f, 0.7f}}} },
-    };
+    static const std::vector<PalettePreset> presets(PALETTES.begin(), PALETTES.end());
     return presets;
 }
+
+
+std::vector<color::Rgb> presetGradient(size_t palette, size_t segment, color::Interpolation interpolation, size_t length)
+{
+    const BakedGradient& baked = *BAKED_GRADIENTS[(palette * 2 + segment) * color::INTERP_END + interpolation];
+    std::vector<color::Rgb> result(length);
+    if (length == 1) {
+        result[0] = PALETTES[palette].palette[segment];
+        return result;
+    }
+    // Linear interpolation between baked samples
+    constexpr float scale = 1.0f / 65535.0f;
+    for (size_t i = 0; i < length; ++i) {
+        const float x = static_cast<float>(i) * (BAKED_GRADIENT_SIZE - 1) / (length - 1);
+        const size_t j = std::min(static_cast<size_t>(x), BAKED_GRADIENT_SIZE - 2);
+        const float t = x - j;
+        const auto& c0 = baked[j];
+        const auto& c1 = baked[j + 1];
+        result[i] = {
+            ((1.0f - t) * c0[0] + t * c1[0]) * scale,
+            ((1.0f - t) * c0[1] + t * c1[1]) * scale,
+            ((1.0f - t) * c0[2] + t * c1[2]) * scale
+        };
+    }
+    return result;
+}
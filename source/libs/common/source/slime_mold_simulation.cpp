@@ -1,10 +1,17 @@
 ﻿#include "common/slime_mold_simulation.h"
 #include "common/presets.h"
+#include "common/thread_pool.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cmath>
+#include <ctime>
 #include <numbers>
+#include <random>
+#include <span>
+#include <utility>
 #include <vector>
 
 // This actually help as it avoids expensive modulo operations
@@ -13,6 +20,11 @@
 #include <immintrin.h>
 #endif
 
+// WebAssembly SIMD128, moves 4 agents at once and handles field loops.
+#if defined(USE_WASM_SIMD)
+#include <wasm_simd128.h>
+#endif
+
 // Does not seem to help, but idea was to make memory access less random.
 #define DO_SORTING 0
 
@@ -32,248 +44,2240 @@ inline void rotate(float& dx, float& dy, float cos_a, float sin_a)
     dy = ndy;
 }
 
+
+// Field read by sensors, simulation field or level of its pyramid
+struct SensorField
+{
+    const float* data;
+    int width, height;
+};
+
+
+// Per step constants derived from preset
+struct StepParams
+{
+    float sensorLeftCos, sensorLeftSin;
+    float sensorRightCos, sensorRightSin;
+    float turnLeftCos, turnLeftSin;
+    float turnRightCos, turnRightSin;
+    float sensorDist, stepSize;
+    bool bilinear;
+    bool simd;          // false forces scalar reference kernels
+    // Sensor position in cells of field is position * scale - offset + direction * sensorDist,
+    // scale is 1 and offset 0 for level 0
+    SensorField field;
+    float sensorScale, sensorOffset;
+};
+
+
+// Level L cell averages 2^L x 2^L cells, its center is (2^L - 1) / 2 from corner
+StepParams makeStepParams(const AgentPreset& p, bool bilinear, bool simd, const SensorField& field, size_t level)
+{
+    const float scale = std::ldexp(1.0f, -static_cast<int>(level));
+    return {
+        std::cos(-p.sensor_angle), std::sin(-p.sensor_angle),
+        std::cos(p.sensor_angle),  std::sin(p.sensor_angle),
+        std::cos(-p.turn_angle),   std::sin(-p.turn_angle),
+        std::cos(p.turn_angle),    std::sin(p.turn_angle),
+        p.sensor_dist * scale, p.step_size,
+        bilinear, simd,
+        field, scale, (1.0f - scale) * 0.5f
+    };
+}
+
+
+// Stateless hash (lowbias32), gives random numbers independent of thread scheduling
+inline uint32_t hash32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+
+// Random word k of agent i for given reset, any word can be computed independently
+inline uint32_t randomWord(uint32_t salt, size_t i, uint32_t k)
+{
+    return hash32(static_cast<uint32_t>(i * 4 + k) ^ salt);
+}
+
+
+// Uniform in [0, 1) with 24 bits, exact in float
+inline float unitFloat(uint32_t r)
+{
+    return static_cast<float>(r >> 8) * 0x1p-24f;
+}
+
+
+// Quantized directions for spawning, gathered by vector code instead of sin/cos
+constexpr int DIRECTION_BITS = 12;
+constexpr size_t DIRECTIONS = size_t(1) << DIRECTION_BITS;
+
+struct DirectionTable
+{
+    std::array<float, DIRECTIONS> cos, sin;
+};
+
+
+const DirectionTable& directionTable()
+{
+    static const DirectionTable table = [] {
+        DirectionTable t;
+        for (size_t i = 0; i < DIRECTIONS; ++i) {
+            const float angle = i * (2.0f * std::numbers::pi_v<float> / DIRECTIONS);
+            t.cos[i] = std::cos(angle);
+            t.sin[i] = std::sin(angle);
+        }
+        return t;
+    }();
+    return table;
+}
+
+
+// Agent of AGENTS_COMPACT format. Position is fixed point fraction of field size,
+// 2^32 is full width, so wrapping around is free by overflow. Y has 20 bits of
+// position, its low DIRECTION_BITS are heading index into direction tables.
+struct CompactAgent
+{
+    uint32_t x, y;
+};
+
+
+// Cell, evaporation tile and deposit band under agent
+struct DepositEntry
+{
+    uint32_t cell, tile, band;
+};
+
+constexpr uint32_t HEADING_MASK = DIRECTIONS - 1;
+constexpr size_t COMPACT_MAX_SIZE = size_t(1) << 16;
+
+
+// Nearest cell of fixed point coordinate from its top 16 bits,
+// 32 bit product is enough for size up to COMPACT_MAX_SIZE
+inline uint32_t compactCell(uint32_t v, uint32_t size)
+{
+    const uint32_t i = ((v >> 16) * size + 0x8000) >> 16;
+    return i == size ? 0 : i;
+}
+
+
+// Compact coordinate p + o where o is signed, true if it went past 2^32 either way
+inline bool compactCrossed(uint32_t p, uint32_t s, uint32_t o)
+{
+    return (s < p) != (static_cast<int32_t>(o) < 0);
+}
+
+
+// === Boundary policies ===
+// Kernels are instantiated for each policy, so inner loops have no branches on
+// boundary. Wrap keeps positions in [0, size), other policies in cell centers
+// [0, size - 1] and compact coordinates up to limit of field (see CompactTables),
+// so deposit and lifecycle find cell under agent the same way for all of them.
+//
+// cell:          cell of rounded sensor position, at most one field size outside
+// cellPair:      cells of bilinear sample between floor i and i + 1
+// coord:         float coordinate moved back into field
+// confine:       float agent after move, may turn or move it
+// compactStep:   compact coordinate p + o, o is signed
+// compactNext:   next cell of bilinear sample, i + 1 may be size
+// confineCompact: compact agent moved by table offsets, heading is set
+
+struct WrapBoundary
+{
+    static int cell(int i, int n)
+    {
+        i += i < 0 ? n : 0;
+        return i >= n ? i - n : i;
+    }
+
+    static void cellPair(int i, int n, int& c0, int& c1)
+    {
+        c0 = cell(i, n);
+        c1 = c0 + 1 < n ? c0 + 1 : 0;
+    }
+
+    static float coord(float v, float size)
+    {
+        if (v < 0)     v += size;
+        if (v >= size) v -= size;
+        return v;
+    }
+
+    static void confine(Agent& a, float w, float h)
+    {
+        a.x = coord(a.x, w);
+        a.y = coord(a.y, h);
+    }
+
+    static uint32_t compactStep(uint32_t p, uint32_t o, uint32_t /*limit*/)
+    {
+        return p + o;
+    }
+
+    static uint32_t compactNext(uint32_t i, uint32_t n)
+    {
+        return i + 1 < n ? i + 1 : 0;
+    }
+
+    static void confineCompact(CompactAgent& a, uint32_t mx, uint32_t my, uint32_t heading,
+        uint32_t /*limitX*/, uint32_t /*limitY*/)
+    {
+        // Wrapping around is overflow
+        a.x += mx;
+        a.y = ((a.y + my) & ~HEADING_MASK) | heading;
+    }
+
+#if defined(USE_AVX2)
+    static __m128i cell(__m128i i, __m128i n)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        i = _mm_add_epi32(i, _mm_and_si128(_mm_cmpgt_epi32(zero, i), n));                               // < 0 → +n
+        return _mm_sub_epi32(i, _mm_and_si128(_mm_cmpgt_epi32(i, _mm_sub_epi32(n, _mm_set1_epi32(1))), n)); // >= n → -n
+    }
+
+    static void cellPair(__m256i i, __m256i n, __m256i& c0, __m256i& c1)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi32(1);
+        i = _mm256_add_epi32(i, _mm256_and_si256(_mm256_cmpgt_epi32(zero, i), n));
+        c0 = _mm256_sub_epi32(i, _mm256_and_si256(_mm256_cmpgt_epi32(i, _mm256_sub_epi32(n, one)), n));
+        c1 = _mm256_add_epi32(c0, one);
+        c1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(c1, n), c1);      // n → 0
+    }
+
+    static void confine(__m256& x, __m256& y, __m256& /*dx*/, __m256& /*dy*/, __m256 w, __m256 h)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        x = _mm256_add_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), w));
+        x = _mm256_sub_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, w, _CMP_GE_OQ), w));
+        y = _mm256_add_ps(y, _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_LT_OQ), h));
+        y = _mm256_sub_ps(y, _mm256_and_ps(_mm256_cmp_ps(y, h, _CMP_GE_OQ), h));
+    }
+
+    static __m256i compactStep(__m256i p, __m256i o, __m256i /*limit*/)
+    {
+        return _mm256_add_epi32(p, o);
+    }
+
+    static __m256i compactNext(__m256i i, __m256i n)
+    {
+        i = _mm256_add_epi32(i, _mm256_set1_epi32(1));
+        return _mm256_andnot_si256(_mm256_cmpeq_epi32(i, n), i);        // n → 0
+    }
+
+    static void confineCompact(__m256i& x, __m256i& y, __m256i mx, __m256i my, __m256i heading,
+        __m256i /*limitX*/, __m256i /*limitY*/)
+    {
+        x = _mm256_add_epi32(x, mx);
+        y = _mm256_or_si256(_mm256_andnot_si256(_mm256_set1_epi32(HEADING_MASK), _mm256_add_epi32(y, my)), heading);
+    }
+#elif defined(USE_WASM_SIMD)
+    static v128_t cell(v128_t i, v128_t n)
+    {
+        i = wasm_i32x4_add(i, wasm_v128_and(wasm_i32x4_lt(i, wasm_i32x4_splat(0)), n));   // < 0 → +n
+        return wasm_i32x4_sub(i, wasm_v128_and(wasm_i32x4_ge(i, n), n));                  // >= n → -n
+    }
+
+    static void confine(v128_t& x, v128_t& y, v128_t& /*dx*/, v128_t& /*dy*/, v128_t w, v128_t h)
+    {
+        const v128_t zero = wasm_f32x4_splat(0.0f);
+        x = wasm_f32x4_add(x, wasm_v128_and(wasm_f32x4_lt(x, zero), w));
+        x = wasm_f32x4_sub(x, wasm_v128_and(wasm_f32x4_ge(x, w), w));
+        y = wasm_f32x4_add(y, wasm_v128_and(wasm_f32x4_lt(y, zero), h));
+        y = wasm_f32x4_sub(y, wasm_v128_and(wasm_f32x4_ge(y, h), h));
+    }
+#endif
+};
+
+
+// Sensors outside read edge of field, agents stay on cell centers
+struct ClampBoundary
+{
+    static int cell(int i, int n)
+    {
+        return i < 0 ? 0 : (i > n - 1 ? n - 1 : i);
+    }
+
+    static void cellPair(int i, int n, int& c0, int& c1)
+    {
+        c0 = cell(i, n);
+        c1 = cell(i + 1, n);
+    }
+
+    static float coord(float v, float size)
+    {
+        return v < 0.0f ? 0.0f : (v > size - 1.0f ? size - 1.0f : v);
+    }
+
+    // Crossing zero gives 0, crossing far edge or limit gives limit
+    static uint32_t compactStep(uint32_t p, uint32_t o, uint32_t limit)
+    {
+        const uint32_t s = p + o;
+        if (compactCrossed(p, s, o))
+            return static_cast<int32_t>(o) < 0 ? 0 : limit;
+        return std::min(s, limit);
+    }
+
+    static uint32_t compactNext(uint32_t i, uint32_t n)
+    {
+        return i + 1 < n ? i + 1 : n - 1;
+    }
+
+#if defined(USE_AVX2)
+    static __m128i cell(__m128i i, __m128i n)
+    {
+        return _mm_min_epi32(_mm_max_epi32(i, _mm_setzero_si128()), _mm_sub_epi32(n, _mm_set1_epi32(1)));
+    }
+
+    static void cellPair(__m256i i, __m256i n, __m256i& c0, __m256i& c1)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i last = _mm256_sub_epi32(n, _mm256_set1_epi32(1));
+        c0 = _mm256_min_epi32(_mm256_max_epi32(i, zero), last);
+        c1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(i, _mm256_set1_epi32(1)), zero), last);
+    }
+
+    // Coordinate below or above `last`, as in scalar coord
+    static __m256 coord(__m256 v, __m256 last, __m256& outside)
+    {
+        const __m256 below = _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_LT_OQ);
+        const __m256 above = _mm256_cmp_ps(v, last, _CMP_GT_OQ);
+        outside = _mm256_or_ps(below, above);
+        return _mm256_blendv_ps(_mm256_andnot_ps(below, v), last, above);
+    }
+
+    static __m256i compactStep(__m256i p, __m256i o, __m256i limit)
+    {
+        const __m256i s = _mm256_add_epi32(p, o);
+        const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+        // Unsigned s < p by flipping sign bits
+        const __m256i lower = _mm256_cmpgt_epi32(_mm256_xor_si256(p, sign), _mm256_xor_si256(s, sign));
+        const __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), o);
+        const __m256i crossed = _mm256_xor_si256(lower, negative);
+        const __m256i edge = _mm256_andnot_si256(negative, limit);
+        return _mm256_blendv_epi8(_mm256_min_epu32(s, limit), edge, crossed);
+    }
+
+    static __m256i compactNext(__m256i i, __m256i n)
+    {
+        return _mm256_min_epi32(_mm256_add_epi32(i, _mm256_set1_epi32(1)), _mm256_sub_epi32(n, _mm256_set1_epi32(1)));
+    }
+#elif defined(USE_WASM_SIMD)
+    static v128_t cell(v128_t i, v128_t n)
+    {
+        return wasm_i32x4_min(wasm_i32x4_max(i, wasm_i32x4_splat(0)), wasm_i32x4_sub(n, wasm_i32x4_splat(1)));
+    }
+
+    static v128_t coord(v128_t v, v128_t last, v128_t& outside)
+    {
+        const v128_t below = wasm_f32x4_lt(v, wasm_f32x4_splat(0.0f));
+        const v128_t above = wasm_f32x4_gt(v, last);
+        outside = wasm_v128_or(below, above);
+        return wasm_v128_bitselect(last, wasm_v128_andnot(v, below), above);
+    }
+#endif
+};
+
+
+// Agent hitting wall stops there and turns back along axis it crossed
+struct ReflectBoundary : ClampBoundary
+{
+    static void confine(Agent& a, float w, float h)
+    {
+        const float x = coord(a.x, w);
+        const float y = coord(a.y, h);
+        a.dx = x != a.x ? -a.dx : a.dx;
+        a.dy = y != a.y ? -a.dy : a.dy;
+        a.x = x;
+        a.y = y;
+    }
+
+    // Mirrored heading is half turn minus heading for x, minus heading for y
+    static void confineCompact(CompactAgent& a, uint32_t mx, uint32_t my, uint32_t heading,
+        uint32_t limitX, uint32_t limitY)
+    {
+        const uint32_t x = compactStep(a.x, mx, limitX);
+        const uint32_t y = compactStep(a.y, my, limitY);
+        if (x != a.x + mx)
+            heading = DIRECTIONS / 2 - heading;
+        if (y != a.y + my)
+            heading = 0 - heading;
+        a.x = x;
+        a.y = (y & ~HEADING_MASK) | (heading & HEADING_MASK);
+    }
+
+#if defined(USE_AVX2)
+    static void confine(__m256& x, __m256& y, __m256& dx, __m256& dy, __m256 w, __m256 h)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        __m256 outX, outY;
+        x = coord(x, _mm256_sub_ps(w, one), outX);
+        y = coord(y, _mm256_sub_ps(h, one), outY);
+        dx = _mm256_xor_ps(dx, _mm256_and_ps(outX, signMask));
+        dy = _mm256_xor_ps(dy, _mm256_and_ps(outY, signMask));
+    }
+
+    static void confineCompact(__m256i& x, __m256i& y, __m256i mx, __m256i my, __m256i heading,
+        __m256i limitX, __m256i limitY)
+    {
+        const __m256i nx = compactStep(x, mx, limitX);
+        const __m256i ny = compactStep(y, my, limitY);
+        const __m256i outX = _mm256_xor_si256(_mm256_cmpeq_epi32(nx, _mm256_add_epi32(x, mx)), _mm256_set1_epi32(-1));
+        const __m256i outY = _mm256_xor_si256(_mm256_cmpeq_epi32(ny, _mm256_add_epi32(y, my)), _mm256_set1_epi32(-1));
+        heading = _mm256_blendv_epi8(heading, _mm256_sub_epi32(_mm256_set1_epi32(DIRECTIONS / 2), heading), outX);
+        heading = _mm256_blendv_epi8(heading, _mm256_sub_epi32(_mm256_setzero_si256(), heading), outY);
+        const __m256i mask = _mm256_set1_epi32(HEADING_MASK);
+        x = nx;
+        y = _mm256_or_si256(_mm256_andnot_si256(mask, ny), _mm256_and_si256(heading, mask));
+    }
+#elif defined(USE_WASM_SIMD)
+    static void confine(v128_t& x, v128_t& y, v128_t& dx, v128_t& dy, v128_t w, v128_t h)
+    {
+        const v128_t one = wasm_f32x4_splat(1.0f);
+        const v128_t signMask = wasm_f32x4_splat(-0.0f);
+        v128_t outX, outY;
+        x = coord(x, wasm_f32x4_sub(w, one), outX);
+        y = coord(y, wasm_f32x4_sub(h, one), outY);
+        dx = wasm_v128_xor(dx, wasm_v128_and(outX, signMask));
+        dy = wasm_v128_xor(dy, wasm_v128_and(outY, signMask));
+    }
+#endif
+};
+
+
+// Wall absorbs agent, it enters again at place hashed from position where it
+// left, keeping heading. Population stays constant and results reproducible.
+struct AbsorbBoundary : ClampBoundary
+{
+    static void confine(Agent& a, float w, float h)
+    {
+        const float lastX = w - 1.0f;
+        const float lastY = h - 1.0f;
+        const bool outside = (a.x < 0.0f) | (a.x > lastX) | (a.y < 0.0f) | (a.y > lastY);
+        const uint32_t r = hash32(std::bit_cast<uint32_t>(a.x) ^ hash32(std::bit_cast<uint32_t>(a.y)));
+        a.x = outside ? unitFloat(r) * lastX : a.x;
+        a.y = outside ? unitFloat(hash32(r)) * lastY : a.y;
+    }
+
+    // Position from top 16 bits of hash scaled by limit stays within it
+    static void confineCompact(CompactAgent& a, uint32_t mx, uint32_t my, uint32_t heading,
+        uint32_t limitX, uint32_t limitY)
+    {
+        const uint32_t x = a.x + mx;
+        const uint32_t y = a.y + my;
+        const bool outside = compactStep(a.x, mx, limitX) != x || compactStep(a.y, my, limitY) != y;
+        const uint32_t r = hash32(x ^ hash32(y));
+        a.x = outside ? (r >> 16) * (limitX >> 16) : x;
+        a.y = ((outside ? (hash32(r) >> 16) * (limitY >> 16) : y) & ~HEADING_MASK) | heading;
+    }
+
+#if defined(USE_AVX2)
+    static __m256i hash(__m256i x)
+    {
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846ca68b)));
+        return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    }
+
+    static __m256 unit(__m256i r)
+    {
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(r, 8)), _mm256_set1_ps(0x1p-24f));
+    }
+
+    static void confine(__m256& x, __m256& y, __m256& /*dx*/, __m256& /*dy*/, __m256 w, __m256 h)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 lastX = _mm256_sub_ps(w, one);
+        const __m256 lastY = _mm256_sub_ps(h, one);
+        __m256 outX, outY;
+        coord(x, lastX, outX);
+        coord(y, lastY, outY);
+        const __m256 outside = _mm256_or_ps(outX, outY);
+        const __m256i r = hash(_mm256_xor_si256(_mm256_castps_si256(x), hash(_mm256_castps_si256(y))));
+        x = _mm256_blendv_ps(x, _mm256_mul_ps(unit(r), lastX), outside);
+        y = _mm256_blendv_ps(y, _mm256_mul_ps(unit(hash(r)), lastY), outside);
+    }
+
+    static void confineCompact(__m256i& x, __m256i& y, __m256i mx, __m256i my, __m256i heading,
+        __m256i limitX, __m256i limitY)
+    {
+        const __m256i nx = _mm256_add_epi32(x, mx);
+        const __m256i ny = _mm256_add_epi32(y, my);
+        const __m256i insideX = _mm256_cmpeq_epi32(compactStep(x, mx, limitX), nx);
+        const __m256i insideY = _mm256_cmpeq_epi32(compactStep(y, my, limitY), ny);
+        const __m256i inside = _mm256_and_si256(insideX, insideY);
+        const __m256i r = hash(_mm256_xor_si256(nx, hash(ny)));
+        const __m256i rx = _mm256_mullo_epi32(_mm256_srli_epi32(r, 16), _mm256_srli_epi32(limitX, 16));
+        const __m256i ry = _mm256_mullo_epi32(_mm256_srli_epi32(hash(r), 16), _mm256_srli_epi32(limitY, 16));
+        x = _mm256_blendv_epi8(rx, nx, inside);
+        y = _mm256_or_si256(_mm256_andnot_si256(_mm256_set1_epi32(HEADING_MASK), _mm256_blendv_epi8(ry, ny, inside)), heading);
+    }
+#elif defined(USE_WASM_SIMD)
+    static v128_t hash(v128_t x)
+    {
+        x = wasm_v128_xor(x, wasm_u32x4_shr(x, 16));
+        x = wasm_i32x4_mul(x, wasm_i32x4_splat(0x7feb352d));
+        x = wasm_v128_xor(x, wasm_u32x4_shr(x, 15));
+        x = wasm_i32x4_mul(x, wasm_i32x4_splat(static_cast<int32_t>(0x846ca68b)));
+        return wasm_v128_xor(x, wasm_u32x4_shr(x, 16));
+    }
+
+    static v128_t unit(v128_t r)
+    {
+        return wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_u32x4_shr(r, 8)), wasm_f32x4_splat(0x1p-24f));
+    }
+
+    static void confine(v128_t& x, v128_t& y, v128_t& /*dx*/, v128_t& /*dy*/, v128_t w, v128_t h)
+    {
+        const v128_t one = wasm_f32x4_splat(1.0f);
+        const v128_t lastX = wasm_f32x4_sub(w, one);
+        const v128_t lastY = wasm_f32x4_sub(h, one);
+        v128_t outX, outY;
+        coord(x, lastX, outX);
+        coord(y, lastY, outY);
+        const v128_t outside = wasm_v128_or(outX, outY);
+        const v128_t r = hash(wasm_v128_xor(x, hash(y)));
+        x = wasm_v128_bitselect(wasm_f32x4_mul(unit(r), lastX), x, outside);
+        y = wasm_v128_bitselect(wasm_f32x4_mul(unit(hash(r)), lastY), y, outside);
+    }
+#endif
+};
+
+
+// Calls fn with policy object of boundary
+template <typename Fn>
+void withBoundary(SlimeMoldSimulation::Boundary boundary, Fn&& fn)
+{
+    switch (boundary) {
+    case SlimeMoldSimulation::BOUNDARY_REFLECT:
+        fn(ReflectBoundary{});
+        break;
+    case SlimeMoldSimulation::BOUNDARY_ABSORB:
+        fn(AbsorbBoundary{});
+        break;
+    default:
+        fn(WrapBoundary{});
+        break;
+    }
+}
+
+
+inline CompactAgent toCompact(const Agent& a, double width, double height)
+{
+    const double angle = std::atan2(a.dy, a.dx);
+    const auto heading = static_cast<uint32_t>(std::lround(angle * (DIRECTIONS / (2.0 * std::numbers::pi)))) & HEADING_MASK;
+    // Conversion to unsigned wraps position rounded up to full size
+    const auto x = static_cast<uint32_t>(std::llround(a.x / width * 0x1p32));
+    const auto y = static_cast<uint32_t>(std::llround(a.y / height * 0x1p20)) << DIRECTION_BITS;
+    return { x, y | heading };
+}
+
+
+inline Agent toFloat(const CompactAgent& a, float width, float height)
+{
+    const auto& dirs = directionTable();
+    const uint32_t heading = a.y & HEADING_MASK;
+    float x = static_cast<float>(a.x * 0x1p-32 * width);
+    float y = static_cast<float>((a.y >> DIRECTION_BITS) * 0x1p-20 * height);
+    if (x >= width)  x -= width;
+    if (y >= height) y -= height;
+    return { x, y, dirs.cos[heading], dirs.sin[heading] };
+}
+
+
+// Offsets of compact agent for every heading, built for preset, field size and
+// pyramid level sensors read. Arrays are separate for gathers. Y offsets are
+// multiples of DIRECTIONS, so adding them keeps heading bits. Angles are in
+// heading steps.
+struct CompactTables
+{
+    float sensorAngleRad = 0.0f, turnAngleRad = 0.0f;
+    float sensorDist = -1.0f, stepSize = -1.0f;
+    size_t level = 0;
+    uint32_t sensorAngle = 0, turnAngle = 0;
+    std::vector<uint32_t> sensorX, sensorY;
+    std::vector<uint32_t> moveX, moveY;
+    //! Largest coordinates within field and within level sensors read, nearest
+    //! cell of them is last one. Y limits have all heading bits set.
+    uint32_t limitX = 0, limitY = 0;
+    uint32_t sensorLimitX = 0, sensorLimitY = 0;
+};
+
+
+void buildCompactTables(CompactTables& t, const AgentPreset& p, size_t width, size_t height, size_t level)
+{
+    if (t.sensorAngleRad == p.sensor_angle && t.turnAngleRad == p.turn_angle
+        && t.sensorDist == p.sensor_dist && t.stepSize == p.step_size && t.level == level)
+        return;
+    t.sensorAngleRad = p.sensor_angle;
+    t.turnAngleRad = p.turn_angle;
+    t.sensorDist = p.sensor_dist;
+    t.stepSize = p.step_size;
+    t.level = level;
+
+    const double toHeading = DIRECTIONS / (2.0 * std::numbers::pi);
+    t.sensorAngle = static_cast<uint32_t>(std::lround(p.sensor_angle * toHeading)) & HEADING_MASK;
+    t.turnAngle = static_cast<uint32_t>(std::lround(p.turn_angle * toHeading)) & HEADING_MASK;
+    t.sensorX.resize(DIRECTIONS);
+    t.sensorY.resize(DIRECTIONS);
+    t.moveX.resize(DIRECTIONS);
+    t.moveY.resize(DIRECTIONS);
+    auto limit = [](size_t size, int bits) {
+        return static_cast<uint32_t>(((uint64_t(size) - 1) << bits) / size);
+    };
+    t.limitX = limit(width, 32);
+    t.limitY = (limit(height, 20) << DIRECTION_BITS) | HEADING_MASK;
+    t.sensorLimitX = limit(width >> level, 32);
+    t.sensorLimitY = (limit(height >> level, 20) << DIRECTION_BITS) | HEADING_MASK;
+    const double scaleX = 0x1p32 / width;
+    const double scaleY = 0x1p20 / height;
+    // Sensor cell is nearest of level, shift aligns its centers as in float agents
+    const double shift = ((size_t(1) << level) - 1) * 0.5;
+    for (size_t i = 0; i < DIRECTIONS; ++i) {
+        const double angle = i / toHeading;
+        const double c = std::cos(angle);
+        const double s = std::sin(angle);
+        // Negative offsets wrap to two's complement
+        t.sensorX[i] = static_cast<uint32_t>(std::llround((c * p.sensor_dist - shift) * scaleX));
+        t.sensorY[i] = static_cast<uint32_t>(std::llround((s * p.sensor_dist - shift) * scaleY)) << DIRECTION_BITS;
+        t.moveX[i] = static_cast<uint32_t>(std::llround(c * p.step_size * scaleX));
+        t.moveY[i] = static_cast<uint32_t>(std::llround(s * p.step_size * scaleY)) << DIRECTION_BITS;
+    }
+}
+
+
+// Child of splitting agent, random direction
+inline Agent childAgent(const Agent& parent, uint32_t random)
+{
+    const float angle = (random * 0x1p-32f) * 2.0f * std::numbers::pi_v<float>;
+    return { parent.x, parent.y, std::cos(angle), std::sin(angle) };
+}
+
+
+inline CompactAgent childAgent(const CompactAgent& parent, uint32_t random)
+{
+    return { parent.x, (parent.y & ~HEADING_MASK) | (random >> (32 - DIRECTION_BITS)) };
+}
+
+
+// Geometry of spawn shapes
+struct SpawnShape
+{
+    float width, height;
+    float centerX, centerY;
+    float radius;
+};
+
+constexpr float SPAWN_RADIUS = 0.4f;        // of smaller field dimension
+constexpr float RING_INNER = 0.95f;         // inner radius of ring relative to outer
+constexpr float POISSON_SPACING = 0.75f;    // minimal distance relative to sqrt(area per agent)
+constexpr int POISSON_CANDIDATES = 30;
+
+
+// Agent i of uniform, disc or ring distribution
+inline Agent spawnShapeAgent(SlimeMoldSimulation::SpawnMode mode, const SpawnShape& s, uint32_t salt, size_t i)
+{
+    const auto& dirs = directionTable();
+    const uint32_t r0 = randomWord(salt, i, 0);
+    const uint32_t r1 = randomWord(salt, i, 1);
+    const uint32_t heading = randomWord(salt, i, 2) >> (32 - DIRECTION_BITS);
+    Agent a;
+    if (mode == SlimeMoldSimulation::SPAWN_UNIFORM) {
+        a = { unitFloat(r0) * s.width, unitFloat(r1) * s.height, dirs.cos[heading], dirs.sin[heading] };
+    }
+    else {
+        // Disc has uniform area density, ring is thin band facing inward
+        const uint32_t angle = r1 >> (32 - DIRECTION_BITS);
+        const float r = mode == SlimeMoldSimulation::SPAWN_DISC
+            ? s.radius * std::sqrt(unitFloat(r0))
+            : s.radius * (RING_INNER + (1.0f - RING_INNER) * unitFloat(r0));
+        a.x = s.centerX + r * dirs.cos[angle];
+        a.y = s.centerY + r * dirs.sin[angle];
+        a.dx = mode == SlimeMoldSimulation::SPAWN_DISC ? dirs.cos[heading] : -dirs.cos[angle];
+        a.dy = mode == SlimeMoldSimulation::SPAWN_DISC ? dirs.sin[heading] : -dirs.sin[angle];
+    }
+    // Rounding can reach far edge
+    if (a.x >= s.width)  a.x -= s.width;
+    if (a.y >= s.height) a.y -= s.height;
+    return a;
+}
+
+
+#if defined(USE_AVX2)
+// Same as spawnShapeAgent for 8 consecutive agents, results are bit-identical
+inline void spawnShapeAgentsAvx2(Agent* agents, SlimeMoldSimulation::SpawnMode mode, const SpawnShape& s, uint32_t salt, size_t first)
+{
+    const auto& dirs = directionTable();
+
+    // === Step 1: Random words, lowbias32 of (i * 4 + k) ^ salt ===
+    const __m256i index4 = _mm256_slli_epi32(
+        _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(first)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)), 2);
+    auto word = [&](int k) {
+        __m256i x = _mm256_xor_si256(_mm256_add_epi32(index4, _mm256_set1_epi32(k)), _mm256_set1_epi32(static_cast<int>(salt)));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846ca68b)));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        return x;
+    };
+    auto unit = [](__m256i r) {
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(r, 8)), _mm256_set1_ps(0x1p-24f));
+    };
+    const __m256i r0 = word(0);
+    const __m256i r1 = word(1);
+    const __m256i heading = _mm256_srli_epi32(word(2), 32 - DIRECTION_BITS);
+
+    // === Step 2: Positions and headings, directions are gathered from table ===
+    const __m256 width = _mm256_set1_ps(s.width);
+    const __m256 height = _mm256_set1_ps(s.height);
+    __m256 x, y, dx, dy;
+    if (mode == SlimeMoldSimulation::SPAWN_UNIFORM) {
+        x = _mm256_mul_ps(unit(r0), width);
+        y = _mm256_mul_ps(unit(r1), height);
+        dx = _mm256_i32gather_ps(dirs.cos.data(), heading, 4);
+        dy = _mm256_i32gather_ps(dirs.sin.data(), heading, 4);
+    }
+    else {
+        const __m256i angle = _mm256_srli_epi32(r1, 32 - DIRECTION_BITS);
+        const __m256 radius = _mm256_set1_ps(s.radius);
+        const __m256 r = mode == SlimeMoldSimulation::SPAWN_DISC
+            ? _mm256_mul_ps(radius, _mm256_sqrt_ps(unit(r0)))
+            : _mm256_mul_ps(radius, _mm256_add_ps(_mm256_set1_ps(RING_INNER),
+                _mm256_mul_ps(_mm256_set1_ps(1.0f - RING_INNER), unit(r0))));
+        const __m256 cosA = _mm256_i32gather_ps(dirs.cos.data(), angle, 4);
+        const __m256 sinA = _mm256_i32gather_ps(dirs.sin.data(), angle, 4);
+        x = _mm256_add_ps(_mm256_set1_ps(s.centerX), _mm256_mul_ps(r, cosA));
+        y = _mm256_add_ps(_mm256_set1_ps(s.centerY), _mm256_mul_ps(r, sinA));
+        if (mode == SlimeMoldSimulation::SPAWN_DISC) {
+            dx = _mm256_i32gather_ps(dirs.cos.data(), heading, 4);
+            dy = _mm256_i32gather_ps(dirs.sin.data(), heading, 4);
+        }
+        else {
+            const __m256 signMask = _mm256_set1_ps(-0.0f);
+            dx = _mm256_xor_ps(cosA, signMask);
+            dy = _mm256_xor_ps(sinA, signMask);
+        }
+    }
+    x = _mm256_sub_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, width, _CMP_GE_OQ), width));
+    y = _mm256_sub_ps(y, _mm256_and_ps(_mm256_cmp_ps(y, height, _CMP_GE_OQ), height));
+
+    // === Step 3: Transpose SoA to AoS and store ===
+    const __m256 u0 = _mm256_unpacklo_ps(x, y);        // [x0, y0, x1, y1 | x4, y4, x5, y5]
+    const __m256 u1 = _mm256_unpackhi_ps(x, y);
+    const __m256 u2 = _mm256_unpacklo_ps(dx, dy);
+    const __m256 u3 = _mm256_unpackhi_ps(dx, dy);
+    float* dst = reinterpret_cast<float*>(agents);
+    _mm256_storeu2_m128(dst + 16, dst + 0,  _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(1, 0, 1, 0)));
+    _mm256_storeu2_m128(dst + 20, dst + 4,  _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(3, 2, 3, 2)));
+    _mm256_storeu2_m128(dst + 24, dst + 8,  _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(1, 0, 1, 0)));
+    _mm256_storeu2_m128(dst + 28, dst + 12, _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(3, 2, 3, 2)));
+}
+#endif
+
+
+// Agent fate decided in lifecycle pass
+enum Fate : uint8_t {
+    FATE_DEAD  = 0,
+    FATE_ALIVE = 1,
+    FATE_SPAWN = 3,     // alive and splits
+};
+
+
+// Work split for thread pool, field chunk must be multiple of 8 (AVX2 width)
+constexpr size_t AGENT_CHUNK = 4096;
+constexpr size_t FIELD_CHUNK = 16384;
+
+
+// Evaporation works on tiles. Cells decayed below FIELD_EPSILON are cleared,
+// tile cleared entirely is skipped until agent deposits into it again. Epsilon
+// maps to at most 0.1 of palette index with brightest tone mapping.
+constexpr size_t TILE_X_SHIFT = 7;
+constexpr size_t TILE_Y_SHIFT = 3;
+constexpr size_t TILE_WIDTH = size_t(1) << TILE_X_SHIFT;
+constexpr size_t TILE_HEIGHT = size_t(1) << TILE_Y_SHIFT;
+constexpr float FIELD_EPSILON = 1e-4f;
+
+
+// Parallel deposit bins agents by bands of whole tile rows, band owns its cells
+// and tiles. Bands are fixed by field size, not by thread count.
+constexpr size_t DEPOSIT_BAND_SHIFT = TILE_Y_SHIFT + 2;
+
+
+// Multiplies `rows` rows of `n` cells by `evaporate` and clears cells below
+// epsilon, returns max of result
+inline float evaporateTile(float* data, size_t stride, size_t n, size_t rows, float evaporate, bool simd)
+{
+    float maxValue = 0.0f;
+    size_t simdEnd = 0;
+    if (simd) {
+#if defined(USE_AVX2)
+        simdEnd = n & ~size_t(7);
+        const __m256 evaporateVec = _mm256_set1_ps(evaporate);
+        const __m256 epsilon = _mm256_set1_ps(FIELD_EPSILON);
+        __m256 maxVec = _mm256_setzero_ps();
+        for (size_t y = 0; y < rows; ++y) {
+            float* row = data + y * stride;
+            for (size_t i = 0; i < simdEnd; i += 8) {
+                __m256 values = _mm256_mul_ps(_mm256_loadu_ps(row + i), evaporateVec);
+                values = _mm256_and_ps(values, _mm256_cmp_ps(values, epsilon, _CMP_GE_OQ));
+                maxVec = _mm256_max_ps(maxVec, values);
+                _mm256_storeu_ps(row + i, values);
+            }
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, maxVec);
+        maxValue = *std::max_element(lanes, lanes + 8);
+#elif defined(USE_WASM_SIMD)
+        simdEnd = n & ~size_t(3);
+        const v128_t evaporateVec = wasm_f32x4_splat(evaporate);
+        const v128_t epsilon = wasm_f32x4_splat(FIELD_EPSILON);
+        v128_t maxVec = wasm_f32x4_splat(0.0f);
+        for (size_t y = 0; y < rows; ++y) {
+            float* row = data + y * stride;
+            for (size_t i = 0; i < simdEnd; i += 4) {
+                v128_t values = wasm_f32x4_mul(wasm_v128_load(row + i), evaporateVec);
+                values = wasm_v128_and(values, wasm_f32x4_ge(values, epsilon));
+                maxVec = wasm_f32x4_max(maxVec, values);
+                wasm_v128_store(row + i, values);
+            }
+        }
+        alignas(16) float lanes[4];
+        wasm_v128_store(lanes, maxVec);
+        maxValue = *std::max_element(lanes, lanes + 4);
+#endif
+    }
+    // Whole tile in scalar kernels, otherwise last columns of partial edge tile
+    for (size_t y = 0; y < rows; ++y) {
+        float* row = data + y * stride;
+        for (size_t i = simdEnd; i < n; ++i) {
+            const float value = row[i] * evaporate;
+            row[i] = value >= FIELD_EPSILON ? value : 0.0f;
+            maxValue = std::max(maxValue, row[i]);
+        }
+    }
+    return maxValue;
+}
+
+
+// Pyramid of field for long range sensors. Sensors at least twice
+// PYRAMID_MIN_DIST away read coarser level, so they are 4 to 8 cells away
+// in cells of that level.
+constexpr size_t PYRAMID_LEVELS = 3;
+constexpr float PYRAMID_MIN_DIST = 4.0f;
+
+
+// Averages 2x2 cells of `rows` rows of `n` cells (both even) into cells of next level
+inline void downsample(const float* src, size_t srcStride, float* dst, size_t dstStride, size_t n, size_t rows, bool simd)
+{
+    for (size_t y = 0; y < rows; y += 2) {
+        const float* row0 = src + y * srcStride;
+        const float* row1 = row0 + srcStride;
+        float* out = dst + (y / 2) * dstStride;
+        size_t i = 0;
+        if (simd) {
+#if defined(USE_AVX2)
+            // Horizontal add pairs sums of columns as scalar code does, permute restores order
+            const __m256 quarter = _mm256_set1_ps(0.25f);
+            for (; i + 16 <= n; i += 16) {
+                const __m256 s0 = _mm256_add_ps(_mm256_loadu_ps(row0 + i), _mm256_loadu_ps(row1 + i));
+                const __m256 s1 = _mm256_add_ps(_mm256_loadu_ps(row0 + i + 8), _mm256_loadu_ps(row1 + i + 8));
+                const __m256 sums = _mm256_castpd_ps(_mm256_permute4x64_pd(
+                    _mm256_castps_pd(_mm256_hadd_ps(s0, s1)), _MM_SHUFFLE(3, 1, 2, 0)));
+                _mm256_storeu_ps(out + i / 2, _mm256_mul_ps(sums, quarter));
+            }
+#elif defined(USE_WASM_SIMD)
+            const v128_t quarter = wasm_f32x4_splat(0.25f);
+            for (; i + 8 <= n; i += 8) {
+                const v128_t s0 = wasm_f32x4_add(wasm_v128_load(row0 + i), wasm_v128_load(row1 + i));
+                const v128_t s1 = wasm_f32x4_add(wasm_v128_load(row0 + i + 4), wasm_v128_load(row1 + i + 4));
+                const v128_t sums = wasm_f32x4_add(wasm_i32x4_shuffle(s0, s1, 0, 2, 4, 6), wasm_i32x4_shuffle(s0, s1, 1, 3, 5, 7));
+                wasm_v128_store(out + i / 2, wasm_f32x4_mul(sums, quarter));
+            }
+#endif
+        }
+        for (; i < n; i += 2)
+            out[i / 2] = ((row0[i] + row1[i]) + (row0[i + 1] + row1[i + 1])) * 0.25f;
+    }
+}
+
 } // anonymous namespace
 
 
 
-class SlimeMoldSimulation::Private final
+class SlimeMoldSimulation::Private final
+{
+public:
+    Private(size_t width, size_t height, size_t numAgents, uint32_t seed);
+    template <typename Policy>
+    inline float sampleField(const SensorField& f, float x, float y) const;
+    template <typename Policy>
+    inline float sampleFieldBilinear(const SensorField& f, float x, float y) const;
+    inline void deposit(const Agent& a);
+    inline void deposit(const CompactAgent& a);
+    inline void touchTile(int xi, int yi);
+    inline DepositEntry depositEntry(const Agent& a) const;
+    inline DepositEntry depositEntry(const CompactAgent& a) const;
+    bool binnedDeposit() const;
+    template <typename AgentType>
+    void depositBinned(const std::vector<AgentType>& agents);
+    inline size_t cellIndex(const Agent& a) const;
+    inline size_t cellIndex(const CompactAgent& a) const;
+    void resetAgents(size_t first = 0);
+    void setAgentFormat(AgentFormat format);
+    void packAgents();
+    void unpackAgents();
+    void spawnShape(uint32_t salt);
+    void spawnImage(uint32_t salt);
+    void spawnPoisson(uint32_t salt);
+    void diffuse(float evaporate);
+    void diffuseWithInputs(float evaporate);
+    size_t sensorLevel(float sensorDist) const;
+    SensorField sensorField(size_t level) const;
+    void buildPyramid(size_t level);
+    void setSensorPyramid(bool enabled);
+    template <typename Policy>
+    inline void avoidObstacle(Agent& a, float step_size) const;
+    template <typename Policy>
+    inline void avoidObstacle(CompactAgent& a) const;
+    void clearField();
+    void updateAgents(const AgentPreset& p);
+    template <typename Policy>
+    void moveAgents(const StepParams& k);
+    template <typename Policy>
+    inline void updateAgent(Agent& a, const StepParams& k) const;
+#if defined(USE_AVX2)
+    template <typename Policy>
+    inline void updateAgentsBilinearAvx2(Agent* agents, const StepParams& k) const;
+#endif
+#if defined(USE_WASM_SIMD)
+    template <typename Policy>
+    inline void updateAgentsWasm(Agent* agents, const StepParams& k) const;
+#endif
+    void updateCompactAgents(const AgentPreset& p, const SensorField& field);
+    template <typename Policy>
+    void moveCompactAgents(const SensorField& field, bool bilinear);
+    template <typename Policy>
+    inline float sampleCompact(const SensorField& f, uint32_t x, uint32_t y, bool bilinear) const;
+    template <typename Policy>
+    inline void updateCompactAgent(CompactAgent& a, const SensorField& f, bool bilinear) const;
+#if defined(USE_AVX2)
+    template <typename Policy>
+    inline void updateCompactAgentsAvx2(CompactAgent* agents, const SensorField& f, bool bilinear) const;
+#endif
+    void sortAgents();
+    void resetLifecycle();
+    void updateLifecycle();
+    template <typename AgentType>
+    void updateLifecycle(std::vector<AgentType>& agents, std::vector<AgentType>& agentsNext);
+    inline void enterPhase(Phase phase) const;
+
+    size_t m_width, m_height;
+    size_t m_numAgents;
+    size_t m_activeAgents;
+    size_t m_agentLimit;
+    //! Agents are in m_agents or m_compact depending on format, other one is empty
+    AgentFormat m_agentFormat;
+    std::vector<Agent> m_agents;
+    std::vector<CompactAgent> m_compact;
+    CompactTables m_compactTables;
+    std::vector<float> m_field;
+    size_t m_passes;
+
+    //! Evaporation tiles of TILE_WIDTH x TILE_HEIGHT cells, partial at right and
+    //! bottom edge. Max of tile is 0 when tile is cleared, touched means deposit
+    //! since last evaporation.
+    size_t m_tilesX, m_tilesY;
+    std::vector<float> m_tileMax;
+    std::vector<uint8_t> m_tileTouched;
+
+    //! Levels of sensor pyramid, level L at index L - 1 has size of field
+    //! divided by 2^L. Allocated when enabled, level 1 is updated with
+    //! evaporation and kept zero under cleared tiles, higher levels are
+    //! rebuilt from it up to level sensors read.
+    bool m_pyramidEnabled;
+    size_t m_pyramidMaxLevel;   // highest level dividing field size
+    size_t m_pyramidValid;      // levels up to date
+    size_t m_pyramidLevel;      // level read in last step
+    std::vector<std::vector<float>> m_pyramid;
+    std::mt19937 m_rng;
+    Sampling m_sampling;
+    Boundary m_boundary;
+    SpawnMode m_spawnMode;
+    Kernels m_kernels;
+    InputMap m_inputs;
+
+    //! Lifecycle state, allocated when lifecycle is enabled. Next buffers
+    //! receive compacted agents, counts are per AGENT_CHUNK.
+    Lifecycle m_lifecycle;
+    std::vector<float> m_energy, m_energyNext;
+    std::vector<uint32_t> m_age, m_ageNext;
+    std::vector<Agent> m_agentsNext;
+    std::vector<CompactAgent> m_compactNext;
+    std::vector<uint8_t> m_fate;
+    std::vector<size_t> m_chunkAlive, m_chunkSpawn;
+
+    //! Binned deposit: entries of agents, same entries grouped by band in
+    //! agent order, offsets per AGENT_CHUNK and band and start of each band
+    std::vector<DepositEntry> m_depositEntries, m_depositSorted;
+    std::vector<size_t> m_depositOffsets, m_bandStart;
+
+    PhaseCallback m_phaseCallback;
+};
+
+
+SlimeMoldSimulation::Private::Private(size_t width, size_t height, size_t numAgents, uint32_t seed)
+    : m_width(width)
+    , m_height(height)
+    , m_numAgents(numAgents)
+    , m_activeAgents(numAgents)
+    , m_agentLimit(numAgents)
+    , m_agentFormat(AGENTS_FLOAT)
+    , m_passes(0)
+    , m_tilesX((width + TILE_WIDTH - 1) >> TILE_X_SHIFT)
+    , m_tilesY((height + TILE_HEIGHT - 1) >> TILE_Y_SHIFT)
+    , m_pyramidEnabled(false)
+    , m_pyramidMaxLevel(0)
+    , m_pyramidValid(0)
+    , m_pyramidLevel(0)
+    , m_rng(seed != 0 ? seed : static_cast<uint32_t>(time(0)))
+    , m_sampling(SAMPLING_NEAREST)
+    , m_boundary(BOUNDARY_WRAP)
+    , m_spawnMode(SPAWN_UNIFORM)
+    , m_kernels(KERNELS_SIMD)
+{
+    m_agents.resize(numAgents);
+    m_field.resize(width * height, 0.0f);
+    m_tileMax.resize(m_tilesX * m_tilesY, 0.0f);
+    m_tileTouched.resize(m_tilesX * m_tilesY, 0);
+    while (m_pyramidMaxLevel < PYRAMID_LEVELS
+        && (width >> m_pyramidMaxLevel) % 2 == 0 && (height >> m_pyramidMaxLevel) % 2 == 0)
+        ++m_pyramidMaxLevel;
+    resetAgents();
+}
+
+
+// Agents below `first` are kept, spawning writes all of them so they are restored after it
+void SlimeMoldSimulation::Private::resetAgents(size_t first)
+{
+    std::vector<Agent> kept;
+    std::vector<CompactAgent> keptCompact;
+    if (m_agentFormat == AGENTS_COMPACT)
+        keptCompact.assign(m_compact.begin(), m_compact.begin() + first);
+    else
+        kept.assign(m_agents.begin(), m_agents.begin() + first);
+    // Spawning works on float agents, compact ones are converted from them
+    if (m_agentFormat == AGENTS_COMPACT)
+        m_agents.resize(m_numAgents);
+    // Own engine instead of rand(), simulations can run concurrently and reproducibly.
+    // Engine gives only salt, agents are hashed from it independently in parallel.
+    const uint32_t salt = m_rng();
+    switch (m_spawnMode) {
+    case SPAWN_POISSON:
+        spawnPoisson(salt);
+        break;
+    case SPAWN_IMAGE:
+        if (m_inputs.hasAttractors()) {
+            spawnImage(salt);
+            break;
+        }
+        [[fallthrough]];
+    default:
+        spawnShape(salt);
+        break;
+    }
+    if (m_agentFormat == AGENTS_COMPACT) {
+        packAgents();
+        std::ranges::copy(keptCompact, m_compact.begin());
+    }
+    else {
+        std::ranges::copy(kept, m_agents.begin());
+    }
+}
+
+
+void SlimeMoldSimulation::Private::setAgentFormat(AgentFormat format)
+{
+    if (format == m_agentFormat)
+        return;
+    m_agentFormat = format;
+    if (format == AGENTS_COMPACT)
+        packAgents();
+    else
+        unpackAgents();
+    if (m_lifecycle.enabled) {
+        m_agentsNext = std::vector<Agent>();
+        m_compactNext = std::vector<CompactAgent>();
+        if (format == AGENTS_COMPACT)
+            m_compactNext.resize(m_numAgents);
+        else
+            m_agentsNext.resize(m_numAgents);
+    }
+}
+
+
+// Float agents to compact ones, float array is released
+void SlimeMoldSimulation::Private::packAgents()
+{
+    m_compact.resize(m_agents.size());
+    const double width = static_cast<double>(m_width);
+    const double height = static_cast<double>(m_height);
+    ThreadPool::global().parallelFor(m_agents.size(), AGENT_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            m_compact[i] = toCompact(m_agents[i], width, height);
+    });
+    m_agents = std::vector<Agent>();
+}
+
+
+void SlimeMoldSimulation::Private::unpackAgents()
+{
+    m_agents.resize(m_compact.size());
+    const float width = static_cast<float>(m_width);
+    const float height = static_cast<float>(m_height);
+    ThreadPool::global().parallelFor(m_compact.size(), AGENT_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            m_agents[i] = toFloat(m_compact[i], width, height);
+    });
+    m_compact = std::vector<CompactAgent>();
+}
+
+
+void SlimeMoldSimulation::Private::spawnShape(uint32_t salt)
+{
+    const SpawnMode mode = m_spawnMode == SPAWN_DISC || m_spawnMode == SPAWN_RING ? m_spawnMode : SPAWN_UNIFORM;
+    const SpawnShape shape{
+        static_cast<float>(m_width), static_cast<float>(m_height),
+        m_width * 0.5f, m_height * 0.5f,
+        SPAWN_RADIUS * std::min(m_width, m_height)
+    };
+    ThreadPool::global().parallelFor(m_agents.size(), AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t i = begin;
+#if defined(USE_AVX2)
+        if (m_kernels == KERNELS_SIMD) {
+            for (; i + 8 <= end; i += 8)
+                spawnShapeAgentsAvx2(&m_agents[i], mode, shape, salt, i);
+        }
+#endif
+        for (; i < end; ++i)
+            m_agents[i] = spawnShapeAgent(mode, shape, salt, i);
+    });
+}
+
+
+// Cells are picked from attractor values by alias method (Vose), O(1) per agent
+void SlimeMoldSimulation::Private::spawnImage(uint32_t salt)
+{
+    const size_t n = m_width * m_height;
+    const auto& weights = m_inputs.attractors;
+    double total = 0.0;
+    for (uint8_t w : weights)
+        total += w;
+    if (total == 0.0) {
+        spawnShape(salt);
+        return;
+    }
+
+    // === Alias table ===
+    // Probability and alias of cell together, one cache miss per agent
+    struct AliasEntry {
+        float prob;
+        uint32_t alias;
+    };
+    std::vector<AliasEntry> table(n);
+    std::vector<uint32_t> small, large;
+    std::vector<double> scaled(n);
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = weights[i] * (n / total);
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+        const uint32_t s = small.back();
+        const uint32_t l = large.back();
+        small.pop_back();
+        table[s] = { static_cast<float>(scaled[s]), l };
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Leftovers are 1 up to rounding errors
+    for (uint32_t i : large)
+        table[i] = { 1.0f, i };
+    for (uint32_t i : small)
+        table[i] = { 1.0f, i };
+
+    // === Agents, jittered within picked cell ===
+    const auto& dirs = directionTable();
+    const double invWidth = 1.0 / m_width;
+    ThreadPool::global().parallelFor(m_agents.size(), AGENT_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t cell = std::min(static_cast<size_t>(unitFloat(randomWord(salt, i, 0)) * n), n - 1);
+            const AliasEntry e = table[cell];
+            cell = unitFloat(randomWord(salt, i, 1)) < e.prob ? cell : e.alias;
+            const uint32_t heading = randomWord(salt, i, 2) >> (32 - DIRECTION_BITS);
+            const uint32_t jitter = randomWord(salt, i, 3);
+            // Row by reciprocal, integer division would dominate. Cell centers are at integer coordinates.
+            const size_t row = static_cast<size_t>((cell + 0.5) * invWidth);
+            float x = (cell - row * m_width) + (jitter & 0xffff) * 0x1p-16f - 0.5f;
+            float y = row + (jitter >> 16) * 0x1p-16f - 0.5f;
+            if (x < 0) x += m_width;
+            if (y < 0) y += m_height;
+            m_agents[i] = { x, y, dirs.cos[heading], dirs.sin[heading] };
+        }
+    });
+}
+
+
+// Bridson's algorithm on torus, serial. Spacing is chosen so that there are
+// usually more points than agents, agents take random subset of them.
+void SlimeMoldSimulation::Private::spawnPoisson(uint32_t salt)
+{
+    const float w = static_cast<float>(m_width);
+    const float h = static_cast<float>(m_height);
+    const float r = POISSON_SPACING * std::sqrt(w * h / std::max<size_t>(m_agents.size(), 1));
+    const float cellSize = r / std::numbers::sqrt2_v<float>;
+    const int gw = std::max(1, static_cast<int>(std::ceil(w / cellSize)));
+    const int gh = std::max(1, static_cast<int>(std::ceil(h / cellSize)));
+    std::vector<int32_t> grid(static_cast<size_t>(gw) * gh, -1);
+    std::vector<std::array<float, 2>> points;
+    std::vector<uint32_t> active;
+
+    auto gridIndex = [&](float x, float y) {
+        return std::min(static_cast<int>(y / cellSize), gh - 1) * gw + std::min(static_cast<int>(x / cellSize), gw - 1);
+    };
+    auto fits = [&](float x, float y) {
+        const int gx = std::min(static_cast<int>(x / cellSize), gw - 1);
+        const int gy = std::min(static_cast<int>(y / cellSize), gh - 1);
+        for (int oy = -2; oy <= 2; ++oy) {
+            for (int ox = -2; ox <= 2; ++ox) {
+                const int idx = grid[((gy + oy + gh) % gh) * gw + (gx + ox + gw) % gw];
+                if (idx < 0)
+                    continue;
+                float ddx = std::abs(points[idx][0] - x);
+                float ddy = std::abs(points[idx][1] - y);
+                ddx = std::min(ddx, w - ddx);
+                ddy = std::min(ddy, h - ddy);
+                if (ddx * ddx + ddy * ddy < r * r)
+                    return false;
+            }
+        }
+        return true;
+    };
+    auto add = [&](float x, float y) {
+        grid[gridIndex(x, y)] = static_cast<int32_t>(points.size());
+        active.push_back(static_cast<uint32_t>(points.size()));
+        points.push_back({ x, y });
+    };
+
+    std::mt19937 rng(salt);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    add(unit(rng) * w, unit(rng) * h);
+    while (!active.empty()) {
+        const size_t k = rng() % active.size();
+        const auto p = points[active[k]];
+        bool found = false;
+        for (int c = 0; c < POISSON_CANDIDATES && !found; ++c) {
+            const float angle = unit(rng) * 2.0f * std::numbers::pi_v<float>;
+            const float dist = r * (1.0f + unit(rng));
+            float x = p[0] + dist * std::cos(angle);
+            float y = p[1] + dist * std::sin(angle);
+            x = x < 0 ? x + w : (x >= w ? x - w : x);
+            y = y < 0 ? y + h : (y >= h ? y - h : y);
+            if (x < w && y < h && fits(x, y)) {
+                add(x, y);
+                found = true;
+            }
+        }
+        if (!found) {
+            active[k] = active.back();
+            active.pop_back();
+        }
+    }
+
+    // Random subset (partial shuffle). Agents beyond number of points spawn
+    // uniformly, points reused would stack agents on top of each other.
+    const size_t count = std::min(points.size(), m_agents.size());
+    for (size_t i = 0; i < count; ++i)
+        std::swap(points[i], points[i + rng() % (points.size() - i)]);
+    const auto& dirs = directionTable();
+    for (size_t i = 0; i < count; ++i) {
+        const auto& p = points[i];
+        const uint32_t heading = randomWord(salt, i, 2) >> (32 - DIRECTION_BITS);
+        m_agents[i] = { p[0], p[1], dirs.cos[heading], dirs.sin[heading] };
+    }
+    const SpawnShape shape{ w, h, w * 0.5f, h * 0.5f, 0.0f };
+    for (size_t i = count; i < m_agents.size(); ++i)
+        m_agents[i] = spawnShapeAgent(SPAWN_UNIFORM, shape, salt, i);
+}
+
+
+void SlimeMoldSimulation::Private::diffuse(float evaporate)
+{
+    if (m_inputs.hasObstacles() || m_inputs.hasAttractors()) {
+        diffuseWithInputs(evaporate);
+        return;
+    }
+
+    // Evaporation only for simplicity. Trail dies out below epsilon, so tiles
+    // agents left long ago are cleared once and skipped from then on.
+    float* data = m_field.data();
+    const size_t width = m_width;
+    const size_t height = m_height;
+    const bool simd = m_kernels == KERNELS_SIMD;
+    // Level 1 of pyramid is made from tile while it is in cache
+    float* level1 = m_pyramidEnabled ? m_pyramid[0].data() : nullptr;
+    const size_t width1 = width / 2;
+    ThreadPool::global().parallelFor(m_tilesY, 1, [=, this](size_t begin, size_t end) {
+        for (size_t ty = begin; ty < end; ++ty) {
+            const size_t y0 = ty << TILE_Y_SHIFT;
+            const size_t y1 = std::min(y0 + TILE_HEIGHT, height);
+            for (size_t tx = 0; tx < m_tilesX; ++tx) {
+                const size_t t = ty * m_tilesX + tx;
+                if (m_tileMax[t] == 0.0f && !m_tileTouched[t])
+                    continue;
+                const size_t x0 = tx << TILE_X_SHIFT;
+                const size_t n = std::min(x0 + TILE_WIDTH, width) - x0;
+                // Every cell would fall below epsilon, same result as evaporating them
+                if (!m_tileTouched[t] && m_tileMax[t] * evaporate < FIELD_EPSILON) {
+                    for (size_t y = y0; y < y1; ++y)
+                        std::fill_n(data + y * width + x0, n, 0.0f);
+                    if (level1) {
+                        for (size_t y = y0 / 2; y < y1 / 2; ++y)
+                            std::fill_n(level1 + y * width1 + x0 / 2, n / 2, 0.0f);
+                    }
+                    m_tileMax[t] = 0.0f;
+                    continue;
+                }
+                m_tileMax[t] = evaporateTile(data + y0 * width + x0, width, n, y1 - y0, evaporate, simd);
+                m_tileTouched[t] = 0;
+                if (level1)
+                    downsample(data + y0 * width + x0, width, level1 + (y0 / 2) * width1 + x0 / 2, width1, n, y1 - y0, simd);
+            }
+        }
+    });
+    if (m_pyramidEnabled) {
+        m_pyramidValid = 1;
+        buildPyramid(m_pyramidLevel);
+    }
+}
+
+
+// Evaporation fused with input layers, so they cost no extra pass over field
+void SlimeMoldSimulation::Private::diffuseWithInputs(float evaporate)
+{
+    float* data = m_field.data();
+    const uint8_t* attractors = m_inputs.hasAttractors() ? m_inputs.attractors.data() : nullptr;
+    // Bitmask as bytes of 8 cells, same bit order as uint64_t words on little endian
+    const uint8_t* obstacles = m_inputs.hasObstacles()
+        ? reinterpret_cast<const uint8_t*>(m_inputs.obstacles.data()) : nullptr;
+    const float gain = m_inputs.attractorStrength / 255.0f;
+#if defined(USE_AVX2)
+    const bool simd = m_kernels == KERNELS_SIMD;
+#endif
+    ThreadPool::global().parallelFor(m_field.size(), FIELD_CHUNK, [=](size_t begin, size_t end) {
+#if defined(USE_AVX2)
+        if (simd) {
+            constexpr size_t avxWidth = 8;
+            const __m256 evaporateVec = _mm256_set1_ps(evaporate);
+            const __m256 gainVec = _mm256_set1_ps(gain);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256i bitVec = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+            for (size_t i = begin; i < end; i += avxWidth) {
+                __m256 values = _mm256_mul_ps(_mm256_loadu_ps(data + i), evaporateVec);
+                if (attractors) {
+                    const __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(attractors + i)));
+                    values = _mm256_max_ps(_mm256_add_ps(values, _mm256_mul_ps(_mm256_cvtepi32_ps(a), gainVec)), zero);
+                }
+                if (obstacles) {
+                    // One byte of mask covers all 8 cells, spread its bits to lanes
+                    const __m256i bits = _mm256_and_si256(_mm256_set1_epi32(obstacles[i / 8]), bitVec);
+                    values = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(bits, bitVec)), values);
+                }
+                _mm256_storeu_ps(data + i, values);
+            }
+            return;
+        }
+#endif
+        // NOTE: no SIMD128 variant, input maps are rare in web build
+        for (size_t i = begin; i < end; ++i) {
+            float value = data[i] * evaporate;
+            if (attractors)
+                value = std::max(value + attractors[i] * gain, 0.0f);
+            if (obstacles && ((obstacles[i >> 3] >> (i & 7)) & 1))
+                value = 0.0f;
+            data[i] = value;
+        }
+    });
+    // NOTE: tiles are not skipped with input maps, all are evaporated once they are removed
+    std::ranges::fill(m_tileTouched, 1);
+    // Pyramid is rebuilt in separate pass, input maps are rare
+    if (m_pyramidEnabled) {
+        m_pyramidValid = 0;
+        buildPyramid(std::max<size_t>(m_pyramidLevel, 1));
+    }
+}
+
+
+void SlimeMoldSimulation::Private::clearField()
+{
+    std::ranges::fill(m_field, 0.0f);
+    std::ranges::fill(m_tileMax, 0.0f);
+    std::ranges::fill(m_tileTouched, 0);
+    for (auto& level : m_pyramid)
+        std::ranges::fill(level, 0.0f);
+}
+
+
+size_t SlimeMoldSimulation::Private::sensorLevel(float sensorDist) const
+{
+    if (!m_pyramidEnabled)
+        return 0;
+    size_t level = 0;
+    while (level < m_pyramidMaxLevel && sensorDist >= PYRAMID_MIN_DIST * (2 << level))
+        ++level;
+    return level;
+}
+
+
+SensorField SlimeMoldSimulation::Private::sensorField(size_t level) const
+{
+    const float* data = level == 0 ? m_field.data() : m_pyramid[level - 1].data();
+    return { data, static_cast<int>(m_width >> level), static_cast<int>(m_height >> level) };
+}
+
+
+// Builds levels above valid ones up to `level` from level below
+void SlimeMoldSimulation::Private::buildPyramid(size_t level)
+{
+    const bool simd = m_kernels == KERNELS_SIMD;
+    for (size_t l = m_pyramidValid + 1; l <= level; ++l) {
+        const float* src = l == 1 ? m_field.data() : m_pyramid[l - 2].data();
+        float* dst = m_pyramid[l - 1].data();
+        const size_t srcWidth = m_width >> (l - 1);
+        const size_t dstWidth = m_width >> l;
+        const size_t rowsChunk = std::max<size_t>(1, FIELD_CHUNK / srcWidth);
+        ThreadPool::global().parallelFor(m_height >> l, rowsChunk, [=](size_t begin, size_t end) {
+            downsample(src + 2 * begin * srcWidth, srcWidth, dst + begin * dstWidth, dstWidth,
+                srcWidth, 2 * (end - begin), simd);
+        });
+    }
+    m_pyramidValid = std::max(m_pyramidValid, level);
+}
+
+
+void SlimeMoldSimulation::Private::setSensorPyramid(bool enabled)
+{
+    m_pyramidEnabled = enabled && m_pyramidMaxLevel > 0;
+    m_pyramidValid = 0;
+    m_pyramid.clear();
+    if (m_pyramidEnabled) {
+        for (size_t l = 1; l <= m_pyramidMaxLevel; ++l)
+            m_pyramid.emplace_back((m_width >> l) * (m_height >> l), 0.0f);
+    }
+}
+
+
+template <typename Policy>
+inline float SlimeMoldSimulation::Private::sampleField(const SensorField& f, float x, float y) const
+{
+    const int xi = Policy::cell((int)(x + 0.5f), f.width);
+    const int yi = Policy::cell((int)(y + 0.5f), f.height);
+    const int idx = yi * f.width + xi;
+    return f.data[idx];
+}
+
+
+// Cell centers are at integer coordinates as in sampleField
+template <typename Policy>
+inline float SlimeMoldSimulation::Private::sampleFieldBilinear(const SensorField& f, float x, float y) const
+{
+    const float fx = std::floor(x);
+    const float fy = std::floor(y);
+    const float tx = x - fx;
+    const float ty = y - fy;
+    // Sensors are at most sensor_dist outside
+    const int w = f.width;
+    int x0, x1, y0, y1;
+    Policy::cellPair((int)fx, w, x0, x1);
+    Policy::cellPair((int)fy, f.height, y0, y1);
+
+    const float* row0 = &f.data[y0 * w];
+    const float* row1 = &f.data[y1 * w];
+    const float top    = row0[x0] + tx * (row0[x1] - row0[x0]);
+    const float bottom = row1[x0] + tx * (row1[x1] - row1[x0]);
+    return top + ty * (bottom - top);
+}
+
+
+// Agent which moved into obstacle steps back and turns around. Agent which was
+// already inside (spawned there or map changed) keeps going until it gets out.
+template <typename Policy>
+inline void SlimeMoldSimulation::Private::avoidObstacle(Agent& a, float step_size) const
+{
+    auto isObstacle = [&](float x, float y) {
+        const int xi = ((int)(x + 0.5f) +  m_width) % m_width;
+        const int yi = ((int)(y + 0.5f) + m_height) % m_height;
+        return m_inputs.isObstacle(yi * m_width + xi);
+    };
+    if (!isObstacle(a.x, a.y))
+        return;
+    const float x = Policy::coord(a.x - a.dx * step_size, static_cast<float>(m_width));
+    const float y = Policy::coord(a.y - a.dy * step_size, static_cast<float>(m_height));
+    if (isObstacle(x, y))
+        return;
+    a.x = x;
+    a.y = y;
+    a.dx = -a.dx;
+    a.dy = -a.dy;
+}
+
+
+template <typename Policy>
+inline void SlimeMoldSimulation::Private::avoidObstacle(CompactAgent& a) const
+{
+    const CompactTables& t = m_compactTables;
+    const uint32_t w = static_cast<uint32_t>(m_width);
+    const uint32_t h = static_cast<uint32_t>(m_height);
+    auto isObstacle = [&](uint32_t x, uint32_t y) {
+        return m_inputs.isObstacle(size_t(compactCell(y, h)) * w + compactCell(x, w));
+    };
+    if (!isObstacle(a.x, a.y))
+        return;
+    const uint32_t heading = a.y & HEADING_MASK;
+    const uint32_t x = Policy::compactStep(a.x, 0 - t.moveX[heading], t.limitX);
+    const uint32_t y = Policy::compactStep(a.y, 0 - t.moveY[heading], t.limitY);
+    if (isObstacle(x, y))
+        return;
+    a.x = x;
+    a.y = (y & ~HEADING_MASK) | ((heading + DIRECTIONS / 2) & HEADING_MASK);
+}
+
+
+inline void SlimeMoldSimulation::Private::deposit(const Agent& a) {
+    const int xi = ((int)(a.x + 0.5f) +  m_width) % m_width;
+    const int yi = ((int)(a.y + 0.5f) + m_height) % m_height;
+    const int idx = yi * m_width + xi;
+    m_field[idx] += 1.0f;
+    touchTile(xi, yi);
+}
+
+
+inline void SlimeMoldSimulation::Private::deposit(const CompactAgent& a)
 {
-public:
-    Private(size_t width, size_t height, size_t numAgents);
-    inline float sampleField(float x, float y) const;
-    inline void deposit(const Agent& a);
-    void resetAgents();
-    void diffuse(float evaporate);
-    void clearField();
-    void updateAgents(const AgentPreset& p);
-    void sortAgents();
-
-    size_t m_width, m_height;
-    size_t m_numAgents;
-    std::vector<Agent> m_agents;
-    std::vector<float> m_field;
-    size_t m_passes;
-};
+    const uint32_t xi = compactCell(a.x, static_cast<uint32_t>(m_width));
+    const uint32_t yi = compactCell(a.y, static_cast<uint32_t>(m_height));
+    m_field[yi * m_width + xi] += 1.0f;
+    touchTile(static_cast<int>(xi), static_cast<int>(yi));
+}
 
 
-SlimeMoldSimulation::Private::Private(size_t width, size_t height, size_t numAgents)
-    : m_width(width)
-    , m_height(height)
-    , m_numAgents(numAgents)
-    , m_passes(0)
+inline void SlimeMoldSimulation::Private::touchTile(int xi, int yi)
 {
-    m_agents.resize(numAgents);
-    m_field.resize(width * height, 0.0f);
-    resetAgents();
+    m_tileTouched[(yi >> TILE_Y_SHIFT) * m_tilesX + (xi >> TILE_X_SHIFT)] = 1;
 }
 
 
-void SlimeMoldSimulation::Private::resetAgents()
+// Same cell as deposit
+inline DepositEntry SlimeMoldSimulation::Private::depositEntry(const Agent& a) const
 {
-    srand((unsigned)time(0));
-    for (auto& a : m_agents) {
-        a.x = rand() % m_width;
-        a.y = rand() % m_height;
-        float angle = (rand() / (float)RAND_MAX) * 2.0f * std::numbers::pi_v<float>;
-        a.dx = std::cos(angle);
-        a.dy = std::sin(angle);
-    }
+    const uint32_t xi = static_cast<uint32_t>(((int)(a.x + 0.5f) +  m_width) % m_width);
+    const uint32_t yi = static_cast<uint32_t>(((int)(a.y + 0.5f) + m_height) % m_height);
+    return {
+        static_cast<uint32_t>(yi * m_width + xi),
+        static_cast<uint32_t>((yi >> TILE_Y_SHIFT) * m_tilesX + (xi >> TILE_X_SHIFT)),
+        yi >> DEPOSIT_BAND_SHIFT
+    };
 }
 
 
-void SlimeMoldSimulation::Private::diffuse(float evaporate)
+inline DepositEntry SlimeMoldSimulation::Private::depositEntry(const CompactAgent& a) const
 {
-    // Evaporation only for simplicity
-#if not defined(USE_AVX2)
-    for (float& v : m_field)
-        v *= evaporate;
-#else
-    const size_t count = m_field.size();
-    constexpr size_t avxWidth = 8; // 8 floats per register
-    float* data = m_field.data();
-    const __m256 evaporateVec = _mm256_set1_ps(evaporate);
-    for (size_t i = 0; i < count; i += avxWidth) {
-        __m256 values = _mm256_loadu_ps(data + i);
-        values = _mm256_mul_ps(values, evaporateVec);
-        _mm256_storeu_ps(&data[i], values);
-    }
-#endif
+    const uint32_t xi = compactCell(a.x, static_cast<uint32_t>(m_width));
+    const uint32_t yi = compactCell(a.y, static_cast<uint32_t>(m_height));
+    return {
+        static_cast<uint32_t>(yi * m_width + xi),
+        static_cast<uint32_t>((yi >> TILE_Y_SHIFT) * m_tilesX + (xi >> TILE_X_SHIFT)),
+        yi >> DEPOSIT_BAND_SHIFT
+    };
 }
 
 
-void SlimeMoldSimulation::Private::clearField()
+// Deposit adds 1 to cell, so order of deposits does not change field and
+// binned deposit gives same result as serial one. On one thread binning costs
+// about 1.5 times serial deposit, it pays off with several threads.
+bool SlimeMoldSimulation::Private::binnedDeposit() const
 {
-    diffuse(0.0);
+    return ThreadPool::global().size() >= 4 && m_activeAgents > AGENT_CHUNK;
 }
 
 
-inline float SlimeMoldSimulation::Private::sampleField(float x, float y) const
+// Counting sort of agents by band: first pass counts agents of each band per
+// chunk, exclusive scan in band-major order gives each chunk its place within
+// each band, second pass scatters entries there, then bands deposit in parallel.
+template <typename AgentType>
+void SlimeMoldSimulation::Private::depositBinned(const std::vector<AgentType>& agents)
 {
-    const int xi = ((int)(x + 0.5f) +  m_width) % m_width;
-    const int yi = ((int)(y + 0.5f) + m_height) % m_height;
-    const int idx = yi * m_width + xi;
-    return m_field[idx];
+    const size_t nAgents = m_activeAgents;
+    const size_t nChunks = (nAgents + AGENT_CHUNK - 1) / AGENT_CHUNK;
+    const size_t nBands = ((m_height - 1) >> DEPOSIT_BAND_SHIFT) + 1;
+    m_depositEntries.resize(nAgents);
+    m_depositSorted.resize(nAgents);
+    m_depositOffsets.assign(nChunks * nBands, 0);
+    m_bandStart.resize(nBands + 1);
+
+    // === Pass 1: entries and counts ===
+    ThreadPool::global().parallelFor(nAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t* counts = &m_depositOffsets[begin / AGENT_CHUNK * nBands];
+        for (size_t i = begin; i < end; ++i) {
+            const DepositEntry e = depositEntry(agents[i]);
+            m_depositEntries[i] = e;
+            ++counts[e.band];
+        }
+    });
+
+    // === Exclusive scan ===
+    size_t total = 0;
+    for (size_t b = 0; b < nBands; ++b) {
+        m_bandStart[b] = total;
+        for (size_t c = 0; c < nChunks; ++c)
+            total += std::exchange(m_depositOffsets[c * nBands + b], total);
+    }
+    m_bandStart[nBands] = total;
+
+    // === Pass 2: scatter entries to bands ===
+    ThreadPool::global().parallelFor(nAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t* offsets = &m_depositOffsets[begin / AGENT_CHUNK * nBands];
+        for (size_t i = begin; i < end; ++i) {
+            const DepositEntry& e = m_depositEntries[i];
+            m_depositSorted[offsets[e.band]++] = e;
+        }
+    });
+
+    // === Pass 3: deposit, bands do not share cells or tiles ===
+    ThreadPool::global().parallelFor(nBands, 1, [&](size_t begin, size_t end) {
+        for (size_t i = m_bandStart[begin]; i < m_bandStart[end]; ++i) {
+            const DepositEntry& e = m_depositSorted[i];
+            m_field[e.cell] += 1.0f;
+            m_tileTouched[e.tile] = 1;
+        }
+    });
 }
 
 
-inline void SlimeMoldSimulation::Private::deposit(const Agent& a) {
+// Cell under agent, same as deposit
+inline size_t SlimeMoldSimulation::Private::cellIndex(const Agent& a) const
+{
     const int xi = ((int)(a.x + 0.5f) +  m_width) % m_width;
     const int yi = ((int)(a.y + 0.5f) + m_height) % m_height;
-    const int idx = yi * m_width + xi;
-    m_field[idx] += 1.0f;
+    return yi * m_width + xi;
+}
+
+
+inline size_t SlimeMoldSimulation::Private::cellIndex(const CompactAgent& a) const
+{
+    return compactCell(a.y, static_cast<uint32_t>(m_height)) * m_width + compactCell(a.x, static_cast<uint32_t>(m_width));
 }
 
 
 
-void SlimeMoldSimulation::Private::updateAgents(const AgentPreset &p) {
-    const float SENSOR_LEFT_COS  = std::cos(-p.sensor_angle);
-    const float SENSOR_LEFT_SIN  = std::sin(-p.sensor_angle);
-    const float SENSOR_RIGHT_COS = std::cos(p.sensor_angle);
-    const float SENSOR_RIGHT_SIN = std::sin(p.sensor_angle);
-
-    const float TURN_LEFT_COS  = std::cos(-p.turn_angle);
-    const float TURN_LEFT_SIN  = std::sin(-p.turn_angle);
-    const float TURN_RIGHT_COS = std::cos(p.turn_angle);
-    const float TURN_RIGHT_SIN = std::sin(p.turn_angle);
-
-    const float sensor_dist = p.sensor_dist;
-    const float step_size = p.step_size;
-
-    for (auto& a : m_agents) {
-        // Sensor positions
-        const float cx = a.x + a.dx * sensor_dist;
-        const float cy = a.y + a.dy * sensor_dist;
-
-        const float ldx = a.dx * SENSOR_LEFT_COS - a.dy * SENSOR_LEFT_SIN;
-        const float ldy = a.dx * SENSOR_LEFT_SIN + a.dy * SENSOR_LEFT_COS;
-        const float lx = a.x + ldx * sensor_dist;
-        const float ly = a.y + ldy * sensor_dist;
-
-        const float rdx = a.dx * SENSOR_RIGHT_COS - a.dy * SENSOR_RIGHT_SIN;
-        const float rdy = a.dx * SENSOR_RIGHT_SIN + a.dy * SENSOR_RIGHT_COS;
-        const float rx = a.x + rdx * sensor_dist;
-        const float ry = a.y + rdy * sensor_dist;
-
-        // Sample sensors
-#if not defined USE_AVX2
-        const float c = sampleField(cx, cy);
-        const float l = sampleField(lx, ly);
-        const float r = sampleField(rx, ry);
-#else
-        float c, l, r;
-        {
+template <typename Policy>
+inline void SlimeMoldSimulation::Private::updateAgent(Agent& a, const StepParams& k) const
+{
+    const float SENSOR_LEFT_COS  = k.sensorLeftCos;
+    const float SENSOR_LEFT_SIN  = k.sensorLeftSin;
+    const float SENSOR_RIGHT_COS = k.sensorRightCos;
+    const float SENSOR_RIGHT_SIN = k.sensorRightSin;
+
+    const float TURN_LEFT_COS  = k.turnLeftCos;
+    const float TURN_LEFT_SIN  = k.turnLeftSin;
+    const float TURN_RIGHT_COS = k.turnRightCos;
+    const float TURN_RIGHT_SIN = k.turnRightSin;
+
+    const float sensor_dist = k.sensorDist;
+    const float step_size = k.stepSize;
+
+    // Sensor positions, in cells of field sensors read
+    const float sx = a.x * k.sensorScale - k.sensorOffset;
+    const float sy = a.y * k.sensorScale - k.sensorOffset;
+    const float cx = sx + a.dx * sensor_dist;
+    const float cy = sy + a.dy * sensor_dist;
+
+    const float ldx = a.dx * SENSOR_LEFT_COS - a.dy * SENSOR_LEFT_SIN;
+    const float ldy = a.dx * SENSOR_LEFT_SIN + a.dy * SENSOR_LEFT_COS;
+    const float lx = sx + ldx * sensor_dist;
+    const float ly = sy + ldy * sensor_dist;
+
+    const float rdx = a.dx * SENSOR_RIGHT_COS - a.dy * SENSOR_RIGHT_SIN;
+    const float rdy = a.dx * SENSOR_RIGHT_SIN + a.dy * SENSOR_RIGHT_COS;
+    const float rx = sx + rdx * sensor_dist;
+    const float ry = sy + rdy * sensor_dist;
+
+    // Sample sensors
+    float c, l, r;
+    if (k.bilinear) {
+        c = sampleFieldBilinear<Policy>(k.field, cx, cy);
+        l = sampleFieldBilinear<Policy>(k.field, lx, ly);
+        r = sampleFieldBilinear<Policy>(k.field, rx, ry);
+    }
+    else {
+#if defined(USE_AVX2)
+        if (k.simd) {
             // This is actually SSE2 or SSE3
             // === Step 1: Pack x and y into __m128 ===
             __m128 x_vec = _mm_set_ps(0.0f, rx, lx, cx);  // [3]=0, [2]=rx, [1]=lx, [0]=cx (for some reason backwards)
             __m128 y_vec = _mm_set_ps(0.0f, ry, ly, cy);  // [3]=0, [2]=ry, [1]=ly, [0]=cy
 
-            // === Step 2: Round: x = (int)(x + 0.5f) ===
+            // === Step 2: Round: x = (int)(x + 0.5f), conversion must truncate as the cast ===
             __m128 bias = _mm_set1_ps(0.5f);
             x_vec = _mm_add_ps(x_vec, bias);
             y_vec = _mm_add_ps(y_vec, bias);
-            __m128i xi_vec = _mm_cvtps_epi32(x_vec);  // [cx, lx, rx, 0]
-            __m128i yi_vec = _mm_cvtps_epi32(y_vec);
-
-            // === Step 3: Wrap in [0, w) and [0, h) ===
-            __m128i w_vec = _mm_set1_epi32(m_width);
-            __m128i h_vec = _mm_set1_epi32(m_height);
-            // --- Wrap x: if < 0 → add w; if >= w → sub w ---
-            __m128i zero = _mm_setzero_si128();
-            __m128i mask_x_neg = _mm_cmpgt_epi32(zero, xi_vec);  // xi < 0
-            __m128i add_w = _mm_and_si128(mask_x_neg, w_vec);
-            xi_vec = _mm_add_epi32(xi_vec, add_w);
-
-            __m128i mask_x_ovf = _mm_cmpgt_epi32(xi_vec, _mm_sub_epi32(w_vec, _mm_set1_epi32(1)));  // xi >= w
-            __m128i sub_w = _mm_and_si128(mask_x_ovf, w_vec);
-            xi_vec = _mm_sub_epi32(xi_vec, sub_w);
-
-            // --- Wrap y ---
-            __m128i mask_y_neg = _mm_cmpgt_epi32(zero, yi_vec);  // yi < 0
-            __m128i add_h = _mm_and_si128(mask_y_neg, h_vec);
-            yi_vec = _mm_add_epi32(yi_vec, add_h);
-
-            __m128i mask_y_ovf = _mm_cmpgt_epi32(yi_vec, _mm_sub_epi32(h_vec, _mm_set1_epi32(1)));  // yi >= h
-            __m128i sub_h = _mm_and_si128(mask_y_ovf, h_vec);
-            yi_vec = _mm_sub_epi32(yi_vec, sub_h);
+            __m128i xi_vec = _mm_cvttps_epi32(x_vec);  // [cx, lx, rx, 0]
+            __m128i yi_vec = _mm_cvttps_epi32(y_vec);
+
+            // === Step 3: Bring into [0, w) and [0, h) by boundary policy ===
+            __m128i w_vec = _mm_set1_epi32(k.field.width);
+            __m128i h_vec = _mm_set1_epi32(k.field.height);
+            xi_vec = Policy::cell(xi_vec, w_vec);
+            yi_vec = Policy::cell(yi_vec, h_vec);
 
             // === Step 4: Compute idx = y * w + x ===
             __m128i idx_vec = _mm_add_epi32(_mm_mullo_epi32(yi_vec, w_vec), xi_vec);
 
-            // === Step 5: Gather m_field[idx] for 3 values ===
+            // === Step 5: Gather field[idx] for 3 values ===
             // SSE doesn't have gather, so we extract and do scalar loads
             alignas(16) int idxs[4];
             _mm_store_si128((__m128i*)idxs, idx_vec);
 
-            c = m_field[idxs[0]];
-            l = m_field[idxs[1]];
-            r = m_field[idxs[2]];
+            c = k.field.data[idxs[0]];
+            l = k.field.data[idxs[1]];
+            r = k.field.data[idxs[2]];
         }
+        else
 #endif
+        {
+            c = sampleField<Policy>(k.field, cx, cy);
+            l = sampleField<Policy>(k.field, lx, ly);
+            r = sampleField<Policy>(k.field, rx, ry);
+        }
+    }
 
 #if 0
-        // Adjust angle
-        if (c > l && c > r) {
-            // keep direction
-        }
-        else if (l > r) {
+    // Adjust angle
+    if (c > l && c > r) {
+        // keep direction
+    }
+    else if (l > r) {
+        rotate(a.dx, a.dy, TURN_LEFT_COS, TURN_LEFT_SIN);
+    }
+    else if (r > l) {
+        rotate(a.dx, a.dy, TURN_RIGHT_COS, TURN_RIGHT_SIN);
+    }
+    else {
+        if (rand() % 2) {
             rotate(a.dx, a.dy, TURN_LEFT_COS, TURN_LEFT_SIN);
         }
-        else if (r > l) {
-            rotate(a.dx, a.dy, TURN_RIGHT_COS, TURN_RIGHT_SIN);
-        }
         else {
-            if (rand() % 2) {
-                rotate(a.dx, a.dy, TURN_LEFT_COS, TURN_LEFT_SIN);
-            }
-            else {
-                rotate(a.dx, a.dy, TURN_RIGHT_COS, TURN_RIGHT_SIN);
-            }
+            rotate(a.dx, a.dy, TURN_RIGHT_COS, TURN_RIGHT_SIN);
         }
+    }
 #else
-        // Branchless turn decision
-        int c_wins = ((c > l) & (c > r)) | (l == r);
-        int l_gt_r = (l > r);
-        //int r_gt_l = (r > l);
+    // Branchless turn decision
+    int c_wins = ((c > l) & (c > r)) | (l == r);
+    int l_gt_r = (l > r);
+    //int r_gt_l = (r > l);
+
+    int go_left  = !c_wins & l_gt_r;
+    int go_right = !c_wins & !l_gt_r;
+
+    float cos_val = c_wins ? 1.0f : TURN_RIGHT_COS;
+    float sin_val = (go_left - go_right) * TURN_LEFT_SIN;
 
-        int go_left  = !c_wins & l_gt_r;
-        int go_right = !c_wins & !l_gt_r;
+    rotate(a.dx, a.dy, cos_val, sin_val);
+#endif
+    // Move
+    a.x += a.dx * step_size;
+    a.y += a.dy * step_size;
+
+    Policy::confine(a, static_cast<float>(m_width), static_cast<float>(m_height));
+}
+
+
+#if defined(USE_AVX2)
+// Same as updateAgent with bilinear sampling for 8 consecutive agents, results are bit-identical.
+// Agents are transposed to SoA, each sensor is 4 gathers and 3 lerps for all 8 agents.
+template <typename Policy>
+inline void SlimeMoldSimulation::Private::updateAgentsBilinearAvx2(Agent* agents, const StepParams& k) const
+{
+    // === Step 1: Load 8 agents and transpose AoS to SoA ===
+    const float* src = reinterpret_cast<const float*>(agents);
+    const __m256 a04 = _mm256_loadu2_m128(src + 16, src + 0);     // [agent0 | agent4]
+    const __m256 a15 = _mm256_loadu2_m128(src + 20, src + 4);
+    const __m256 a26 = _mm256_loadu2_m128(src + 24, src + 8);
+    const __m256 a37 = _mm256_loadu2_m128(src + 28, src + 12);
+    const __m256 t0 = _mm256_unpacklo_ps(a04, a15);    // [x0, x1, y0, y1 | x4, x5, y4, y5]
+    const __m256 t1 = _mm256_unpackhi_ps(a04, a15);    // [dx0, dx1, dy0, dy1 | ...]
+    const __m256 t2 = _mm256_unpacklo_ps(a26, a37);    // [x2, x3, y2, y3 | x6, x7, y6, y7]
+    const __m256 t3 = _mm256_unpackhi_ps(a26, a37);
+    __m256 x  = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 y  = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 dx = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 dy = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+    // === Step 2: Sensor positions, in cells of field sensors read ===
+    const __m256 dist = _mm256_set1_ps(k.sensorDist);
+    const __m256 scale = _mm256_set1_ps(k.sensorScale);
+    const __m256 offset = _mm256_set1_ps(k.sensorOffset);
+    const __m256 px = _mm256_sub_ps(_mm256_mul_ps(x, scale), offset);
+    const __m256 py = _mm256_sub_ps(_mm256_mul_ps(y, scale), offset);
+    auto sensor = [&](float cos_a, float sin_a, __m256& sx, __m256& sy) {
+        const __m256 c = _mm256_set1_ps(cos_a);
+        const __m256 s = _mm256_set1_ps(sin_a);
+        const __m256 sdx = _mm256_sub_ps(_mm256_mul_ps(dx, c), _mm256_mul_ps(dy, s));
+        const __m256 sdy = _mm256_add_ps(_mm256_mul_ps(dx, s), _mm256_mul_ps(dy, c));
+        sx = _mm256_add_ps(px, _mm256_mul_ps(sdx, dist));
+        sy = _mm256_add_ps(py, _mm256_mul_ps(sdy, dist));
+    };
+    const __m256 cx = _mm256_add_ps(px, _mm256_mul_ps(dx, dist));
+    const __m256 cy = _mm256_add_ps(py, _mm256_mul_ps(dy, dist));
+    __m256 lx, ly, rx, ry;
+    sensor(k.sensorLeftCos, k.sensorLeftSin, lx, ly);
+    sensor(k.sensorRightCos, k.sensorRightSin, rx, ry);
+
+    // === Step 3: Gather 4 neighbours and lerp ===
+    const __m256i w_vec = _mm256_set1_epi32(k.field.width);
+    const __m256i h_vec = _mm256_set1_epi32(k.field.height);
+    const float* field = k.field.data;
+    auto sample = [&](__m256 sx, __m256 sy) {
+        const __m256 fx = _mm256_floor_ps(sx);
+        const __m256 fy = _mm256_floor_ps(sy);
+        const __m256 tx = _mm256_sub_ps(sx, fx);
+        const __m256 ty = _mm256_sub_ps(sy, fy);
+        __m256i x0, x1, y0, y1;
+        Policy::cellPair(_mm256_cvttps_epi32(fx), w_vec, x0, x1);
+        Policy::cellPair(_mm256_cvttps_epi32(fy), h_vec, y0, y1);
+        const __m256i row0 = _mm256_mullo_epi32(y0, w_vec);
+        const __m256i row1 = _mm256_mullo_epi32(y1, w_vec);
+        const __m256 f00 = _mm256_i32gather_ps(field, _mm256_add_epi32(row0, x0), 4);
+        const __m256 f10 = _mm256_i32gather_ps(field, _mm256_add_epi32(row0, x1), 4);
+        const __m256 f01 = _mm256_i32gather_ps(field, _mm256_add_epi32(row1, x0), 4);
+        const __m256 f11 = _mm256_i32gather_ps(field, _mm256_add_epi32(row1, x1), 4);
+        const __m256 top    = _mm256_add_ps(f00, _mm256_mul_ps(tx, _mm256_sub_ps(f10, f00)));
+        const __m256 bottom = _mm256_add_ps(f01, _mm256_mul_ps(tx, _mm256_sub_ps(f11, f01)));
+        return _mm256_add_ps(top, _mm256_mul_ps(ty, _mm256_sub_ps(bottom, top)));
+    };
+    const __m256 c = sample(cx, cy);
+    const __m256 l = sample(lx, ly);
+    const __m256 r = sample(rx, ry);
+
+    // === Step 4: Branchless turn decision using masks ===
+    const __m256 c_wins = _mm256_or_ps(
+        _mm256_and_ps(_mm256_cmp_ps(c, l, _CMP_GT_OQ), _mm256_cmp_ps(c, r, _CMP_GT_OQ)),
+        _mm256_cmp_ps(l, r, _CMP_EQ_OQ));
+    const __m256 l_gt_r = _mm256_cmp_ps(l, r, _CMP_GT_OQ);
+    const __m256 cos_val = _mm256_blendv_ps(_mm256_set1_ps(k.turnRightCos), _mm256_set1_ps(1.0f), c_wins);
+    const __m256 sin_val = _mm256_andnot_ps(c_wins,
+        _mm256_blendv_ps(_mm256_set1_ps(-k.turnLeftSin), _mm256_set1_ps(k.turnLeftSin), l_gt_r));
+    const __m256 ndx = _mm256_sub_ps(_mm256_mul_ps(dx, cos_val), _mm256_mul_ps(dy, sin_val));
+    const __m256 ndy = _mm256_add_ps(_mm256_mul_ps(dx, sin_val), _mm256_mul_ps(dy, cos_val));
+    dx = ndx;
+    dy = ndy;
+
+    // === Step 5: Move and confine to field ===
+    const __m256 step = _mm256_set1_ps(k.stepSize);
+    x = _mm256_add_ps(x, _mm256_mul_ps(dx, step));
+    y = _mm256_add_ps(y, _mm256_mul_ps(dy, step));
+    Policy::confine(x, y, dx, dy, _mm256_set1_ps(static_cast<float>(m_width)), _mm256_set1_ps(static_cast<float>(m_height)));
+
+    // === Step 6: Transpose back and store ===
+    const __m256 u0 = _mm256_unpacklo_ps(x, y);        // [x0, y0, x1, y1 | x4, y4, x5, y5]
+    const __m256 u1 = _mm256_unpackhi_ps(x, y);        // [x2, y2, x3, y3 | x6, y6, x7, y7]
+    const __m256 u2 = _mm256_unpacklo_ps(dx, dy);
+    const __m256 u3 = _mm256_unpackhi_ps(dx, dy);
+    float* dst = reinterpret_cast<float*>(agents);
+    _mm256_storeu2_m128(dst + 16, dst + 0,  _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(1, 0, 1, 0)));
+    _mm256_storeu2_m128(dst + 20, dst + 4,  _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(3, 2, 3, 2)));
+    _mm256_storeu2_m128(dst + 24, dst + 8,  _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(1, 0, 1, 0)));
+    _mm256_storeu2_m128(dst + 28, dst + 12, _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(3, 2, 3, 2)));
+}
+#endif
+
+
+#if defined(USE_WASM_SIMD)
+// Same as updateAgent for 4 consecutive agents, results are bit-identical
+template <typename Policy>
+inline void SlimeMoldSimulation::Private::updateAgentsWasm(Agent* agents, const StepParams& k) const
+{
+    // === Step 1: Load 4 agents and transpose AoS to SoA ===
+    const v128_t a0 = wasm_v128_load(&agents[0]);   // [x0, y0, dx0, dy0]
+    const v128_t a1 = wasm_v128_load(&agents[1]);
+    const v128_t a2 = wasm_v128_load(&agents[2]);
+    const v128_t a3 = wasm_v128_load(&agents[3]);
+    const v128_t t0 = wasm_i32x4_shuffle(a0, a1, 0, 4, 1, 5);  // [x0, x1, y0, y1]
+    const v128_t t1 = wasm_i32x4_shuffle(a2, a3, 0, 4, 1, 5);  // [x2, x3, y2, y3]
+    const v128_t t2 = wasm_i32x4_shuffle(a0, a1, 2, 6, 3, 7);  // [dx0, dx1, dy0, dy1]
+    const v128_t t3 = wasm_i32x4_shuffle(a2, a3, 2, 6, 3, 7);  // [dx2, dx3, dy2, dy3]
+    v128_t x  = wasm_i32x4_shuffle(t0, t1, 0, 1, 4, 5);
+    v128_t y  = wasm_i32x4_shuffle(t0, t1, 2, 3, 6, 7);
+    v128_t dx = wasm_i32x4_shuffle(t2, t3, 0, 1, 4, 5);
+    v128_t dy = wasm_i32x4_shuffle(t2, t3, 2, 3, 6, 7);
+
+    // === Step 2: Sensor positions, in cells of field sensors read ===
+    const v128_t dist = wasm_f32x4_splat(k.sensorDist);
+    const v128_t scale = wasm_f32x4_splat(k.sensorScale);
+    const v128_t offset = wasm_f32x4_splat(k.sensorOffset);
+    const v128_t px = wasm_f32x4_sub(wasm_f32x4_mul(x, scale), offset);
+    const v128_t py = wasm_f32x4_sub(wasm_f32x4_mul(y, scale), offset);
+    auto sensor = [&](float cos_a, float sin_a, v128_t& sx, v128_t& sy) {
+        const v128_t c = wasm_f32x4_splat(cos_a);
+        const v128_t s = wasm_f32x4_splat(sin_a);
+        const v128_t sdx = wasm_f32x4_sub(wasm_f32x4_mul(dx, c), wasm_f32x4_mul(dy, s));
+        const v128_t sdy = wasm_f32x4_add(wasm_f32x4_mul(dx, s), wasm_f32x4_mul(dy, c));
+        sx = wasm_f32x4_add(px, wasm_f32x4_mul(sdx, dist));
+        sy = wasm_f32x4_add(py, wasm_f32x4_mul(sdy, dist));
+    };
+    const v128_t cx = wasm_f32x4_add(px, wasm_f32x4_mul(dx, dist));
+    const v128_t cy = wasm_f32x4_add(py, wasm_f32x4_mul(dy, dist));
+    v128_t lx, ly, rx, ry;
+    sensor(k.sensorLeftCos, k.sensorLeftSin, lx, ly);
+    sensor(k.sensorRightCos, k.sensorRightSin, rx, ry);
+
+    // === Step 3: Round, bring into field and compute idx = y * w + x ===
+    const v128_t w_vec = wasm_i32x4_splat(k.field.width);
+    const v128_t h_vec = wasm_i32x4_splat(k.field.height);
+    const v128_t bias = wasm_f32x4_splat(0.5f);
+    auto fieldIndex = [&](v128_t sx, v128_t sy) {
+        const v128_t xi = Policy::cell(wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_add(sx, bias)), w_vec);
+        const v128_t yi = Policy::cell(wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_add(sy, bias)), h_vec);
+        return wasm_i32x4_add(wasm_i32x4_mul(yi, w_vec), xi);
+    };
+
+    // === Step 4: Gather, there is no gather instruction ===
+    alignas(16) int32_t idxs[12];
+    wasm_v128_store(&idxs[0], fieldIndex(cx, cy));
+    wasm_v128_store(&idxs[4], fieldIndex(lx, ly));
+    wasm_v128_store(&idxs[8], fieldIndex(rx, ry));
+    const float* field = k.field.data;
+    const v128_t c = wasm_f32x4_make(field[idxs[0]], field[idxs[1]], field[idxs[2]],  field[idxs[3]]);
+    const v128_t l = wasm_f32x4_make(field[idxs[4]], field[idxs[5]], field[idxs[6]],  field[idxs[7]]);
+    const v128_t r = wasm_f32x4_make(field[idxs[8]], field[idxs[9]], field[idxs[10]], field[idxs[11]]);
+
+    // === Step 5: Branchless turn decision using masks ===
+    const v128_t c_wins = wasm_v128_or(
+        wasm_v128_and(wasm_f32x4_gt(c, l), wasm_f32x4_gt(c, r)),
+        wasm_f32x4_eq(l, r));
+    const v128_t l_gt_r = wasm_f32x4_gt(l, r);
+    const v128_t cos_val = wasm_v128_bitselect(wasm_f32x4_splat(1.0f), wasm_f32x4_splat(k.turnRightCos), c_wins);
+    const v128_t sin_val = wasm_v128_andnot(
+        wasm_v128_bitselect(wasm_f32x4_splat(k.turnLeftSin), wasm_f32x4_splat(-k.turnLeftSin), l_gt_r),
+        c_wins);
+    const v128_t ndx = wasm_f32x4_sub(wasm_f32x4_mul(dx, cos_val), wasm_f32x4_mul(dy, sin_val));
+    const v128_t ndy = wasm_f32x4_add(wasm_f32x4_mul(dx, sin_val), wasm_f32x4_mul(dy, cos_val));
+    dx = ndx;
+    dy = ndy;
+
+    // === Step 6: Move and confine to field ===
+    const v128_t step = wasm_f32x4_splat(k.stepSize);
+    x = wasm_f32x4_add(x, wasm_f32x4_mul(dx, step));
+    y = wasm_f32x4_add(y, wasm_f32x4_mul(dy, step));
+    Policy::confine(x, y, dx, dy, wasm_f32x4_splat(static_cast<float>(m_width)), wasm_f32x4_splat(static_cast<float>(m_height)));
+
+    // === Step 7: Transpose back and store ===
+    const v128_t u0 = wasm_i32x4_shuffle(x, y, 0, 4, 1, 5);    // [x0, y0, x1, y1]
+    const v128_t u1 = wasm_i32x4_shuffle(dx, dy, 0, 4, 1, 5);  // [dx0, dy0, dx1, dy1]
+    const v128_t u2 = wasm_i32x4_shuffle(x, y, 2, 6, 3, 7);    // [x2, y2, x3, y3]
+    const v128_t u3 = wasm_i32x4_shuffle(dx, dy, 2, 6, 3, 7);  // [dx2, dy2, dx3, dy3]
+    wasm_v128_store(&agents[0], wasm_i32x4_shuffle(u0, u1, 0, 1, 4, 5));
+    wasm_v128_store(&agents[1], wasm_i32x4_shuffle(u0, u1, 2, 3, 6, 7));
+    wasm_v128_store(&agents[2], wasm_i32x4_shuffle(u2, u3, 0, 1, 4, 5));
+    wasm_v128_store(&agents[3], wasm_i32x4_shuffle(u2, u3, 2, 3, 6, 7));
+}
+#endif
+
+
+// Cell centers are at integer coordinates as in sampleField and sampleFieldBilinear.
+// Bilinear weights come from 16.16 fixed point position in cells.
+template <typename Policy>
+inline float SlimeMoldSimulation::Private::sampleCompact(const SensorField& f, uint32_t x, uint32_t y, bool bilinear) const
+{
+    const uint32_t w = static_cast<uint32_t>(f.width);
+    const uint32_t h = static_cast<uint32_t>(f.height);
+    if (!bilinear)
+        return f.data[compactCell(y, h) * w + compactCell(x, w)];
+
+    const uint32_t px = (x >> 16) * w;
+    const uint32_t py = (y >> 16) * h;
+    const uint32_t x0 = px >> 16;
+    const uint32_t y0 = py >> 16;
+    const uint32_t x1 = Policy::compactNext(x0, w);
+    const uint32_t y1 = Policy::compactNext(y0, h);
+    const float tx = (px & 0xffff) * 0x1p-16f;
+    const float ty = (py & 0xffff) * 0x1p-16f;
+
+    const float* row0 = &f.data[y0 * w];
+    const float* row1 = &f.data[y1 * w];
+    const float top    = row0[x0] + tx * (row0[x1] - row0[x0]);
+    const float bottom = row1[x0] + tx * (row1[x1] - row1[x0]);
+    return top + ty * (bottom - top);
+}
 
-        float cos_val = c_wins ? 1.0f : TURN_RIGHT_COS;
-        float sin_val = (go_left - go_right) * TURN_LEFT_SIN;
 
-        rotate(a.dx, a.dy, cos_val, sin_val);
+// Same decision as updateAgent, but turns are steps of heading index and
+// sensors and moves are table lookups instead of rotations
+template <typename Policy>
+inline void SlimeMoldSimulation::Private::updateCompactAgent(CompactAgent& a, const SensorField& f, bool bilinear) const
+{
+    const CompactTables& t = m_compactTables;
+    const uint32_t heading = a.y & HEADING_MASK;
+    const uint32_t left  = (heading - t.sensorAngle) & HEADING_MASK;
+    const uint32_t right = (heading + t.sensorAngle) & HEADING_MASK;
+    auto sample = [&](uint32_t dir) {
+        return sampleCompact<Policy>(f,
+            Policy::compactStep(a.x, t.sensorX[dir], t.sensorLimitX),
+            Policy::compactStep(a.y, t.sensorY[dir], t.sensorLimitY), bilinear);
+    };
+    const float c = sample(heading);
+    const float l = sample(left);
+    const float r = sample(right);
+
+    const int c_wins = ((c > l) & (c > r)) | (l == r);
+    const uint32_t turned = (l > r) ? heading - t.turnAngle : heading + t.turnAngle;
+    const uint32_t next = c_wins ? heading : turned & HEADING_MASK;
+
+    Policy::confineCompact(a, t.moveX[next], t.moveY[next], next, t.limitX, t.limitY);
+}
+
+
+#if defined(USE_AVX2)
+// Same as updateCompactAgent for 8 consecutive agents, results are bit-identical
+template <typename Policy>
+inline void SlimeMoldSimulation::Private::updateCompactAgentsAvx2(CompactAgent* agents, const SensorField& f, bool bilinear) const
+{
+    const CompactTables& t = m_compactTables;
+    const int* sensorX = reinterpret_cast<const int*>(t.sensorX.data());
+    const int* sensorY = reinterpret_cast<const int*>(t.sensorY.data());
+    const int* moveX = reinterpret_cast<const int*>(t.moveX.data());
+    const int* moveY = reinterpret_cast<const int*>(t.moveY.data());
+
+    // === Step 1: Load 8 agents and split x and y ===
+    // Lanes are agents 0, 1, 4, 5 | 2, 3, 6, 7, interleaving in step 6 restores order
+    const __m256 v0 = _mm256_loadu_ps(reinterpret_cast<const float*>(agents));
+    const __m256 v1 = _mm256_loadu_ps(reinterpret_cast<const float*>(agents + 4));
+    __m256i x = _mm256_castps_si256(_mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m256i y = _mm256_castps_si256(_mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+    // === Step 2: Sensor headings ===
+    const __m256i mask = _mm256_set1_epi32(HEADING_MASK);
+    const __m256i sensorAngle = _mm256_set1_epi32(static_cast<int>(t.sensorAngle));
+    const __m256i heading = _mm256_and_si256(y, mask);
+    const __m256i left  = _mm256_and_si256(_mm256_sub_epi32(heading, sensorAngle), mask);
+    const __m256i right = _mm256_and_si256(_mm256_add_epi32(heading, sensorAngle), mask);
+
+    // === Step 3: Sensor positions from tables, sample field ===
+    const __m256i w_vec = _mm256_set1_epi32(f.width);
+    const __m256i h_vec = _mm256_set1_epi32(f.height);
+    const __m256i sensorLimitX = _mm256_set1_epi32(static_cast<int>(t.sensorLimitX));
+    const __m256i sensorLimitY = _mm256_set1_epi32(static_cast<int>(t.sensorLimitY));
+    const __m256i half = _mm256_set1_epi32(0x8000);
+    const __m256i low = _mm256_set1_epi32(0xffff);
+    const float* field = f.data;
+    auto cell = [&](__m256i v, __m256i n) {
+        const __m256i i = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(v, 16), n), half), 16);
+        return _mm256_andnot_si256(_mm256_cmpeq_epi32(i, n), i);        // n → 0
+    };
+    auto sample = [&](__m256i dir) {
+        const __m256i sx = Policy::compactStep(x, _mm256_i32gather_epi32(sensorX, dir, 4), sensorLimitX);
+        const __m256i sy = Policy::compactStep(y, _mm256_i32gather_epi32(sensorY, dir, 4), sensorLimitY);
+        if (!bilinear) {
+            const __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(cell(sy, h_vec), w_vec), cell(sx, w_vec));
+            return _mm256_i32gather_ps(field, idx, 4);
+        }
+        const __m256i px = _mm256_mullo_epi32(_mm256_srli_epi32(sx, 16), w_vec);
+        const __m256i py = _mm256_mullo_epi32(_mm256_srli_epi32(sy, 16), h_vec);
+        const __m256i x0 = _mm256_srli_epi32(px, 16);
+        const __m256i y0 = _mm256_srli_epi32(py, 16);
+        const __m256i x1 = Policy::compactNext(x0, w_vec);
+        const __m256i y1 = Policy::compactNext(y0, h_vec);
+        const __m256 tx = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(px, low)), _mm256_set1_ps(0x1p-16f));
+        const __m256 ty = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(py, low)), _mm256_set1_ps(0x1p-16f));
+        const __m256i row0 = _mm256_mullo_epi32(y0, w_vec);
+        const __m256i row1 = _mm256_mullo_epi32(y1, w_vec);
+        const __m256 f00 = _mm256_i32gather_ps(field, _mm256_add_epi32(row0, x0), 4);
+        const __m256 f10 = _mm256_i32gather_ps(field, _mm256_add_epi32(row0, x1), 4);
+        const __m256 f01 = _mm256_i32gather_ps(field, _mm256_add_epi32(row1, x0), 4);
+        const __m256 f11 = _mm256_i32gather_ps(field, _mm256_add_epi32(row1, x1), 4);
+        const __m256 top    = _mm256_add_ps(f00, _mm256_mul_ps(tx, _mm256_sub_ps(f10, f00)));
+        const __m256 bottom = _mm256_add_ps(f01, _mm256_mul_ps(tx, _mm256_sub_ps(f11, f01)));
+        return _mm256_add_ps(top, _mm256_mul_ps(ty, _mm256_sub_ps(bottom, top)));
+    };
+    const __m256 c = sample(heading);
+    const __m256 l = sample(left);
+    const __m256 r = sample(right);
+
+    // === Step 4: Branchless turn decision using masks ===
+    const __m256i c_wins = _mm256_castps_si256(_mm256_or_ps(
+        _mm256_and_ps(_mm256_cmp_ps(c, l, _CMP_GT_OQ), _mm256_cmp_ps(c, r, _CMP_GT_OQ)),
+        _mm256_cmp_ps(l, r, _CMP_EQ_OQ)));
+    const __m256i l_gt_r = _mm256_castps_si256(_mm256_cmp_ps(l, r, _CMP_GT_OQ));
+    const __m256i turn = _mm256_set1_epi32(static_cast<int>(t.turnAngle));
+    const __m256i turned = _mm256_blendv_epi8(_mm256_add_epi32(heading, turn), _mm256_sub_epi32(heading, turn), l_gt_r);
+    const __m256i nextHeading = _mm256_and_si256(_mm256_blendv_epi8(turned, heading, c_wins), mask);
+
+    // === Step 5: Move and confine to field ===
+    Policy::confineCompact(x, y, _mm256_i32gather_epi32(moveX, nextHeading, 4), _mm256_i32gather_epi32(moveY, nextHeading, 4),
+        nextHeading, _mm256_set1_epi32(static_cast<int>(t.limitX)), _mm256_set1_epi32(static_cast<int>(t.limitY)));
+
+    // === Step 6: Interleave and store ===
+    const __m256 xf = _mm256_castsi256_ps(x);
+    const __m256 yf = _mm256_castsi256_ps(y);
+    _mm256_storeu_ps(reinterpret_cast<float*>(agents), _mm256_unpacklo_ps(xf, yf));
+    _mm256_storeu_ps(reinterpret_cast<float*>(agents + 4), _mm256_unpackhi_ps(xf, yf));
+}
 #endif
-        // Move
-        a.x += a.dx * step_size;
-        a.y += a.dy * step_size;
 
-        // Wrap around
-        if (a.x < 0)         a.x += m_width;
-        if (a.x >= m_width)  a.x -= m_width;
-        if (a.y < 0)         a.y += m_height;
-        if (a.y >= m_height) a.y -= m_height;
 
+void SlimeMoldSimulation::Private::updateCompactAgents(const AgentPreset& p, const SensorField& field)
+{
+    buildCompactTables(m_compactTables, p, m_width, m_height, m_pyramidLevel);
+    const bool bilinear = m_sampling == SAMPLING_BILINEAR;
+    withBoundary(m_boundary, [&]<typename Policy>(Policy) { moveCompactAgents<Policy>(field, bilinear); });
+
+    enterPhase(PHASE_DEPOSIT);
+    if (binnedDeposit())
+        depositBinned(m_compact);
+    else {
+        for (size_t i = 0; i < m_activeAgents; ++i)
+            deposit(m_compact[i]);
     }
-#if not defined USE_AVX2
-    for (const auto& a : m_agents) {
-        deposit(a);
+}
+
+
+template <typename Policy>
+void SlimeMoldSimulation::Private::moveCompactAgents(const SensorField& field, bool bilinear)
+{
+#if defined(USE_AVX2)
+    const bool simd = m_kernels == KERNELS_SIMD;
+#endif
+    // NOTE: no SIMD128 kernel for compact agents, web build runs scalar code
+    ThreadPool::global().parallelFor(m_activeAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t i = begin;
+#if defined(USE_AVX2)
+        if (simd) {
+            for (; i + 8 <= end; i += 8)
+                updateCompactAgentsAvx2<Policy>(&m_compact[i], field, bilinear);
+        }
+#endif
+        for (; i < end; ++i)
+            updateCompactAgent<Policy>(m_compact[i], field, bilinear);
+        if (m_inputs.hasObstacles()) {
+            for (size_t j = begin; j < end; ++j)
+                avoidObstacle<Policy>(m_compact[j]);
+        }
+    });
+}
+
+
+// Agents only read the field here, so they can move in parallel
+template <typename Policy>
+void SlimeMoldSimulation::Private::moveAgents(const StepParams& k)
+{
+    ThreadPool::global().parallelFor(m_activeAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t i = begin;
+#if defined(USE_AVX2)
+        if (k.simd && k.bilinear) {
+            for (; i + 8 <= end; i += 8)
+                updateAgentsBilinearAvx2<Policy>(&m_agents[i], k);
+        }
+#elif defined(USE_WASM_SIMD)
+        // NOTE: bilinear sampling has no SIMD128 kernel yet, it runs scalar code
+        if (k.simd && !k.bilinear) {
+            for (; i + 4 <= end; i += 4)
+                updateAgentsWasm<Policy>(&m_agents[i], k);
+        }
+#endif
+        for (; i < end; ++i)
+            updateAgent<Policy>(m_agents[i], k);
+        if (m_inputs.hasObstacles()) {
+            for (size_t j = begin; j < end; ++j)
+                avoidObstacle<Policy>(m_agents[j], k.stepSize);
+        }
+    });
+}
+
+
+void SlimeMoldSimulation::Private::updateAgents(const AgentPreset &p) {
+    m_pyramidLevel = sensorLevel(p.sensor_dist);
+    if (m_pyramidLevel > m_pyramidValid)
+        buildPyramid(m_pyramidLevel);
+    const SensorField field = sensorField(m_pyramidLevel);
+    if (m_agentFormat == AGENTS_COMPACT) {
+        updateCompactAgents(p, field);
+        ++m_passes;
+        return;
     }
-#else
-    const size_t nAgents = m_agents.size();
+    const StepParams k = makeStepParams(p, m_sampling == SAMPLING_BILINEAR, m_kernels == KERNELS_SIMD, field, m_pyramidLevel);
+
+    withBoundary(m_boundary, [&]<typename Policy>(Policy) { moveAgents<Policy>(k); });
+
+    // Positions are within field for every boundary policy, deposit only wraps
+    // rounding up to far edge. Serial deposit below is skipped when agents were binned
+    enterPhase(PHASE_DEPOSIT);
+    const size_t nAgents = m_activeAgents;
     size_t i = 0;
-    for (; i + 4 <= nAgents; i += 4) {
+    if (binnedDeposit()) {
+        depositBinned(m_agents);
+        i = nAgents;
+    }
+#if defined(USE_WASM_SIMD)
+    const v128_t w_vec = wasm_i32x4_splat(static_cast<int32_t>(m_width));
+    const v128_t h_vec = wasm_i32x4_splat(static_cast<int32_t>(m_height));
+    const v128_t bias = wasm_f32x4_splat(0.5f);
+    for (; k.simd && i + 4 <= nAgents; i += 4) {
+        const Agent* agents = &m_agents[i];
+        // Positions are already wrapped, rounding can only reach w or h
+        v128_t xi_vec = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_add(
+            wasm_f32x4_make(agents[0].x, agents[1].x, agents[2].x, agents[3].x), bias));
+        v128_t yi_vec = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_add(
+            wasm_f32x4_make(agents[0].y, agents[1].y, agents[2].y, agents[3].y), bias));
+        xi_vec = wasm_i32x4_sub(xi_vec, wasm_v128_and(wasm_i32x4_ge(xi_vec, w_vec), w_vec));
+        yi_vec = wasm_i32x4_sub(yi_vec, wasm_v128_and(wasm_i32x4_ge(yi_vec, h_vec), h_vec));
+
+        alignas(16) int32_t idxs[4];
+        wasm_v128_store(idxs, wasm_i32x4_add(wasm_i32x4_mul(yi_vec, w_vec), xi_vec));
+        alignas(16) int32_t tiles[4];
+        wasm_v128_store(tiles, wasm_i32x4_add(
+            wasm_i32x4_mul(wasm_u32x4_shr(yi_vec, TILE_Y_SHIFT), wasm_i32x4_splat(static_cast<int32_t>(m_tilesX))),
+            wasm_u32x4_shr(xi_vec, TILE_X_SHIFT)));
+
+        m_field[idxs[0]] += 1.0f;
+        m_field[idxs[1]] += 1.0f;
+        m_field[idxs[2]] += 1.0f;
+        m_field[idxs[3]] += 1.0f;
+        for (int32_t t : tiles)
+            m_tileTouched[t] = 1;
+    }
+#elif defined(USE_AVX2)
+    for (; k.simd && i + 4 <= nAgents; i += 4) {
         Agent *agents = &m_agents[i];
         // === Step 1: Load x and y into vectors ===
         __m128 x_vec = _mm_set_ps(agents[3].x, agents[2].x, agents[1].x, agents[0].x);
         __m128 y_vec = _mm_set_ps(agents[3].y, agents[2].y, agents[1].y, agents[0].y);
 
-        // === Step 2: Round: (int)(x + 0.5f) ===
+        // === Step 2: Round: (int)(x + 0.5f), conversion must truncate as the cast ===
         __m128 bias = _mm_set1_ps(0.5f);
         x_vec = _mm_add_ps(x_vec, bias);
         y_vec = _mm_add_ps(y_vec, bias);
 
-        __m128i xi_vec = _mm_cvtps_epi32(x_vec);
-        __m128i yi_vec = _mm_cvtps_epi32(y_vec);
+        __m128i xi_vec = _mm_cvttps_epi32(x_vec);
+        __m128i yi_vec = _mm_cvttps_epi32(y_vec);
 
         // === Step 3: Wrap in [0, w) and [0, h) ===
         __m128i w_vec = _mm_set1_epi32(m_width);
@@ -312,16 +2316,26 @@ void SlimeMoldSimulation::Private::updateAgents(const AgentPreset &p) {
         m_field[idxs[1]] += 1.0f;
         m_field[idxs[2]] += 1.0f;
         m_field[idxs[3]] += 1.0f;
+
+        // === Step 6: Mark evaporation tiles ===
+        __m128i tile_vec = _mm_add_epi32(
+            _mm_mullo_epi32(_mm_srli_epi32(yi_vec, TILE_Y_SHIFT), _mm_set1_epi32(m_tilesX)),
+            _mm_srli_epi32(xi_vec, TILE_X_SHIFT)
+        );
+        alignas(16) int tiles[4];
+        _mm_store_si128((__m128i*)tiles, tile_vec);
+        for (int t : tiles)
+            m_tileTouched[t] = 1;
     }
+#endif
     for (; i < nAgents; ++i)
         deposit(m_agents[i]);
 
-#endif
-
 
     ++m_passes;
 #if DO_SORTING
     if (m_passes % 32) {
+        enterPhase(PHASE_SORT);
         sortAgents();
     }
 #endif
@@ -329,8 +2343,96 @@ void SlimeMoldSimulation::Private::updateAgents(const AgentPreset &p) {
 }
 
 
-SlimeMoldSimulation::SlimeMoldSimulation(size_t width, size_t height, size_t numAgents)
-    : m_p (std::make_unique<Private>(width, height, numAgents))
+void SlimeMoldSimulation::Private::resetLifecycle()
+{
+    std::ranges::fill(m_energy, m_lifecycle.spawnEnergy * 0.5f);
+    // Spread ages, so that agents do not die of age all at once
+    for (size_t i = 0; i < m_age.size(); ++i)
+        m_age[i] = m_lifecycle.maxAge ? hash32(static_cast<uint32_t>(i)) % m_lifecycle.maxAge : 0;
+}
+
+
+// Compaction by prefix sum: first pass decides fate of each agent and counts
+// survivors and parents per chunk, exclusive scan of counts gives each chunk
+// its output range, second pass copies agents there preserving order.
+void SlimeMoldSimulation::Private::updateLifecycle()
+{
+    if (m_agentFormat == AGENTS_COMPACT)
+        updateLifecycle(m_compact, m_compactNext);
+    else
+        updateLifecycle(m_agents, m_agentsNext);
+}
+
+
+template <typename AgentType>
+void SlimeMoldSimulation::Private::updateLifecycle(std::vector<AgentType>& agents, std::vector<AgentType>& agentsNext)
+{
+    const Lifecycle& lc = m_lifecycle;
+    const size_t nAgents = m_activeAgents;
+    const size_t nChunks = (nAgents + AGENT_CHUNK - 1) / AGENT_CHUNK;
+    m_chunkAlive.assign(nChunks, 0);
+    m_chunkSpawn.assign(nChunks, 0);
+
+    // === Pass 1: energy, age and fate ===
+    ThreadPool::global().parallelFor(nAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t alive = 0, spawn = 0;
+        for (size_t i = begin; i < end; ++i) {
+            const float trail = m_field[cellIndex(agents[i])];
+            const float energy = m_energy[i] + trail * lc.energyGain - lc.energyCost;
+            const uint32_t age = m_age[i] + 1;
+            m_energy[i] = energy;
+            m_age[i] = age;
+            uint8_t fate = FATE_DEAD;
+            if (energy > 0.0f && (lc.maxAge == 0 || age < lc.maxAge))
+                fate = (trail >= lc.spawnThreshold && energy >= lc.spawnEnergy) ? FATE_SPAWN : FATE_ALIVE;
+            m_fate[i] = fate;
+            alive += fate != FATE_DEAD;
+            spawn += fate == FATE_SPAWN;
+        }
+        m_chunkAlive[begin / AGENT_CHUNK] = alive;
+        m_chunkSpawn[begin / AGENT_CHUNK] = spawn;
+    });
+
+    // === Exclusive scan, children go after all survivors ===
+    size_t totalAlive = 0, totalSpawn = 0;
+    for (size_t c = 0; c < nChunks; ++c) {
+        totalAlive += std::exchange(m_chunkAlive[c], totalAlive);
+        totalSpawn += std::exchange(m_chunkSpawn[c], totalSpawn);
+    }
+    const size_t limit = m_agentLimit;
+
+    // === Pass 2: scatter survivors and children ===
+    const uint32_t passSalt = hash32(static_cast<uint32_t>(m_passes));
+    ThreadPool::global().parallelFor(nAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t out = m_chunkAlive[begin / AGENT_CHUNK];
+        size_t child = totalAlive + m_chunkSpawn[begin / AGENT_CHUNK];
+        for (size_t i = begin; i < end; ++i) {
+            if (m_fate[i] == FATE_DEAD)
+                continue;
+            float energy = m_energy[i];
+            if (m_fate[i] == FATE_SPAWN && child < limit) {
+                energy *= 0.5f;
+                agentsNext[child] = childAgent(agents[i], hash32(passSalt ^ static_cast<uint32_t>(i)));
+                m_energyNext[child] = energy;
+                m_ageNext[child] = 0;
+                ++child;
+            }
+            agentsNext[out] = agents[i];
+            m_energyNext[out] = energy;
+            m_ageNext[out] = m_age[i];
+            ++out;
+        }
+    });
+
+    std::swap(agents, agentsNext);
+    std::swap(m_energy, m_energyNext);
+    std::swap(m_age, m_ageNext);
+    m_activeAgents = std::min(totalAlive + totalSpawn, limit);
+}
+
+
+SlimeMoldSimulation::SlimeMoldSimulation(size_t width, size_t height, size_t numAgents, uint32_t seed)
+    : m_p (std::make_unique<Private>(width, height, numAgents, seed))
 {
 }
 
@@ -338,17 +2440,48 @@ SlimeMoldSimulation::SlimeMoldSimulation(size_t width, size_t height, size_t num
 SlimeMoldSimulation::~SlimeMoldSimulation() = default;
 
 
+inline void SlimeMoldSimulation::Private::enterPhase(Phase phase) const
+{
+    if (m_phaseCallback)
+        m_phaseCallback(phase);
+}
+
+
 void SlimeMoldSimulation::step(const AgentPreset &p)
 {
+    m_p->enterPhase(PHASE_MOVE);
     m_p->updateAgents(p);
+    if (m_p->m_lifecycle.enabled) {
+        m_p->enterPhase(PHASE_LIFECYCLE);
+        m_p->updateLifecycle();
+    }
+    m_p->enterPhase(PHASE_DIFFUSE);
     m_p->diffuse(p.evaporate);
+    m_p->enterPhase(PHASE_END);
 }
 
 
 void SlimeMoldSimulation::reset()
 {
     m_p->clearField();
+    resetAgents();
+}
+
+
+void SlimeMoldSimulation::resetAgents()
+{
     m_p->resetAgents();
+    m_p->m_activeAgents = m_p->m_agentLimit;
+    if (m_p->m_lifecycle.enabled)
+        m_p->resetLifecycle();
+}
+
+
+void SlimeMoldSimulation::reset(uint32_t seed)
+{
+    m_p->m_rng.seed(seed != 0 ? seed : static_cast<uint32_t>(time(0)));
+    m_p->m_passes = 0;
+    reset();
 }
 
 
@@ -358,6 +2491,169 @@ const float * SlimeMoldSimulation::data()
 }
 
 
+void SlimeMoldSimulation::setActiveAgents(size_t count)
+{
+    m_p->m_agentLimit = std::min(count, m_p->m_numAgents);
+    m_p->m_activeAgents = m_p->m_lifecycle.enabled
+        ? std::min(m_p->m_activeAgents, m_p->m_agentLimit)
+        : m_p->m_agentLimit;
+}
+
+
+size_t SlimeMoldSimulation::activeAgents() const
+{
+    return m_p->m_activeAgents;
+}
+
+
+size_t SlimeMoldSimulation::agentLimit() const
+{
+    return m_p->m_agentLimit;
+}
+
+
+size_t SlimeMoldSimulation::maxAgents() const
+{
+    return m_p->m_numAgents;
+}
+
+
+void SlimeMoldSimulation::setSpawnMode(SpawnMode mode)
+{
+    m_p->m_spawnMode = mode;
+}
+
+
+SlimeMoldSimulation::SpawnMode SlimeMoldSimulation::spawnMode() const
+{
+    return m_p->m_spawnMode;
+}
+
+
+void SlimeMoldSimulation::setSampling(Sampling sampling)
+{
+    m_p->m_sampling = sampling;
+}
+
+
+SlimeMoldSimulation::Sampling SlimeMoldSimulation::sampling() const
+{
+    return m_p->m_sampling;
+}
+
+
+void SlimeMoldSimulation::setKernels(Kernels kernels)
+{
+    m_p->m_kernels = kernels;
+}
+
+
+SlimeMoldSimulation::Kernels SlimeMoldSimulation::kernels() const
+{
+    return m_p->m_kernels;
+}
+
+
+void SlimeMoldSimulation::setPhaseCallback(PhaseCallback callback)
+{
+    m_p->m_phaseCallback = std::move(callback);
+}
+
+
+void SlimeMoldSimulation::setBoundary(Boundary boundary)
+{
+    m_p->m_boundary = boundary;
+}
+
+
+SlimeMoldSimulation::Boundary SlimeMoldSimulation::boundary() const
+{
+    return m_p->m_boundary;
+}
+
+
+bool SlimeMoldSimulation::setInputMap(InputMap map)
+{
+    const bool empty = !map.hasObstacles() && !map.hasAttractors();
+    if (!empty && (map.width != m_p->m_width || map.height != m_p->m_height))
+        return false;
+    m_p->m_inputs = std::move(map);
+    return true;
+}
+
+
+const InputMap& SlimeMoldSimulation::inputMap() const
+{
+    return m_p->m_inputs;
+}
+
+
+void SlimeMoldSimulation::setAttractorStrength(float strength)
+{
+    m_p->m_inputs.attractorStrength = strength;
+}
+
+
+void SlimeMoldSimulation::setLifecycle(const Lifecycle& lifecycle)
+{
+    auto& p = *m_p;
+    const bool wasEnabled = p.m_lifecycle.enabled;
+    p.m_lifecycle = lifecycle;
+    if (lifecycle.enabled && !wasEnabled) {
+        p.m_energy.resize(p.m_numAgents);
+        p.m_energyNext.resize(p.m_numAgents);
+        p.m_age.resize(p.m_numAgents);
+        p.m_ageNext.resize(p.m_numAgents);
+        if (p.m_agentFormat == AGENTS_COMPACT)
+            p.m_compactNext.resize(p.m_numAgents);
+        else
+            p.m_agentsNext.resize(p.m_numAgents);
+        p.m_fate.resize(p.m_numAgents);
+        p.resetLifecycle();
+    }
+    else if (!lifecycle.enabled && wasEnabled) {
+        // Slots of dead agents hold stale or zeroed agents, they spawn again
+        p.resetAgents(p.m_activeAgents);
+        p.m_activeAgents = p.m_agentLimit;
+    }
+}
+
+
+const SlimeMoldSimulation::Lifecycle& SlimeMoldSimulation::lifecycle() const
+{
+    return m_p->m_lifecycle;
+}
+
+
+bool SlimeMoldSimulation::setAgentFormat(AgentFormat format)
+{
+    if (format == AGENTS_COMPACT && (m_p->m_width > COMPACT_MAX_SIZE || m_p->m_height > COMPACT_MAX_SIZE))
+        return false;
+    m_p->setAgentFormat(format);
+    return true;
+}
+
+
+SlimeMoldSimulation::AgentFormat SlimeMoldSimulation::agentFormat() const
+{
+    return m_p->m_agentFormat;
+}
+
+
+bool SlimeMoldSimulation::setSensorPyramid(bool enabled)
+{
+    m_p->setSensorPyramid(enabled);
+    return m_p->m_pyramidEnabled == enabled;
+}
+
+
+bool SlimeMoldSimulation::sensorPyramid() const
+{
+    return m_p->m_pyramidEnabled;
+}
+
+
+// NOTE: does not reorder lifecycle state
 void SlimeMoldSimulation::Private::sortAgents()
 {
     // reuse vectors, resize when needed
@@ -368,11 +2664,12 @@ void SlimeMoldSimulation::Private::sortAgents()
     bucketCounts.resize(m_height);
     bucketStartOffsets.resize(m_height);
     bucketWriteOffsets.resize(m_height);
-    tempAgents.resize(m_agents.size());
+    tempAgents.resize(m_activeAgents);
+    const std::span<Agent> agents(m_agents.data(), m_activeAgents);
 
     // count occurrences per row
     std::ranges::fill(bucketCounts, 0);
-    for (const auto& a : m_agents) {
+    for (const auto& a : agents) {
         const size_t row = a.y;
         assert(row < m_height);
         ++bucketCounts[row];
@@ -387,12 +2684,12 @@ void SlimeMoldSimulation::Private::sortAgents()
     std::ranges::fill(bucketWriteOffsets, 0);
 
     // copy agents to temporary sorted by row
-    for (const auto& a : m_agents) {
+    for (const auto& a : agents) {
         const size_t row = a.y;
         const size_t writeOffset = bucketStartOffsets[row] + bucketWriteOffsets[row];
         tempAgents[writeOffset] = a;
         ++bucketWriteOffsets[row];
     }
 
-    std::ranges::copy(tempAgents, m_agents.begin());
+    std::ranges::copy(tempAgents, agents.begin());
 }
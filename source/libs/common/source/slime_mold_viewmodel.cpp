@@ -1,41 +1,207 @@
 //! \file slime_mold_viewmodel.cpp
 #include "common/slime_mold_viewmodel.h"
+#include "common/background_task.h"
+#include "common/colormap.h"
+#include "common/cpu_topology.h"
+#include "common/event_log.h"
+#include "common/field_stream.h"
+#include "common/frame_server.h"
+#include "common/perf_counters.h"
 #include "common/slime_mold_simulation.h"
-#include <immintrin.h>
+#include "common/slime_mold_volume.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+
+AgentPreset lerp(const AgentPreset& a, const AgentPreset& b, float t)
+{
+    AgentPreset r = b;
+    for (float AgentPreset::* m : { &AgentPreset::sensor_angle, &AgentPreset::sensor_dist, &AgentPreset::turn_angle,
+                                    &AgentPreset::step_size, &AgentPreset::evaporate, &AgentPreset::palette_mid })
+        r.*m = std::lerp(a.*m, b.*m, t);
+    return r;
+}
+
+} // anonymous namespace
+
 
 class SlimeMoldViewModel::Private final
 {
 public:
+    using Clock = std::chrono::steady_clock;
+
     Private(size_t width, size_t height);
 
+    static constexpr size_t NUM_AGENTS = 250000;
+
     //! Simulation
     SlimeMoldSimulation sim;
+    //! Steps done since construction or start of recording
+    uint64_t stepIndex = 0;
 
     size_t cmapInterpolation = CMAP_INTERP_OKLCH;
     size_t selectedPreset = 0;
     size_t selectedPalette = 0;
     static const std::array<const char*, 3> cmapLabels;
 
-    static constexpr size_t PALETTE_SIZE = 1024;
+    static constexpr size_t PALETTE_SIZE = colormap::PALETTE_SIZE;
     std::array<color::Rgb, 3> palette = { {
         { 0.31f, 0.14f, 0.33f },
         { 0.87f, 0.85f, 0.65f },
         { 0.54f, 0.99f, 0.77f },
     } };
 
-    std::vector<uint8_t> preparePalette();
+    std::vector<uint8_t> preparePalette(const std::array<color::Rgb, 3>& pal, float paletteMid) const;
+    std::vector<uint8_t> buildPalette(const std::array<color::Rgb, 3>& pal, float paletteMid) const;
+
+    //! Palette LUT in pixel format, regenerated only when palette, midpoint or interpolation changes
+    std::vector<uint8_t> paletteLut;
+    bool paletteDirty = true;
+    const std::vector<uint8_t>& currentPalette();
+
+    //! Timed transition to presets. LUTs of both ends are built at start, frames
+    //! only blend them. Start LUT is always one on screen, so an interrupted
+    //! transition continues without jump. When palette gets dirty, rest of
+    //! transition starts again from LUT on screen.
+    struct Morph {
+        bool active = false;
+        Clock::time_point start;
+        float seconds = 0.0f;
+        float t = 0.0f;
+        AgentPreset fromAgent{}, toAgent{};
+        std::array<color::Rgb, 3> fromPalette{}, toPalette{};
+        std::vector<uint8_t> fromLut, toLut;
+    } morph;
+    void startMorph(size_t agentIndex, size_t paletteIndex, float seconds);
+    void cancelMorph();
+    void advanceMorph();
+
+    //! Show cycling through presets
+    bool showEnabled = false;
+    float showHoldSeconds = 10.0f;
+    float showMorphSeconds = 5.0f;
+    Clock::time_point showNext;
 
     void renderToPixels(std::vector<uint8_t>& pixels, const float* field);
 
-    //! SDL Texture pixels
+    //! Runs steps with field stream output, returns milliseconds per step
+    float runSteps(const AgentPreset& a, float strength, size_t steps);
+    //! Colormaps field to display and gathers its stats, on caller thread only unless `parallel`.
+    //! Single chunk runs on caller thread, pool is left to steps running meanwhile.
+    void colormapField(const float* field, uint8_t* pixels, bool parallel);
+    //! Field sized pixels for publisher, colormapped again when display is scaled
+    const uint8_t* fieldPixels(const float* field, const uint8_t* displayPixels, bool parallel);
+    //! Pixel chunk must be multiple of 8 pixels (AVX2 width). Neighbouring row
+    //! chunks of scaled display both scale source rows they share.
+    static constexpr size_t PIXEL_CHUNK = 16384;
+    static constexpr size_t ROW_CHUNK = 32;
+
+    //! Display scaling, scaler is empty when display has field size
+    size_t displayWidth = 0, displayHeight = 0;
+    colormap::Filter displayFilter = colormap::FILTER_NEAREST;
+    colormap::Scaler scaler;
+
+    //! Pipelined frames. Task runs steps of next frame and copies field to
+    //! steppedField, while frame colormaps field swapped to shownField. Methods
+    //! touching simulation, step index, log or field stream finish steps first,
+    //! those replacing field or agents also clear `stepped`, so that next frame
+    //! does not show field stepped before them.
+    bool pipelined = BackgroundTask::concurrent();
+    bool stepped = false;           //!< steppedField holds field which was not shown yet
+    std::vector<float> shownField, steppedField;
+    float taskStepMs = 0.0f;
+    size_t activeAgents = 0;        //!< for UI, simulation may be stepping
+    float attractorStrength = InputMap().attractorStrength;    //!< set to simulation by runSteps
+    void finishSteps() { stepTask.wait(); }
+
+    //! Tone mapping. Other than fixed mode scale the field so that exposure (smoothed
+    //! percentile of previous frames) maps to end of palette. Log mode bends palette
+    //! itself, so colormap kernels are same for all modes.
+    static constexpr float FIXED_SCALE = 10.0f * PALETTE_SIZE / 256.0f;
+    static constexpr float TONEMAP_PERCENTILE = 0.995f;
+    static constexpr float LOG_GAIN = 32.0f;
+    static constexpr float MIN_EXPOSURE = 1.0f;
+    ToneMapping toneMapping = TONEMAP_FIXED;
+    float exposureSmoothing = 0.05f;
+    float exposure = (PALETTE_SIZE - 1) / FIXED_SCALE;
+    FieldStats stats;
+    float fieldScale() const;
+
+    //! Frame time governor
+    static constexpr size_t GOVERNOR_INTERVAL = 15;     // frames between adjustments
+    static constexpr float TIMING_SMOOTHING = 0.1f;
+    static constexpr size_t MIN_AGENTS = NUM_AGENTS / 16;
+    bool governorEnabled = false;
+    float frameBudgetMs = 12.0f;
+    size_t requestedSteps = 1;
+    size_t stepsPerFrame = 1;
+    float stepMs = 0.0f;
+    float colormapMs = 0.0f;
+    size_t framesSinceAdjust = 0;
+    void govern();
+
+    void recordLifecycle();
+
+    //! Worker load, counters of pool are sampled once a second
+    bool pinnedThreads = false;
+    std::vector<ThreadPool::WorkerStats> poolStats;
+    Clock::time_point poolStatsTime;
+    std::vector<WorkerStats> workerStats;
+    void updateWorkerStats();
+
+    //! Phase profiling, counters are opened on threads existing when it is
+    //! enabled and reopened when stats update finds new ones (pool resized).
+    //! Read only while steps are finished.
+    std::unique_ptr<PerfCounters> perfCounters;
+    std::unique_ptr<PhaseCounters> phaseCounters;
+    Clock::time_point phaseStatsTime;
+    std::vector<PhaseStats> phaseStats;
+    void startPhaseProfiling();
+    void stopPhaseProfiling();
+    void updatePhaseStats();
+
+    //! Histogram of palette indices and other stats collected by colormap chunks
+    static constexpr size_t HIST_BINS = colormap::HIST_BINS;
+    static constexpr size_t HIST_SHIFT = colormap::HIST_SHIFT;
+    using ChunkStats = colormap::Stats;
+    std::vector<ChunkStats> chunkStats;
+    void updateStats(float scale, size_t nPixels);
+
+    //! Field sized pixels published while display is scaled
     std::vector<uint8_t> pixels;
 
+    //! Volumetric mode when not null, projection of field size is shown instead of field
+    static constexpr size_t VOXELS_PER_AGENT = 16;
+    std::unique_ptr<SlimeMoldVolume> volume;
+    SlimeMoldVolume::Camera volumeCamera;
+    SlimeMoldVolume::Render volumeRender = SlimeMoldVolume::RENDER_MIP;
+    std::vector<float> projection;
+
     AgentPreset agent;
 
+    //! Shared memory publisher, null when not publishing
+    std::unique_ptr<FramePublisher> publisher;
+
+    //! Event log, recording when not null
+    std::unique_ptr<EventLog> log;
+
+    //! Raw field output, streaming when not null
+    std::unique_ptr<FieldStreamWriter> fieldStream;
+    size_t fieldStreamEvery = 1;
+
     //! FPS counter
     uint64_t last_counter = 0;
 
     size_t m_width, m_height;
+
+    //! Last member, destroyed first so that steps finish before simulation is gone
+    BackgroundTask stepTask;
 };
 
 
@@ -43,17 +209,18 @@ const std::array<const char*, 3> SlimeMoldViewModel::Private::cmapLabels = { "RG
 
 
 SlimeMoldViewModel::Private::Private(size_t width, size_t height)
-    : sim(width, height, 250000)
+    : sim(width, height, NUM_AGENTS)
+    , displayWidth(width)
+    , displayHeight(height)
     , m_width(width)
     , m_height(height)
 {
-    pixels.resize(width * height * 4, 0);
 }
 
 
-std::vector<uint8_t> SlimeMoldViewModel::Private::preparePalette()
+std::vector<uint8_t> SlimeMoldViewModel::Private::preparePalette(const std::array<color::Rgb, 3>& palette, float paletteMid) const
 {
-    size_t mid = (size_t)(agent.palette_mid * PALETTE_SIZE);
+    size_t mid = (size_t)(paletteMid * PALETTE_SIZE);
     color::GradientFunction gradientFn = nullptr;
     switch (cmapInterpolation)
     {
@@ -74,8 +241,25 @@ std::vector<uint8_t> SlimeMoldViewModel::Private::preparePalette()
         gradientFn = color::gradientOkLch;
         break;
     }
-    auto g1 = gradientFn(palette[0], palette[1], mid);
-    auto g2 = gradientFn(palette[1], palette[2], PALETTE_SIZE - mid);
+    // Built-in palettes have gradients baked at compile time, edited ones are generated
+    static_assert(static_cast<size_t>(CMAP_INTERP_END) == color::INTERP_END);
+    const auto& presets = presetPalettes();
+    const auto preset = std::find_if(presets.begin(), presets.end(), [&](const PalettePreset& p) {
+        return std::equal(palette.begin(), palette.end(), p.palette.begin(), [](const color::Rgb& a, const color::Rgb& b) {
+            return a.r == b.r && a.g == b.g && a.b == b.b;
+        });
+    });
+    std::vector<color::Rgb> g1, g2;
+    if (preset != presets.end()) {
+        const size_t index = preset - presets.begin();
+        const auto interpolation = static_cast<color::Interpolation>(cmapInterpolation < CMAP_INTERP_END ? cmapInterpolation : size_t(CMAP_INTERP_OKLCH));
+        g1 = presetGradient(index, 0, interpolation, mid);
+        g2 = presetGradient(index, 1, interpolation, PALETTE_SIZE - mid);
+    }
+    else {
+        g1 = color::gradientCached(gradientFn, palette[0], palette[1], mid);
+        g2 = color::gradientCached(gradientFn, palette[1], palette[2], PALETTE_SIZE - mid);
+    }
     std::vector<uint8_t> result(PALETTE_SIZE * 4);
     for (size_t i = 0; i < PALETTE_SIZE; i++) {
         result[i * 4] = 255.0f;
@@ -95,6 +279,333 @@ std::vector<uint8_t> SlimeMoldViewModel::Private::preparePalette()
 }
 
 
+std::vector<uint8_t> SlimeMoldViewModel::Private::buildPalette(const std::array<color::Rgb, 3>& pal, float paletteMid) const
+{
+    auto lut = preparePalette(pal, paletteMid);
+    if (toneMapping == TONEMAP_LOG) {
+        // Bend palette, index j shows color of log curve at j
+        const auto linear = lut;
+        const float norm = (PALETTE_SIZE - 1) / std::log1p(LOG_GAIN);
+        for (size_t j = 0; j < PALETTE_SIZE; ++j) {
+            const float t = static_cast<float>(j) / (PALETTE_SIZE - 1);
+            const size_t src = std::min(static_cast<size_t>(std::log1p(LOG_GAIN * t) * norm + 0.5f), PALETTE_SIZE - 1);
+            std::copy_n(&linear[src * 4], 4, &lut[j * 4]);
+        }
+    }
+    return lut;
+}
+
+
+const std::vector<uint8_t>& SlimeMoldViewModel::Private::currentPalette()
+{
+    if (morph.active) {
+        if (paletteDirty) {
+            // Palette of interrupted transition is blend of LUTs, not LUT of its
+            // palette, so start LUT is not rebuilt but taken from screen
+            const float remaining = morph.seconds * (1.0f - morph.t);
+            morph.fromLut = paletteLut;
+            morph.fromAgent = agent;
+            morph.fromPalette = palette;
+            morph.toLut = buildPalette(morph.toPalette, morph.toAgent.palette_mid);
+            morph.start = Clock::now();
+            morph.seconds = remaining;
+            morph.t = 0.0f;
+            paletteDirty = false;
+        }
+        // 8-bit weights are enough for 8-bit channels
+        const uint32_t w = static_cast<uint32_t>(morph.t * 256.0f + 0.5f);
+        paletteLut.resize(morph.toLut.size());
+        for (size_t i = 0; i < paletteLut.size(); ++i)
+            paletteLut[i] = static_cast<uint8_t>((morph.fromLut[i] * (256 - w) + morph.toLut[i] * w) >> 8);
+        return paletteLut;
+    }
+    if (paletteDirty) {
+        paletteLut = buildPalette(palette, agent.palette_mid);
+        paletteDirty = false;
+    }
+    return paletteLut;
+}
+
+
+void SlimeMoldViewModel::Private::startMorph(size_t agentIndex, size_t paletteIndex, float seconds)
+{
+    // Start from what is on screen now, also in middle of other transition
+    morph.fromLut = currentPalette();
+    morph.fromAgent = agent;
+    morph.fromPalette = palette;
+    morph.toAgent = presetAgents()[agentIndex];
+    morph.toPalette = presetPalettes()[paletteIndex].palette;
+    morph.toLut = buildPalette(morph.toPalette, morph.toAgent.palette_mid);
+    morph.start = Clock::now();
+    morph.seconds = seconds;
+    morph.t = 0.0f;
+    morph.active = true;
+    selectedPreset = agentIndex;
+    selectedPalette = paletteIndex;
+}
+
+
+void SlimeMoldViewModel::Private::cancelMorph()
+{
+    if (morph.active) {
+        morph.active = false;
+        paletteDirty = true;
+    }
+}
+
+
+void SlimeMoldViewModel::Private::advanceMorph()
+{
+    const auto now = Clock::now();
+    if (showEnabled && !morph.active && now >= showNext) {
+        startMorph((selectedPreset + 1) % presetAgents().size(),
+            (selectedPalette + 1) % presetPalettes().size(), showMorphSeconds);
+    }
+    if (!morph.active)
+        return;
+
+    const float elapsed = std::chrono::duration<float>(now - morph.start).count();
+    morph.t = morph.seconds > 0.0f ? std::min(elapsed / morph.seconds, 1.0f) : 1.0f;
+    agent = lerp(morph.fromAgent, morph.toAgent, morph.t);
+    for (size_t i = 0; i < palette.size(); ++i) {
+        palette[i].r = std::lerp(morph.fromPalette[i].r, morph.toPalette[i].r, morph.t);
+        palette[i].g = std::lerp(morph.fromPalette[i].g, morph.toPalette[i].g, morph.t);
+        palette[i].b = std::lerp(morph.fromPalette[i].b, morph.toPalette[i].b, morph.t);
+    }
+    if (log)
+        log->addAgent(stepIndex, agent);
+
+    if (morph.t >= 1.0f) {
+        morph.active = false;
+        agent = morph.toAgent;
+        palette = morph.toPalette;
+        if (!paletteDirty)
+            paletteLut = std::move(morph.toLut);
+        if (log)
+            log->addPalette(stepIndex, palette);
+        showNext = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(showHoldSeconds));
+    }
+}
+
+
+float SlimeMoldViewModel::Private::fieldScale() const
+{
+    return toneMapping == TONEMAP_FIXED
+        ? FIXED_SCALE
+        : (PALETTE_SIZE - 1) / exposure;
+}
+
+
+void SlimeMoldViewModel::Private::updateStats(float scale, size_t nPixels)
+{
+    ChunkStats total;
+    for (const auto& c : chunkStats) {
+        total.max = std::max(total.max, c.max);
+        total.sum += c.sum;
+        for (size_t b = 0; b < HIST_BINS; ++b)
+            total.hist[b] += c.hist[b];
+    }
+
+    // Percentile from histogram of palette indices, top bin contains saturated values
+    const double target = TONEMAP_PERCENTILE * nPixels;
+    double cumulative = 0.0;
+    size_t bin = 0;
+    for (; bin < HIST_BINS - 1; ++bin) {
+        cumulative += total.hist[bin];
+        if (cumulative >= target)
+            break;
+    }
+    const float percentile = (bin == HIST_BINS - 1)
+        ? total.max
+        : static_cast<float>((bin + 1) << HIST_SHIFT) / scale;
+
+    stats.max = total.max;
+    stats.mean = static_cast<float>(total.sum / nPixels);
+    stats.percentile = percentile;
+    exposure += exposureSmoothing * (std::max(percentile, MIN_EXPOSURE) - exposure);
+    stats.exposure = exposure;
+}
+
+
+void SlimeMoldViewModel::Private::updateWorkerStats()
+{
+    const auto now = Clock::now();
+    const float seconds = std::chrono::duration<float>(now - poolStatsTime).count();
+    if (seconds < 1.0f)
+        return;
+    auto current = ThreadPool::global().stats();
+    if (current.size() == poolStats.size()) {
+        workerStats.resize(current.size());
+        for (size_t i = 0; i < current.size(); ++i) {
+            const size_t chunks = current[i].chunks - poolStats[i].chunks;
+            const size_t stolen = current[i].stolenChunks - poolStats[i].stolenChunks;
+            workerStats[i].cpu = current[i].cpu;
+            workerStats[i].utilization = static_cast<float>(current[i].busySeconds - poolStats[i].busySeconds) / seconds;
+            workerStats[i].stolen = chunks ? static_cast<float>(stolen) / chunks : 0.0f;
+        }
+    }
+    poolStats = std::move(current);
+    poolStatsTime = now;
+}
+
+
+void SlimeMoldViewModel::Private::startPhaseProfiling()
+{
+    perfCounters = std::make_unique<PerfCounters>();
+    phaseCounters = std::make_unique<PhaseCounters>(perfCounters->valid() ? perfCounters.get() : nullptr,
+        SlimeMoldSimulation::PHASE_END);
+    sim.setPhaseCallback([this](SlimeMoldSimulation::Phase phase) { phaseCounters->mark(phase); });
+    phaseStatsTime = Clock::now();
+}
+
+
+void SlimeMoldViewModel::Private::stopPhaseProfiling()
+{
+    sim.setPhaseCallback({});
+    phaseCounters.reset();
+    perfCounters.reset();
+    phaseStats.clear();
+}
+
+
+void SlimeMoldViewModel::Private::updatePhaseStats()
+{
+    const auto now = Clock::now();
+    if (!phaseCounters || std::chrono::duration<float>(now - phaseStatsTime).count() < 1.0f)
+        return;
+    phaseStats.clear();
+    for (size_t i = 0; i < SlimeMoldSimulation::PHASE_END; ++i) {
+        const PhaseCounters::Totals& t = phaseCounters->totals()[i];
+        if (t.runs == 0)
+            continue;
+        PhaseStats s;
+        s.phase = static_cast<SlimeMoldSimulation::Phase>(i);
+        s.perCell = s.phase == SlimeMoldSimulation::PHASE_DIFFUSE;
+        s.msPerStep = static_cast<float>(t.seconds * 1000.0 / t.runs);
+        const double units = static_cast<double>(t.runs) * (s.perCell ? m_width * m_height : std::max<size_t>(sim.activeAgents(), 1));
+        auto perUnit = [&](PerfCounters::Counter c) {
+            return perfCounters->available(c) ? static_cast<float>(t.values[c] / units) : -1.0f;
+        };
+        s.cycles = perUnit(PerfCounters::CYCLES);
+        s.instructions = perUnit(PerfCounters::INSTRUCTIONS);
+        s.llcMisses = perUnit(PerfCounters::LLC_MISSES);
+        s.dtlbMisses = perUnit(PerfCounters::DTLB_MISSES);
+        s.threads = perfCounters->threads();
+        phaseStats.push_back(s);
+    }
+    phaseCounters->clear();
+    phaseStatsTime = now;
+    // Work of threads started since counters were opened would be missing
+    if (perfCounters->valid() && perfCounters->newThreads() > 0)
+        startPhaseProfiling();
+}
+
+
+void SlimeMoldViewModel::Private::govern()
+{
+    // With lifecycle, population changes on its own, governor moves its limit
+    const size_t active = sim.activeAgents();
+    const size_t limit = sim.agentLimit();
+    const size_t maxAgents = sim.maxAgents();
+    if (!governorEnabled) {
+        stepsPerFrame = requestedSteps;
+        if (limit != maxAgents && !log)
+            sim.setActiveAgents(maxAgents);
+        return;
+    }
+    if (++framesSinceAdjust < GOVERNOR_INTERVAL)
+        return;
+    framesSinceAdjust = 0;
+
+    // Pipelined frame takes as long as slower of steps and colormap
+    const float stepsMs = stepsPerFrame * stepMs;
+    const float frameMs = pipelined ? std::max(stepsMs, colormapMs) : stepsMs + colormapMs;
+    if (frameMs > frameBudgetMs) {
+        // Fewer steps first, then fewer agents, step time is roughly proportional to agents
+        if (stepsPerFrame > 1) {
+            --stepsPerFrame;
+        }
+        else if (!log && active > MIN_AGENTS) {
+            const float stepBudget = std::max(frameBudgetMs - (pipelined ? 0.0f : colormapMs), 0.1f) * 0.9f;
+            const float ratio = std::clamp(stepBudget / stepMs, 0.5f, 0.95f);
+            sim.setActiveAgents(std::max(MIN_AGENTS, static_cast<size_t>(active * ratio)));
+        }
+    }
+    else if (frameMs < 0.75f * frameBudgetMs) {
+        if (!log && limit < maxAgents)
+            sim.setActiveAgents(std::min(maxAgents, static_cast<size_t>(limit * 1.1f) + 1));
+        else if (stepsPerFrame < requestedSteps)
+            ++stepsPerFrame;
+    }
+}
+
+
+float SlimeMoldViewModel::Private::runSteps(const AgentPreset& a, float strength, size_t steps)
+{
+    const auto start = Clock::now();
+    sim.setAttractorStrength(strength);
+    for (size_t i = 0; i < steps; ++i) {
+        sim.step(a);
+        ++stepIndex;
+        if (fieldStream && stepIndex % fieldStreamEvery == 0)
+            fieldStream->write(stepIndex, sim.data());
+    }
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count() / steps;
+}
+
+
+void SlimeMoldViewModel::Private::colormapField(const float* field, uint8_t* pixels, bool parallel)
+{
+    const auto& palette = currentPalette();
+    const float scale = fieldScale();
+    if (scaler.dstWidth != 0) {
+        const size_t chunk = parallel ? ROW_CHUNK : displayHeight;
+        chunkStats.assign((displayHeight + chunk - 1) / chunk, {});
+        ThreadPool::global().parallelFor(displayHeight, chunk, [&](size_t begin, size_t end) {
+            colormap::applyScaled(scaler, field, pixels, begin, end, palette.data(), scale,
+                chunkStats[begin / chunk]);
+        });
+        updateStats(scale, displayWidth * displayHeight);
+        return;
+    }
+
+    const size_t nPixels = m_width * m_height;
+    const size_t chunk = parallel ? PIXEL_CHUNK : nPixels;
+    chunkStats.assign((nPixels + chunk - 1) / chunk, {});
+    ThreadPool::global().parallelFor(nPixels, chunk, [&](size_t begin, size_t end) {
+        // Stats are gathered here, so there is no extra pass over the field
+        colormap::apply(field + begin, pixels + begin * 4, end - begin, palette.data(), scale,
+            chunkStats[begin / chunk]);
+    });
+    updateStats(scale, nPixels);
+}
+
+
+const uint8_t* SlimeMoldViewModel::Private::fieldPixels(const float* field, const uint8_t* displayPixels, bool parallel)
+{
+    if (scaler.dstWidth == 0)
+        return displayPixels;
+    const size_t nPixels = m_width * m_height;
+    const auto& palette = currentPalette();
+    const float scale = fieldScale();
+    pixels.resize(nPixels * 4);
+    ThreadPool::global().parallelFor(nPixels, parallel ? PIXEL_CHUNK : nPixels, [&](size_t begin, size_t end) {
+        colormap::Stats unused;
+        colormap::apply(field + begin, pixels.data() + begin * 4, end - begin, palette.data(), scale, unused);
+    });
+    return pixels.data();
+}
+
+
+void SlimeMoldViewModel::Private::recordLifecycle()
+{
+    const auto& lc = sim.lifecycle();
+    log->addOption(stepIndex, EventLog::OPTION_MAX_AGE, lc.maxAge);
+    log->addOption(stepIndex, EventLog::OPTION_SPAWN_THRESHOLD, std::bit_cast<uint32_t>(lc.spawnThreshold));
+    log->addOption(stepIndex, EventLog::OPTION_LIFECYCLE, lc.enabled);
+}
+
+
 SlimeMoldViewModel::SlimeMoldViewModel(size_t width, size_t height)
     : m_p(std::make_unique<Private>(width, height))
 {
@@ -108,15 +619,28 @@ SlimeMoldViewModel::~SlimeMoldViewModel() = default;
 
 void SlimeMoldViewModel::selectAgentPreset(size_t index)
 {
+    m_p->cancelMorph();
     m_p->selectedPreset = index;
     m_p->agent = presetAgents()[index];
+    m_p->paletteDirty = true;
+    // Only log needs step index, agent and palette are not used by running steps
+    if (m_p->log) {
+        m_p->finishSteps();
+        m_p->log->addAgent(m_p->stepIndex, m_p->agent);
+    }
 }
 
 
 void SlimeMoldViewModel::selectPalettePreset(size_t index)
 {
+    m_p->cancelMorph();
     m_p->selectedPalette = index;
     m_p->palette = presetPalettes()[index].palette;
+    m_p->paletteDirty = true;
+    if (m_p->log) {
+        m_p->finishSteps();
+        m_p->log->addPalette(m_p->stepIndex, m_p->palette);
+    }
 }
 
 
@@ -139,7 +663,14 @@ AgentPreset SlimeMoldViewModel::agent() const
 
 void SlimeMoldViewModel::setAgent(const AgentPreset& a)
 {
+    m_p->cancelMorph();
+    if (a.palette_mid != m_p->agent.palette_mid)
+        m_p->paletteDirty = true;
     m_p->agent = a;
+    if (m_p->log) {
+        m_p->finishSteps();
+        m_p->log->addAgent(m_p->stepIndex, a);
+    }
 }
 
 
@@ -151,56 +682,580 @@ std::array<color::Rgb, 3> SlimeMoldViewModel::palette() const
 
 void SlimeMoldViewModel::setPalette(const std::array<color::Rgb, 3>& pal)
 {
+    m_p->cancelMorph();
     m_p->palette = pal;
+    m_p->paletteDirty = true;
+    if (m_p->log) {
+        m_p->finishSteps();
+        m_p->log->addPalette(m_p->stepIndex, pal);
+    }
+}
+
+
+void SlimeMoldViewModel::morphToPresets(size_t agentIndex, size_t paletteIndex, float seconds)
+{
+    m_p->startMorph(agentIndex, paletteIndex, seconds);
+}
+
+
+bool SlimeMoldViewModel::morphing() const
+{
+    return m_p->morph.active;
+}
+
+
+void SlimeMoldViewModel::setShow(bool enabled, float holdSeconds, float morphSeconds)
+{
+    if (enabled && !m_p->showEnabled)
+        m_p->showNext = Private::Clock::now();
+    m_p->showEnabled = enabled;
+    m_p->showHoldSeconds = holdSeconds;
+    m_p->showMorphSeconds = morphSeconds;
+}
+
+
+bool SlimeMoldViewModel::showEnabled() const
+{
+    return m_p->showEnabled;
+}
+
+
+void SlimeMoldViewModel::setGovernor(bool enabled, float budgetMs)
+{
+    m_p->governorEnabled = enabled;
+    m_p->frameBudgetMs = budgetMs;
+}
+
+
+void SlimeMoldViewModel::setStepsPerFrame(size_t steps)
+{
+    m_p->requestedSteps = std::max<size_t>(steps, 1);
+    m_p->stepsPerFrame = std::min(m_p->stepsPerFrame, m_p->requestedSteps);
+}
+
+
+SlimeMoldViewModel::GovernorStats SlimeMoldViewModel::governorStats() const
+{
+    GovernorStats g;
+    g.enabled = m_p->governorEnabled;
+    g.budgetMs = m_p->frameBudgetMs;
+    g.stepMs = m_p->stepMs;
+    g.colormapMs = m_p->colormapMs;
+    g.stepsPerFrame = m_p->stepsPerFrame;
+    g.activeAgents = m_p->pipelined ? m_p->activeAgents : m_p->sim.activeAgents();
+    g.maxAgents = m_p->sim.maxAgents();
+    if (m_p->volume) {
+        g.stepsPerFrame = m_p->requestedSteps;
+        g.activeAgents = g.maxAgents = m_p->volume->numAgents();
+    }
+    return g;
+}
+
+
+void SlimeMoldViewModel::setPipelined(bool enabled)
+{
+    m_p->finishSteps();
+    // Next pipelined frame starts from current field
+    m_p->pipelined = enabled && BackgroundTask::concurrent();
+    m_p->stepped = false;
+}
+
+
+bool SlimeMoldViewModel::pipelined() const
+{
+    return m_p->pipelined;
+}
+
+
+bool SlimeMoldViewModel::setPinnedThreads(bool enabled)
+{
+    const std::vector<int> cores = enabled ? cpusOnePerCore(cpuTopology()) : std::vector<int>();
+    if (enabled && cores.empty())
+        return false;
+    m_p->finishSteps();
+    // Workers take all cores but last one, thread calling loops runs there
+    ThreadPool::global().resize(cores.size(), cores);
+    m_p->pinnedThreads = enabled;
+    m_p->poolStats.clear();
+    m_p->workerStats.clear();
+    // Counters are opened per thread, new workers need them opened again
+    if (m_p->phaseCounters)
+        m_p->startPhaseProfiling();
+    return true;
+}
+
+
+bool SlimeMoldViewModel::pinnedThreads() const
+{
+    return m_p->pinnedThreads;
+}
+
+
+std::vector<SlimeMoldViewModel::WorkerStats> SlimeMoldViewModel::workerStats() const
+{
+    return m_p->workerStats;
+}
+
+
+bool SlimeMoldViewModel::setPhaseProfiling(bool enabled)
+{
+    m_p->finishSteps();
+    m_p->stepped = false;
+    if (!enabled) {
+        m_p->stopPhaseProfiling();
+        return true;
+    }
+    m_p->phaseStats.clear();
+    m_p->startPhaseProfiling();
+    return m_p->perfCounters->valid();
+}
+
+
+bool SlimeMoldViewModel::phaseProfiling() const
+{
+    return m_p->phaseCounters != nullptr;
+}
+
+
+std::vector<SlimeMoldViewModel::PhaseStats> SlimeMoldViewModel::phaseStats() const
+{
+    return m_p->phaseStats;
+}
+
+
+void SlimeMoldViewModel::setBilinearSampling(bool enabled)
+{
+    m_p->finishSteps();
+    const auto sampling = enabled ? SlimeMoldSimulation::SAMPLING_BILINEAR : SlimeMoldSimulation::SAMPLING_NEAREST;
+    if (sampling == m_p->sim.sampling())
+        return;
+    m_p->sim.setSampling(sampling);
+    if (m_p->log)
+        m_p->log->addOption(m_p->stepIndex, EventLog::OPTION_SAMPLING, sampling);
+}
+
+
+bool SlimeMoldViewModel::bilinearSampling() const
+{
+    return m_p->sim.sampling() == SlimeMoldSimulation::SAMPLING_BILINEAR;
+}
+
+
+void SlimeMoldViewModel::setBoundary(SlimeMoldSimulation::Boundary boundary)
+{
+    m_p->finishSteps();
+    if (boundary == m_p->sim.boundary())
+        return;
+    m_p->sim.setBoundary(boundary);
+    if (m_p->log)
+        m_p->log->addOption(m_p->stepIndex, EventLog::OPTION_BOUNDARY, boundary);
+}
+
+
+SlimeMoldSimulation::Boundary SlimeMoldViewModel::boundary() const
+{
+    return m_p->sim.boundary();
+}
+
+
+void SlimeMoldViewModel::setCompactAgents(bool enabled)
+{
+    m_p->finishSteps();
+    const auto format = enabled ? SlimeMoldSimulation::AGENTS_COMPACT : SlimeMoldSimulation::AGENTS_FLOAT;
+    if (format == m_p->sim.agentFormat() || !m_p->sim.setAgentFormat(format))
+        return;
+    if (m_p->log)
+        m_p->log->addOption(m_p->stepIndex, EventLog::OPTION_AGENT_FORMAT, format);
+}
+
+
+bool SlimeMoldViewModel::compactAgents() const
+{
+    return m_p->sim.agentFormat() == SlimeMoldSimulation::AGENTS_COMPACT;
+}
+
+
+void SlimeMoldViewModel::setSensorPyramid(bool enabled)
+{
+    m_p->finishSteps();
+    if (enabled == m_p->sim.sensorPyramid() || !m_p->sim.setSensorPyramid(enabled))
+        return;
+    if (m_p->log)
+        m_p->log->addOption(m_p->stepIndex, EventLog::OPTION_SENSOR_PYRAMID, enabled);
+}
+
+
+bool SlimeMoldViewModel::sensorPyramid() const
+{
+    return m_p->sim.sensorPyramid();
+}
+
+
+bool SlimeMoldViewModel::loadInputMap(const std::string& obstaclesPath, const std::string& attractorsPath)
+{
+    if (m_p->log)
+        return false;
+    m_p->finishSteps();
+    InputMap map(m_p->m_width, m_p->m_height);
+    map.attractorStrength = m_p->attractorStrength;
+    const bool obstacles = map.loadObstacles(obstaclesPath);
+    const bool attractors = map.loadAttractors(attractorsPath);
+    if (!obstacles && !attractors)
+        return false;
+    return m_p->sim.setInputMap(std::move(map));
+}
+
+
+void SlimeMoldViewModel::clearInputMap()
+{
+    m_p->finishSteps();
+    InputMap map;
+    map.attractorStrength = m_p->attractorStrength;
+    m_p->sim.setInputMap(std::move(map));
+}
+
+
+bool SlimeMoldViewModel::hasInputMap() const
+{
+    const auto& map = m_p->sim.inputMap();
+    return map.hasObstacles() || map.hasAttractors();
+}
+
+
+void SlimeMoldViewModel::setAttractorStrength(float strength)
+{
+    if (m_p->log)
+        return;
+    // Like agent, passed to steps of next frame, running steps are not waited for
+    m_p->attractorStrength = strength;
+}
+
+
+float SlimeMoldViewModel::attractorStrength() const
+{
+    return m_p->attractorStrength;
+}
+
+
+void SlimeMoldViewModel::setLifecycle(bool enabled, uint32_t maxAge, float spawnThreshold)
+{
+    m_p->finishSteps();
+    auto lc = m_p->sim.lifecycle();
+    lc.enabled = enabled;
+    lc.maxAge = maxAge;
+    lc.spawnThreshold = spawnThreshold;
+    m_p->sim.setLifecycle(lc);
+    if (m_p->log)
+        m_p->recordLifecycle();
+}
+
+
+bool SlimeMoldViewModel::lifecycleEnabled() const
+{
+    return m_p->sim.lifecycle().enabled;
+}
+
+
+void SlimeMoldViewModel::setToneMapping(ToneMapping mode)
+{
+    if (mode != m_p->toneMapping)
+        m_p->paletteDirty = true;
+    m_p->toneMapping = mode;
+}
+
+
+SlimeMoldViewModel::ToneMapping SlimeMoldViewModel::toneMapping() const
+{
+    return m_p->toneMapping;
+}
+
+
+SlimeMoldViewModel::FieldStats SlimeMoldViewModel::fieldStats() const
+{
+    return m_p->stats;
+}
+
+
+void SlimeMoldViewModel::setDisplay(size_t width, size_t height, colormap::Filter filter)
+{
+    auto& p = *m_p;
+    p.displayWidth = width;
+    p.displayHeight = height;
+    p.displayFilter = filter;
+    // All filters are identity on field size
+    p.scaler = width == p.m_width && height == p.m_height
+        ? colormap::Scaler{}
+        : colormap::makeScaler(p.m_width, p.m_height, width, height, filter);
+}
+
+
+size_t SlimeMoldViewModel::displayWidth() const
+{
+    return m_p->displayWidth;
+}
+
+
+size_t SlimeMoldViewModel::displayHeight() const
+{
+    return m_p->displayHeight;
+}
+
+
+colormap::Filter SlimeMoldViewModel::displayFilter() const
+{
+    return m_p->displayFilter;
+}
+
+
+void SlimeMoldViewModel::setVolume(size_t size)
+{
+    auto& p = *m_p;
+    if (size == volumeSize())
+        return;
+    p.finishSteps();
+    // Pipelined frames start again from current field
+    p.stepped = false;
+    if (size == 0) {
+        p.volume.reset();
+        p.projection = {};
+        return;
+    }
+    p.volume.reset();
+    p.volume = std::make_unique<SlimeMoldVolume>(size, size, size, size * size * size / Private::VOXELS_PER_AGENT);
+    p.projection.assign(p.m_width * p.m_height, 0.0f);
+}
+
+
+size_t SlimeMoldViewModel::volumeSize() const
+{
+    return m_p->volume ? m_p->volume->width() : 0;
+}
+
+
+void SlimeMoldViewModel::setVolumeView(const SlimeMoldVolume::Camera& camera, SlimeMoldVolume::Render render)
+{
+    m_p->volumeCamera = camera;
+    m_p->volumeRender = render;
+}
+
+
+SlimeMoldVolume::Camera SlimeMoldViewModel::volumeCamera() const
+{
+    return m_p->volumeCamera;
+}
+
+
+SlimeMoldVolume::Render SlimeMoldViewModel::volumeRender() const
+{
+    return m_p->volumeRender;
 }
 
 
 void SlimeMoldViewModel::updatePixels(uint8_t* pixels)
 {
-    
-    m_p->sim.step(m_p->agent);
-    const float* field = m_p->sim.data();
-    const size_t nPixels = m_p->m_width * m_p->m_height;
-
-    const auto palette = m_p->preparePalette();
-#if defined(USE_AVX2)
-    // Initialize scale and clamp
-    const __m256 kVec   = _mm256_set1_ps(10.0f * Private::PALETTE_SIZE / 256.0f);
-    const __m256 maxIdx = _mm256_set1_ps(static_cast<float>(Private::PALETTE_SIZE - 1));
-
-    // Process 8 pixels at a time
-    constexpr size_t avxWidth = 8;
-    for (size_t i = 0; i < nPixels; i += avxWidth) {
-        // Load 8 field values
-        __m256 fieldVals = _mm256_loadu_ps(field + i);
-        // Scale and clamp
-        fieldVals = _mm256_mul_ps(fieldVals, kVec);
-        fieldVals = _mm256_min_ps(fieldVals, maxIdx);
-        // Convert to integers (palette indices)
-        __m256i indices = _mm256_cvtps_epi32(fieldVals);
-        // Fetch colors as uint32_t
-        __m256i colors = _mm256_i32gather_epi32(
-            reinterpret_cast<const int*>(palette.data()),   // base pointer (cast to int*)
-            indices,                                        // the 8 indices
-            4                                               // scale: each index * 4 bytes
-        );
-        // Store colors to pixels
-        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4), colors);
-    }
-#else
-    constexpr float k = 10.0f * Private::PALETTE_SIZE / 256.0f;
-    const uint32_t* paletteU32 = reinterpret_cast<const uint32_t*>(palette.data());
-    uint32_t* pixelsU32 = reinterpret_cast<uint32_t*>(pixels);
-    for (int i = 0; i < nPixels; i++) {
-        int c = std::min(field[i] * k, static_cast<float>(Private::PALETTE_SIZE - 1));
-        //uint8_t c = (uint8_t)std::min(log(field[i]+2.73f)*20.f, 255.0f);
-        pixelsU32[i] = paletteU32[c];
-    }
-#endif
+    using Clock = Private::Clock;
+    auto smooth = [](float& value, float sample) {
+        value = value == 0.0f ? sample : value + Private::TIMING_SMOOTHING * (sample - value);
+    };
+    auto& p = *m_p;
+    p.updateWorkerStats();
+
+    if (p.volume) {
+        p.advanceMorph();
+        auto start = Clock::now();
+        for (size_t i = 0; i < p.requestedSteps; ++i)
+            p.volume->step(p.agent);
+        smooth(p.stepMs, std::chrono::duration<float, std::milli>(Clock::now() - start).count() / p.requestedSteps);
+        // Projection counts as colormap, both turn volume into pixels
+        start = Clock::now();
+        p.volume->render(p.projection.data(), p.m_width, p.m_height, p.volumeCamera, p.volumeRender);
+        p.colormapField(p.projection.data(), pixels, true);
+        smooth(p.colormapMs, std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+        if (p.publisher)
+            p.publisher->publish(p.projection.data(), p.fieldPixels(p.projection.data(), pixels, true));
+        return;
+    }
+
+    if (!p.pipelined || p.phaseCounters) {
+        p.updatePhaseStats();
+        p.advanceMorph();
+        const float ms = p.runSteps(p.agent, p.attractorStrength, p.stepsPerFrame);
+        const auto startColormap = Clock::now();
+        p.colormapField(p.sim.data(), pixels, true);
+        smooth(p.stepMs, ms);
+        smooth(p.colormapMs, std::chrono::duration<float, std::milli>(Clock::now() - startColormap).count());
+        p.govern();
+        if (p.publisher)
+            p.publisher->publish(p.sim.data(), p.fieldPixels(p.sim.data(), pixels, true));
+        return;
+    }
+
+    // === Step 1: Take field stepped during previous frame ===
+    p.finishSteps();
+    if (p.stepped) {
+        std::swap(p.shownField, p.steppedField);
+        smooth(p.stepMs, p.taskStepMs);
+    }
+    else {
+        p.shownField.assign(p.sim.data(), p.sim.data() + p.m_width * p.m_height);
+    }
+    p.govern();
+    p.advanceMorph();
+    p.activeAgents = p.sim.activeAgents();
+
+    // === Step 2: Start steps of next frame, they overlap colormap and rest of frame ===
+    p.stepped = true;
+    p.stepTask.start([&p, agent = p.agent, strength = p.attractorStrength, steps = p.stepsPerFrame] {
+        p.taskStepMs = p.runSteps(agent, strength, steps);
+        p.steppedField.assign(p.sim.data(), p.sim.data() + p.m_width * p.m_height);
+    });
+
+    // === Step 3: Colormap shown field ===
+    const auto startColormap = Clock::now();
+    p.colormapField(p.shownField.data(), pixels, false);
+    smooth(p.colormapMs, std::chrono::duration<float, std::milli>(Clock::now() - startColormap).count());
+    if (p.publisher)
+        p.publisher->publish(p.shownField.data(), p.fieldPixels(p.shownField.data(), pixels, false));
 }
 
 
 void SlimeMoldViewModel::reset()
 {
+    if (m_p->volume) {
+        m_p->volume->reset();
+        return;
+    }
+    m_p->finishSteps();
+    // Field stepped before reset must not be shown
+    m_p->stepped = false;
     m_p->sim.reset();
+    if (m_p->log)
+        m_p->log->addReset(m_p->stepIndex);
+}
+
+
+void SlimeMoldViewModel::resetAgents()
+{
+    m_p->finishSteps();
+    m_p->stepped = false;
+    m_p->sim.resetAgents();
+    if (m_p->log)
+        m_p->log->addResetAgents(m_p->stepIndex);
+}
+
+
+void SlimeMoldViewModel::setSpawnMode(SlimeMoldSimulation::SpawnMode mode)
+{
+    m_p->finishSteps();
+    m_p->sim.setSpawnMode(mode);
+    if (m_p->log)
+        m_p->log->addOption(m_p->stepIndex, EventLog::OPTION_SPAWN_MODE, mode);
+}
+
+
+SlimeMoldSimulation::SpawnMode SlimeMoldViewModel::spawnMode() const
+{
+    return m_p->sim.spawnMode();
+}
+
+
+bool SlimeMoldViewModel::startPublishing(const std::string& name)
+{
+    auto publisher = std::make_unique<FramePublisher>(name, m_p->m_width, m_p->m_height);
+    if (!publisher->valid())
+        return false;
+    m_p->publisher = std::move(publisher);
+    return true;
+}
+
+
+void SlimeMoldViewModel::stopPublishing()
+{
+    m_p->publisher.reset();
+}
+
+
+bool SlimeMoldViewModel::publishing() const
+{
+    return m_p->publisher != nullptr;
+}
+
+
+bool SlimeMoldViewModel::startFieldStream(const std::string& path, size_t everySteps)
+{
+    m_p->finishSteps();
+    auto stream = std::make_unique<FieldStreamWriter>(path, m_p->m_width, m_p->m_height);
+    if (!stream->valid())
+        return false;
+    m_p->fieldStream = std::move(stream);
+    m_p->fieldStreamEvery = std::max<size_t>(everySteps, 1);
+    return true;
+}
+
+
+bool SlimeMoldViewModel::stopFieldStream()
+{
+    m_p->finishSteps();
+    if (!m_p->fieldStream)
+        return false;
+    const bool ok = m_p->fieldStream->close();
+    m_p->fieldStream.reset();
+    return ok;
+}
+
+
+bool SlimeMoldViewModel::fieldStreaming() const
+{
+    return m_p->fieldStream != nullptr;
+}
+
+
+bool SlimeMoldViewModel::startRecording()
+{
+    if (hasInputMap())
+        return false;
+    m_p->finishSteps();
+    // Seed must be known and nonzero to replay
+    uint32_t seed = 0;
+    while (seed == 0)
+        seed = std::random_device{}();
+    // Limit first, reset revives agents up to it
+    m_p->sim.setActiveAgents(m_p->sim.maxAgents());
+    m_p->sim.reset(seed);
+    m_p->stepped = false;
+    m_p->stepIndex = 0;
+
+    m_p->log = std::make_unique<EventLog>();
+    auto& log = *m_p->log;
+    log.width = static_cast<uint32_t>(m_p->m_width);
+    log.height = static_cast<uint32_t>(m_p->m_height);
+    log.numAgents = static_cast<uint32_t>(Private::NUM_AGENTS);
+    log.seed = seed;
+    log.addAgent(0, m_p->agent);
+    log.addPalette(0, m_p->palette);
+    log.addOption(0, EventLog::OPTION_SAMPLING, m_p->sim.sampling());
+    log.addOption(0, EventLog::OPTION_BOUNDARY, m_p->sim.boundary());
+    log.addOption(0, EventLog::OPTION_SPAWN_MODE, m_p->sim.spawnMode());
+    log.addOption(0, EventLog::OPTION_AGENT_FORMAT, m_p->sim.agentFormat());
+    log.addOption(0, EventLog::OPTION_SENSOR_PYRAMID, m_p->sim.sensorPyramid());
+    m_p->recordLifecycle();
+    return true;
+}
+
+
+bool SlimeMoldViewModel::stopRecording(const std::string& path)
+{
+    m_p->finishSteps();
+    if (!m_p->log)
+        return false;
+    auto log = std::move(m_p->log);
+    const size_t nCells = m_p->m_width * m_p->m_height;
+    log->addEnd(m_p->stepIndex, EventLog::fieldHash(m_p->sim.data(), nCells));
+    return log->save(path);
+}
+
+
+bool SlimeMoldViewModel::recording() const
+{
+    return m_p->log != nullptr;
 }
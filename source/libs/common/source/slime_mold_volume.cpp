@@ -0,0 +1,968 @@
+//! \file slime_mold_volume.cpp
+#include "common/slime_mold_volume.h"
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <ctime>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <utility>
+#include <vector>
+
+#if defined(USE_AVX2)
+#include <immintrin.h>
+#endif
+
+// WebAssembly SIMD128 has no gather, only diffusion rows are vectorized.
+#if defined(USE_WASM_SIMD)
+#include <wasm_simd128.h>
+#endif
+
+namespace {
+
+// Voxel index is brick * 512 + (z & 7) * 64 + (y & 7) * 8 + (x & 7)
+constexpr int BRICK_SHIFT = 3;
+constexpr int BRICK_MASK = (1 << BRICK_SHIFT) - 1;
+constexpr size_t BRICK_VOXELS = size_t(1) << (3 * BRICK_SHIFT);
+static_assert(SlimeMoldVolume::BRICK_SIZE == size_t(1) << BRICK_SHIFT);
+
+// Pool chunks of agents, bricks (4096 voxels) and image rows
+constexpr size_t AGENT_CHUNK = 4096;
+constexpr size_t BRICK_CHUNK = 8;
+constexpr size_t ROW_CHUNK = 4;
+
+// Agents are sorted by brick every SORT_INTERVAL steps, they move a few voxels
+// per step, so sensors and deposits keep hitting nearby bricks in between
+constexpr size_t SORT_INTERVAL = 8;
+
+constexpr float DEPOSIT = 1.0f;
+// Share of each neighbour along each axis per step
+constexpr float DIFFUSION = 0.125f;
+// Evaporated trail below this is cleared, so empty bricks have maximum 0
+// and diffusion does not slow down on denormals
+constexpr float CLEAR_LEVEL = 1e-4f;
+
+// Samples are one voxel apart. Emission skips bricks below EMPTY_LEVEL and
+// ends ray when less than OPAQUE_LEVEL of light behind would pass.
+constexpr float RAY_STEP = 1.0f;
+constexpr float EMPTY_LEVEL = 0.01f;
+constexpr float ABSORPTION = 0.05f;
+constexpr float OPAQUE_LEVEL = 0.01f;
+
+
+// Same stateless hash and unit float as 2D simulation, five words per agent
+inline uint32_t hash32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+
+inline uint32_t randomWord(uint32_t salt, size_t i, uint32_t k)
+{
+    return hash32(static_cast<uint32_t>(i * 8 + k) ^ salt);
+}
+
+
+inline float unitFloat(uint32_t r)
+{
+    return static_cast<float>(r >> 8) * 0x1p-24f;
+}
+
+
+// Per step constants derived from preset
+struct MoveParams
+{
+    float sensorCos, sensorSin;
+    float turnCos, turnSin;
+    float sensorDist, stepSize;
+    bool simd;
+};
+
+
+// Nearest voxel of coordinate at most one size outside of volume
+inline int wrapCell(float v, int n)
+{
+    int i = static_cast<int>(std::floor(v + 0.5f));
+    if (i < 0)
+        i += n;
+    if (i >= n)
+        i -= n;
+    return i;
+}
+
+
+// Trail below EMPTY_LEVEL is transparent, above it absorbs v * A / (1 + v * A)
+// of light and emits its value in same share, so result stays within range of
+// trail along ray
+inline float opacity(float v)
+{
+    const float a = v * ABSORPTION;
+    return v >= EMPTY_LEVEL ? a / (1.0f + a) : 0.0f;
+}
+
+
+// Ray of one pixel, samples are at origin + dir * k * RAY_STEP for k in [kBegin, kEnd)
+struct Ray
+{
+    float ox, oy, oz;
+    float dx, dy, dz;
+    int kBegin, kEnd;
+};
+
+
+// Orthographic view: rays start on plane behind volume and go along forward
+struct View
+{
+    float fx, fy, fz;       // forward
+    float rx, ry, rz;       // right, horizontal
+    float ux, uy, uz;       // up
+    float cx, cy, cz;       // center of image plane
+    float pixelSize;
+    size_t width, height;
+};
+
+} // anonymous namespace
+
+
+class SlimeMoldVolume::Private final
+{
+public:
+    Private(size_t width, size_t height, size_t depth, size_t numAgents, uint32_t seed);
+
+    inline uint32_t voxelIndex(uint32_t x, uint32_t y, uint32_t z) const;
+    inline float sample(float x, float y, float z) const;
+
+    MoveParams makeMoveParams(const AgentPreset&) const;
+    void resetAgents();
+    void sortAgents();
+    void moveAgents(const MoveParams&);
+    inline void moveAgent(size_t i, const MoveParams&);
+#if defined(USE_AVX2)
+    inline void moveAgentsAvx2(size_t first, const MoveParams&);
+#endif
+    void deposit();
+    void diffuse(float evaporate);
+    void updateNearMax();
+    template <int Axis>
+    void diffuseBrick(const float* src, float* dst, size_t brick, float evaporate, bool last, bool simd);
+
+    View makeView(const Camera&, size_t width, size_t height) const;
+    Ray makeRay(const View&, size_t i, size_t j) const;
+    inline size_t chunkBrick(const Ray&, int k) const;
+#if defined(USE_AVX2)
+    inline __m256 raySamplesAvx2(const Ray&, int k, int n) const;
+#endif
+    inline void raySamples(const Ray&, int k, int n, float* values, bool simd) const;
+    float marchMip(const Ray&, bool simd) const;
+    float marchEmission(const Ray&, bool simd) const;
+
+    size_t m_width, m_height, m_depth;
+    size_t m_bricksX, m_bricksY, m_bricksZ;
+    size_t m_numAgents;
+    // Agents as structure of arrays, position and unit heading
+    std::vector<float> m_x, m_y, m_z;
+    std::vector<float> m_dx, m_dy, m_dz;
+    std::vector<float> m_volume, m_scratch;
+    // Maximum of every brick, and of it with its 26 neighbours for renderer
+    std::vector<float> m_brickMax, m_nearMax;
+    // Sorting: destination of every agent and start of every brick
+    std::vector<float> m_sorted;
+    std::vector<uint32_t> m_keys, m_offsets;
+    size_t m_steps = 0;
+    std::mt19937 m_rng;
+    SlimeMoldSimulation::Kernels m_kernels = SlimeMoldSimulation::KERNELS_SIMD;
+};
+
+
+SlimeMoldVolume::Private::Private(size_t width, size_t height, size_t depth, size_t numAgents, uint32_t seed)
+    : m_width(width)
+    , m_height(height)
+    , m_depth(depth)
+    , m_bricksX(width >> BRICK_SHIFT)
+    , m_bricksY(height >> BRICK_SHIFT)
+    , m_bricksZ(depth >> BRICK_SHIFT)
+    , m_numAgents(numAgents)
+    , m_x(numAgents), m_y(numAgents), m_z(numAgents)
+    , m_dx(numAgents), m_dy(numAgents), m_dz(numAgents)
+    , m_volume(width * height * depth, 0.0f)
+    , m_scratch(width * height * depth, 0.0f)
+    , m_brickMax(m_bricksX * m_bricksY * m_bricksZ, 0.0f)
+    , m_nearMax(m_brickMax.size(), 0.0f)
+    , m_sorted(numAgents), m_keys(numAgents)
+    , m_offsets(m_brickMax.size() + 1)
+    , m_rng(seed != 0 ? seed : static_cast<uint32_t>(time(0)))
+{
+    assert(width % BRICK_SIZE == 0 && height % BRICK_SIZE == 0 && depth % BRICK_SIZE == 0 && width * height * depth > 0);
+    // Vector kernels index voxels by 32-bit integers
+    assert(m_volume.size() <= static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+    resetAgents();
+}
+
+
+inline uint32_t SlimeMoldVolume::Private::voxelIndex(uint32_t x, uint32_t y, uint32_t z) const
+{
+    const uint32_t brick = ((z >> BRICK_SHIFT) * static_cast<uint32_t>(m_bricksY) + (y >> BRICK_SHIFT))
+        * static_cast<uint32_t>(m_bricksX) + (x >> BRICK_SHIFT);
+    return (brick << (3 * BRICK_SHIFT)) | ((z & BRICK_MASK) << (2 * BRICK_SHIFT)) | ((y & BRICK_MASK) << BRICK_SHIFT) | (x & BRICK_MASK);
+}
+
+
+// Voxel centers are at integer coordinates as in 2D field
+inline float SlimeMoldVolume::Private::sample(float x, float y, float z) const
+{
+    return m_volume[voxelIndex(
+        wrapCell(x, static_cast<int>(m_width)),
+        wrapCell(y, static_cast<int>(m_height)),
+        wrapCell(z, static_cast<int>(m_depth)))];
+}
+
+
+MoveParams SlimeMoldVolume::Private::makeMoveParams(const AgentPreset& p) const
+{
+    // Sensors stay within one size of volume, as wrapCell expects
+    const size_t smallest = std::min({ m_width, m_height, m_depth });
+    return {
+        std::cos(p.sensor_angle), std::sin(p.sensor_angle),
+        std::cos(p.turn_angle),   std::sin(p.turn_angle),
+        std::min(p.sensor_dist, static_cast<float>(smallest / 2 - 1)), p.step_size,
+        m_kernels == SlimeMoldSimulation::KERNELS_SIMD
+    };
+}
+
+
+void SlimeMoldVolume::Private::resetAgents()
+{
+    const uint32_t salt = m_rng();
+    ThreadPool::global().parallelFor(m_numAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            m_x[i] = unitFloat(randomWord(salt, i, 0)) * m_width;
+            m_y[i] = unitFloat(randomWord(salt, i, 1)) * m_height;
+            m_z[i] = unitFloat(randomWord(salt, i, 2)) * m_depth;
+            // Uniform on sphere: z uniform in [-1, 1), angle around z uniform
+            const float z = 2.0f * unitFloat(randomWord(salt, i, 3)) - 1.0f;
+            const float angle = 2.0f * std::numbers::pi_v<float> * unitFloat(randomWord(salt, i, 4));
+            const float r = std::sqrt(1.0f - z * z);
+            m_dx[i] = r * std::cos(angle);
+            m_dy[i] = r * std::sin(angle);
+            m_dz[i] = z;
+        }
+    });
+}
+
+
+// Stable counting sort by brick, result does not depend on threads
+void SlimeMoldVolume::Private::sortAgents()
+{
+    ThreadPool::global().parallelFor(m_numAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            m_keys[i] = voxelIndex(
+                wrapCell(m_x[i], static_cast<int>(m_width)),
+                wrapCell(m_y[i], static_cast<int>(m_height)),
+                wrapCell(m_z[i], static_cast<int>(m_depth))) >> (3 * BRICK_SHIFT);
+        }
+    });
+    std::fill(m_offsets.begin(), m_offsets.end(), 0);
+    for (size_t i = 0; i < m_numAgents; ++i)
+        ++m_offsets[m_keys[i] + 1];
+    for (size_t b = 1; b < m_offsets.size(); ++b)
+        m_offsets[b] += m_offsets[b - 1];
+    // Destination of every agent in keys, offsets are consumed
+    for (size_t i = 0; i < m_numAgents; ++i)
+        m_keys[i] = m_offsets[m_keys[i]]++;
+    for (auto* v : { &m_x, &m_y, &m_z, &m_dx, &m_dy, &m_dz }) {
+        ThreadPool::global().parallelFor(m_numAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                m_sorted[m_keys[i]] = (*v)[i];
+        });
+        std::swap(*v, m_sorted);
+    }
+}
+
+
+inline void SlimeMoldVolume::Private::moveAgent(size_t i, const MoveParams& k)
+{
+    float hx = m_dx[i], hy = m_dy[i], hz = m_dz[i];
+    const float px = m_x[i], py = m_y[i], pz = m_z[i];
+
+    // === Step 1: Frame of heading, u is perpendicular to it and to z (or x near z), v completes it ===
+    const bool aroundZ = std::abs(hz) < 0.9f;
+    float ux = aroundZ ? -hy : 0.0f;
+    float uy = aroundZ ? hx : -hz;
+    float uz = aroundZ ? 0.0f : hy;
+    const float length = std::sqrt(ux * ux + uy * uy + uz * uz);
+    ux /= length;
+    uy /= length;
+    uz /= length;
+    const float vx = hy * uz - hz * uy;
+    const float vy = hz * ux - hx * uz;
+    const float vz = hx * uy - hy * ux;
+
+    // === Step 2: Sense along heading and tilted toward +u, +v, -u, -v ===
+    const float d = k.sensorDist;
+    const float ax = hx * k.sensorCos, ay = hy * k.sensorCos, az = hz * k.sensorCos;
+    const float bux = ux * k.sensorSin, buy = uy * k.sensorSin, buz = uz * k.sensorSin;
+    const float bvx = vx * k.sensorSin, bvy = vy * k.sensorSin, bvz = vz * k.sensorSin;
+    const float c  = sample(px + hx * d, py + hy * d, pz + hz * d);
+    const float s0 = sample(px + (ax + bux) * d, py + (ay + buy) * d, pz + (az + buz) * d);
+    const float s1 = sample(px + (ax + bvx) * d, py + (ay + bvy) * d, pz + (az + bvz) * d);
+    const float s2 = sample(px + (ax - bux) * d, py + (ay - buy) * d, pz + (az - buz) * d);
+    const float s3 = sample(px + (ax - bvx) * d, py + (ay - bvy) * d, pz + (az - bvz) * d);
+
+    // === Step 3: Turn toward strongest side (first of equal ones) unless center is as strong ===
+    float best = s0, sx = ux, sy = uy, sz = uz;
+    if (s1 > best) { best = s1; sx = vx;  sy = vy;  sz = vz; }
+    if (s2 > best) { best = s2; sx = -ux; sy = -uy; sz = -uz; }
+    if (s3 > best) { best = s3; sx = -vx; sy = -vy; sz = -vz; }
+    if (c < best) {
+        hx = hx * k.turnCos + sx * k.turnSin;
+        hy = hy * k.turnCos + sy * k.turnSin;
+        hz = hz * k.turnCos + sz * k.turnSin;
+        const float norm = std::sqrt(hx * hx + hy * hy + hz * hz);
+        hx /= norm;
+        hy /= norm;
+        hz /= norm;
+    }
+
+    // === Step 4: Move and wrap around ===
+    const float w = static_cast<float>(m_width), h = static_cast<float>(m_height), dd = static_cast<float>(m_depth);
+    float x = px + hx * k.stepSize;
+    float y = py + hy * k.stepSize;
+    float z = pz + hz * k.stepSize;
+    if (x < 0.0f) x += w;
+    if (x >= w) x -= w;
+    if (y < 0.0f) y += h;
+    if (y >= h) y -= h;
+    if (z < 0.0f) z += dd;
+    if (z >= dd) z -= dd;
+    m_x[i] = x;
+    m_y[i] = y;
+    m_z[i] = z;
+    m_dx[i] = hx;
+    m_dy[i] = hy;
+    m_dz[i] = hz;
+}
+
+
+#if defined(USE_AVX2)
+// Same operations as moveAgent in same order, 8 agents from first
+inline void SlimeMoldVolume::Private::moveAgentsAvx2(size_t first, const MoveParams& k)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i sizeX = _mm256_set1_epi32(static_cast<int>(m_width));
+    const __m256i sizeY = _mm256_set1_epi32(static_cast<int>(m_height));
+    const __m256i sizeZ = _mm256_set1_epi32(static_cast<int>(m_depth));
+    const __m256i bricksX = _mm256_set1_epi32(static_cast<int>(m_bricksX));
+    const __m256i bricksY = _mm256_set1_epi32(static_cast<int>(m_bricksY));
+    const __m256i mask = _mm256_set1_epi32(BRICK_MASK);
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+
+    // wrapCell: round, add size below 0, subtract size at or above it
+    auto wrap = [&](__m256 v, __m256i n) {
+        __m256i i = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(v, half)));
+        i = _mm256_add_epi32(i, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), i), n));
+        return _mm256_sub_epi32(i, _mm256_andnot_si256(_mm256_cmpgt_epi32(n, i), n));
+    };
+    auto sample = [&](__m256 x, __m256 y, __m256 z) {
+        const __m256i xi = wrap(x, sizeX), yi = wrap(y, sizeY), zi = wrap(z, sizeZ);
+        const __m256i brick = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(
+            _mm256_mullo_epi32(_mm256_srli_epi32(zi, BRICK_SHIFT), bricksY), _mm256_srli_epi32(yi, BRICK_SHIFT)), bricksX),
+            _mm256_srli_epi32(xi, BRICK_SHIFT));
+        const __m256i index = _mm256_or_si256(
+            _mm256_or_si256(_mm256_slli_epi32(brick, 3 * BRICK_SHIFT), _mm256_slli_epi32(_mm256_and_si256(zi, mask), 2 * BRICK_SHIFT)),
+            _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(yi, mask), BRICK_SHIFT), _mm256_and_si256(xi, mask)));
+        return _mm256_mask_i32gather_ps(zero, m_volume.data(), index, _mm256_castsi256_ps(minusOne), 4);
+    };
+
+    __m256 hx = _mm256_loadu_ps(&m_dx[first]);
+    __m256 hy = _mm256_loadu_ps(&m_dy[first]);
+    __m256 hz = _mm256_loadu_ps(&m_dz[first]);
+    const __m256 px = _mm256_loadu_ps(&m_x[first]);
+    const __m256 py = _mm256_loadu_ps(&m_y[first]);
+    const __m256 pz = _mm256_loadu_ps(&m_z[first]);
+
+    // === Step 1: Frame of heading ===
+    const __m256 aroundZ = _mm256_cmp_ps(_mm256_andnot_ps(signMask, hz), _mm256_set1_ps(0.9f), _CMP_LT_OQ);
+    __m256 ux = _mm256_blendv_ps(zero, _mm256_xor_ps(hy, signMask), aroundZ);
+    __m256 uy = _mm256_blendv_ps(_mm256_xor_ps(hz, signMask), hx, aroundZ);
+    __m256 uz = _mm256_blendv_ps(hy, zero, aroundZ);
+    const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(ux, ux), _mm256_mul_ps(uy, uy)), _mm256_mul_ps(uz, uz)));
+    ux = _mm256_div_ps(ux, length);
+    uy = _mm256_div_ps(uy, length);
+    uz = _mm256_div_ps(uz, length);
+    const __m256 vx = _mm256_sub_ps(_mm256_mul_ps(hy, uz), _mm256_mul_ps(hz, uy));
+    const __m256 vy = _mm256_sub_ps(_mm256_mul_ps(hz, ux), _mm256_mul_ps(hx, uz));
+    const __m256 vz = _mm256_sub_ps(_mm256_mul_ps(hx, uy), _mm256_mul_ps(hy, ux));
+
+    // === Step 2: Sense ===
+    const __m256 d = _mm256_set1_ps(k.sensorDist);
+    const __m256 sc = _mm256_set1_ps(k.sensorCos);
+    const __m256 ss = _mm256_set1_ps(k.sensorSin);
+    const __m256 ax = _mm256_mul_ps(hx, sc), ay = _mm256_mul_ps(hy, sc), az = _mm256_mul_ps(hz, sc);
+    const __m256 bux = _mm256_mul_ps(ux, ss), buy = _mm256_mul_ps(uy, ss), buz = _mm256_mul_ps(uz, ss);
+    const __m256 bvx = _mm256_mul_ps(vx, ss), bvy = _mm256_mul_ps(vy, ss), bvz = _mm256_mul_ps(vz, ss);
+    auto sensor = [&](__m256 ox, __m256 oy, __m256 oz) {
+        return sample(_mm256_add_ps(px, _mm256_mul_ps(ox, d)), _mm256_add_ps(py, _mm256_mul_ps(oy, d)),
+            _mm256_add_ps(pz, _mm256_mul_ps(oz, d)));
+    };
+    const __m256 c  = sensor(hx, hy, hz);
+    const __m256 s0 = sensor(_mm256_add_ps(ax, bux), _mm256_add_ps(ay, buy), _mm256_add_ps(az, buz));
+    const __m256 s1 = sensor(_mm256_add_ps(ax, bvx), _mm256_add_ps(ay, bvy), _mm256_add_ps(az, bvz));
+    const __m256 s2 = sensor(_mm256_sub_ps(ax, bux), _mm256_sub_ps(ay, buy), _mm256_sub_ps(az, buz));
+    const __m256 s3 = sensor(_mm256_sub_ps(ax, bvx), _mm256_sub_ps(ay, bvy), _mm256_sub_ps(az, bvz));
+
+    // === Step 3: Turn ===
+    __m256 best = s0, sx = ux, sy = uy, sz = uz;
+    __m256 m = _mm256_cmp_ps(s1, best, _CMP_GT_OQ);
+    best = _mm256_blendv_ps(best, s1, m);
+    sx = _mm256_blendv_ps(sx, vx, m);
+    sy = _mm256_blendv_ps(sy, vy, m);
+    sz = _mm256_blendv_ps(sz, vz, m);
+    m = _mm256_cmp_ps(s2, best, _CMP_GT_OQ);
+    best = _mm256_blendv_ps(best, s2, m);
+    sx = _mm256_blendv_ps(sx, _mm256_xor_ps(ux, signMask), m);
+    sy = _mm256_blendv_ps(sy, _mm256_xor_ps(uy, signMask), m);
+    sz = _mm256_blendv_ps(sz, _mm256_xor_ps(uz, signMask), m);
+    m = _mm256_cmp_ps(s3, best, _CMP_GT_OQ);
+    best = _mm256_blendv_ps(best, s3, m);
+    sx = _mm256_blendv_ps(sx, _mm256_xor_ps(vx, signMask), m);
+    sy = _mm256_blendv_ps(sy, _mm256_xor_ps(vy, signMask), m);
+    sz = _mm256_blendv_ps(sz, _mm256_xor_ps(vz, signMask), m);
+    const __m256 turn = _mm256_cmp_ps(c, best, _CMP_LT_OQ);
+    const __m256 tc = _mm256_set1_ps(k.turnCos);
+    const __m256 ts = _mm256_set1_ps(k.turnSin);
+    __m256 nx = _mm256_add_ps(_mm256_mul_ps(hx, tc), _mm256_mul_ps(sx, ts));
+    __m256 ny = _mm256_add_ps(_mm256_mul_ps(hy, tc), _mm256_mul_ps(sy, ts));
+    __m256 nz = _mm256_add_ps(_mm256_mul_ps(hz, tc), _mm256_mul_ps(sz, ts));
+    const __m256 norm = _mm256_sqrt_ps(_mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz)));
+    hx = _mm256_blendv_ps(hx, _mm256_div_ps(nx, norm), turn);
+    hy = _mm256_blendv_ps(hy, _mm256_div_ps(ny, norm), turn);
+    hz = _mm256_blendv_ps(hz, _mm256_div_ps(nz, norm), turn);
+
+    // === Step 4: Move and wrap around ===
+    const __m256 step = _mm256_set1_ps(k.stepSize);
+    auto move = [&](__m256 p, __m256 h, size_t n) {
+        const __m256 size = _mm256_set1_ps(static_cast<float>(n));
+        __m256 v = _mm256_add_ps(p, _mm256_mul_ps(h, step));
+        v = _mm256_add_ps(v, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_LT_OQ), size));
+        return _mm256_sub_ps(v, _mm256_and_ps(_mm256_cmp_ps(v, size, _CMP_GE_OQ), size));
+    };
+    _mm256_storeu_ps(&m_x[first], move(px, hx, m_width));
+    _mm256_storeu_ps(&m_y[first], move(py, hy, m_height));
+    _mm256_storeu_ps(&m_z[first], move(pz, hz, m_depth));
+    _mm256_storeu_ps(&m_dx[first], hx);
+    _mm256_storeu_ps(&m_dy[first], hy);
+    _mm256_storeu_ps(&m_dz[first], hz);
+}
+#endif
+
+
+void SlimeMoldVolume::Private::moveAgents(const MoveParams& k)
+{
+    ThreadPool::global().parallelFor(m_numAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        size_t i = begin;
+#if defined(USE_AVX2)
+        if (k.simd) {
+            for (; i + 8 <= end; i += 8)
+                moveAgentsAvx2(i, k);
+        }
+#endif
+        for (; i < end; ++i)
+            moveAgent(i, k);
+    });
+}
+
+
+void SlimeMoldVolume::Private::deposit()
+{
+    // Every agent adds same amount, so sum in voxel does not depend on order of atomic adds
+    ThreadPool::global().parallelFor(m_numAgents, AGENT_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t index = voxelIndex(
+                wrapCell(m_x[i], static_cast<int>(m_width)),
+                wrapCell(m_y[i], static_cast<int>(m_height)),
+                wrapCell(m_z[i], static_cast<int>(m_depth)));
+            std::atomic_ref<float>(m_volume[index]).fetch_add(DEPOSIT, std::memory_order_relaxed);
+        }
+    });
+}
+
+
+// Filters one brick along axis (0 is x) from src to dst, last pass also evaporates,
+// clears faint trail and updates maximum of brick. Neighbours wrap around.
+template <int Axis>
+void SlimeMoldVolume::Private::diffuseBrick(const float* src, float* dst, size_t brick, float evaporate, bool last, bool simd)
+{
+    constexpr int B = 1 << BRICK_SHIFT;
+    const size_t bx = brick % m_bricksX;
+    const size_t by = (brick / m_bricksX) % m_bricksY;
+    const size_t bz = brick / (m_bricksX * m_bricksY);
+    // Neighbouring bricks along axis
+    size_t prevBrick = brick, nextBrick = brick;
+    if constexpr (Axis == 0) {
+        prevBrick = brick - bx + (bx + m_bricksX - 1) % m_bricksX;
+        nextBrick = brick - bx + (bx + 1) % m_bricksX;
+    } else if constexpr (Axis == 1) {
+        prevBrick = brick + (((by + m_bricksY - 1) % m_bricksY) - by) * m_bricksX;
+        nextBrick = brick + (((by + 1) % m_bricksY) - by) * m_bricksX;
+    } else {
+        const size_t slice = m_bricksX * m_bricksY;
+        prevBrick = brick + (((bz + m_bricksZ - 1) % m_bricksZ) - bz) * slice;
+        nextBrick = brick + (((bz + 1) % m_bricksZ) - bz) * slice;
+    }
+    const float* in = src + brick * BRICK_VOXELS;
+    const float* prevIn = src + prevBrick * BRICK_VOXELS;
+    const float* nextIn = src + nextBrick * BRICK_VOXELS;
+    float* out = dst + brick * BRICK_VOXELS;
+    float maximum = 0.0f;
+
+#if defined(USE_AVX2)
+    if (simd) {
+        const __m256 k = _mm256_set1_ps(DIFFUSION);
+        const __m256 e = _mm256_set1_ps(evaporate);
+        const __m256 clear = _mm256_set1_ps(CLEAR_LEVEL);
+        const __m256i toLeft = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+        const __m256i toRight = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+        __m256 vmax = _mm256_setzero_ps();
+        for (int row = 0; row < B * B; ++row) {
+            const int y = row & (B - 1), z = row >> BRICK_SHIFT;
+            const __m256 c = _mm256_loadu_ps(in + row * B);
+            __m256 l, r;
+            if constexpr (Axis == 0) {
+                l = _mm256_blend_ps(_mm256_permutevar8x32_ps(c, toLeft), _mm256_set1_ps(prevIn[row * B + B - 1]), 0x01);
+                r = _mm256_blend_ps(_mm256_permutevar8x32_ps(c, toRight), _mm256_set1_ps(nextIn[row * B]), 0x80);
+            } else if constexpr (Axis == 1) {
+                l = _mm256_loadu_ps(y > 0 ? in + (row - 1) * B : prevIn + (z * B + B - 1) * B);
+                r = _mm256_loadu_ps(y < B - 1 ? in + (row + 1) * B : nextIn + (z * B) * B);
+            } else {
+                l = _mm256_loadu_ps(z > 0 ? in + (row - B) * B : prevIn + ((B - 1) * B + y) * B);
+                r = _mm256_loadu_ps(z < B - 1 ? in + (row + B) * B : nextIn + y * B);
+            }
+            __m256 v = _mm256_add_ps(c, _mm256_mul_ps(k, _mm256_sub_ps(_mm256_add_ps(l, r), _mm256_add_ps(c, c))));
+            if (last) {
+                v = _mm256_mul_ps(v, e);
+                v = _mm256_and_ps(_mm256_cmp_ps(v, clear, _CMP_GE_OQ), v);
+                vmax = _mm256_max_ps(vmax, v);
+            }
+            _mm256_storeu_ps(out + row * B, v);
+        }
+        if (last) {
+            __m128 m4 = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+            m4 = _mm_max_ps(m4, _mm_movehl_ps(m4, m4));
+            m4 = _mm_max_ss(m4, _mm_shuffle_ps(m4, m4, 1));
+            m_brickMax[brick] = _mm_cvtss_f32(m4);
+        }
+        return;
+    }
+#elif defined(USE_WASM_SIMD)
+    // Rows along y and z are plain vector adds, x keeps scalar code below
+    if (simd && Axis != 0) {
+        const v128_t k = wasm_f32x4_splat(DIFFUSION);
+        const v128_t e = wasm_f32x4_splat(evaporate);
+        const v128_t clear = wasm_f32x4_splat(CLEAR_LEVEL);
+        v128_t vmax = wasm_f32x4_splat(0.0f);
+        for (int row = 0; row < B * B; ++row) {
+            const int y = row & (B - 1), z = row >> BRICK_SHIFT;
+            const float* lp;
+            const float* rp;
+            if constexpr (Axis == 1) {
+                lp = y > 0 ? in + (row - 1) * B : prevIn + (z * B + B - 1) * B;
+                rp = y < B - 1 ? in + (row + 1) * B : nextIn + (z * B) * B;
+            } else {
+                lp = z > 0 ? in + (row - B) * B : prevIn + ((B - 1) * B + y) * B;
+                rp = z < B - 1 ? in + (row + B) * B : nextIn + y * B;
+            }
+            for (int x = 0; x < B; x += 4) {
+                const v128_t c = wasm_v128_load(in + row * B + x);
+                const v128_t l = wasm_v128_load(lp + x);
+                const v128_t r = wasm_v128_load(rp + x);
+                v128_t v = wasm_f32x4_add(c, wasm_f32x4_mul(k, wasm_f32x4_sub(wasm_f32x4_add(l, r), wasm_f32x4_add(c, c))));
+                if (last) {
+                    v = wasm_f32x4_mul(v, e);
+                    v = wasm_v128_and(wasm_f32x4_ge(v, clear), v);
+                    vmax = wasm_f32x4_pmax(vmax, v);
+                }
+                wasm_v128_store(out + row * B + x, v);
+            }
+        }
+        if (last) {
+            maximum = std::max(std::max(wasm_f32x4_extract_lane(vmax, 0), wasm_f32x4_extract_lane(vmax, 1)),
+                std::max(wasm_f32x4_extract_lane(vmax, 2), wasm_f32x4_extract_lane(vmax, 3)));
+            m_brickMax[brick] = maximum;
+        }
+        return;
+    }
+#endif
+
+    (void)simd;
+    for (int row = 0; row < B * B; ++row) {
+        const int y = row & (B - 1), z = row >> BRICK_SHIFT;
+        const float* c = in + row * B;
+        for (int x = 0; x < B; ++x) {
+            float l, r;
+            if constexpr (Axis == 0) {
+                l = x > 0 ? c[x - 1] : prevIn[row * B + B - 1];
+                r = x < B - 1 ? c[x + 1] : nextIn[row * B];
+            } else if constexpr (Axis == 1) {
+                l = y > 0 ? c[x - B] : prevIn[(z * B + B - 1) * B + x];
+                r = y < B - 1 ? c[x + B] : nextIn[(z * B) * B + x];
+            } else {
+                l = z > 0 ? c[x - B * B] : prevIn[((B - 1) * B + y) * B + x];
+                r = z < B - 1 ? c[x + B * B] : nextIn[y * B + x];
+            }
+            float v = c[x] + DIFFUSION * ((l + r) - (c[x] + c[x]));
+            if (last) {
+                v *= evaporate;
+                v = v >= CLEAR_LEVEL ? v : 0.0f;
+                maximum = std::max(maximum, v);
+            }
+            out[row * B + x] = v;
+        }
+    }
+    if (last)
+        m_brickMax[brick] = maximum;
+}
+
+
+void SlimeMoldVolume::Private::diffuse(float evaporate)
+{
+    const bool simd = m_kernels == SlimeMoldSimulation::KERNELS_SIMD;
+    auto& pool = ThreadPool::global();
+    const size_t nBricks = m_brickMax.size();
+    // x: volume -> scratch, y: scratch -> volume, z: volume -> scratch, then swap
+    pool.parallelFor(nBricks, BRICK_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b)
+            diffuseBrick<0>(m_volume.data(), m_scratch.data(), b, evaporate, false, simd);
+    });
+    pool.parallelFor(nBricks, BRICK_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b)
+            diffuseBrick<1>(m_scratch.data(), m_volume.data(), b, evaporate, false, simd);
+    });
+    pool.parallelFor(nBricks, BRICK_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b)
+            diffuseBrick<2>(m_volume.data(), m_scratch.data(), b, evaporate, true, simd);
+    });
+    std::swap(m_volume, m_scratch);
+    updateNearMax();
+}
+
+
+// Separable 3x3x3 maximum of brick maxima, neighbours do not wrap as rays do not
+void SlimeMoldVolume::Private::updateNearMax()
+{
+    const size_t strides[3] = { 1, m_bricksX, m_bricksX * m_bricksY };
+    const size_t counts[3] = { m_bricksX, m_bricksY, m_bricksZ };
+    std::vector<float>* src = &m_brickMax;
+    std::vector<float> pass(m_brickMax.size());
+    for (int axis = 0; axis < 3; ++axis) {
+        std::vector<float>& dst = axis == 1 ? pass : m_nearMax;
+        const size_t stride = strides[axis];
+        for (size_t b = 0; b < dst.size(); ++b) {
+            const size_t i = (b / stride) % counts[axis];
+            float m = (*src)[b];
+            if (i > 0)
+                m = std::max(m, (*src)[b - stride]);
+            if (i + 1 < counts[axis])
+                m = std::max(m, (*src)[b + stride]);
+            dst[b] = m;
+        }
+        src = &dst;
+    }
+}
+
+
+View SlimeMoldVolume::Private::makeView(const Camera& camera, size_t width, size_t height) const
+{
+    const float cy = std::cos(camera.yaw), sy = std::sin(camera.yaw);
+    const float cp = std::cos(camera.pitch), sp = std::sin(camera.pitch);
+    View v;
+    v.fx = -cp * sy;
+    v.fy = -sp;
+    v.fz = -cp * cy;
+    v.rx = cy;
+    v.ry = 0.0f;
+    v.rz = -sy;
+    // up = right x forward
+    v.ux = v.ry * v.fz - v.rz * v.fy;
+    v.uy = v.rz * v.fx - v.rx * v.fz;
+    v.uz = v.rx * v.fy - v.ry * v.fx;
+    const float w = static_cast<float>(m_width), h = static_cast<float>(m_height), d = static_cast<float>(m_depth);
+    const float diagonal = std::sqrt(w * w + h * h + d * d);
+    // Plane is one voxel outside of sphere around volume, shorter image side spans diagonal at zoom 1
+    const float distance = diagonal * 0.5f + 1.0f;
+    v.cx = w * 0.5f - v.fx * distance;
+    v.cy = h * 0.5f - v.fy * distance;
+    v.cz = d * 0.5f - v.fz * distance;
+    v.pixelSize = diagonal / std::max(camera.zoom, 0.01f) / static_cast<float>(std::max<size_t>(std::min(width, height), 1));
+    v.width = width;
+    v.height = height;
+    return v;
+}
+
+
+Ray SlimeMoldVolume::Private::makeRay(const View& v, size_t i, size_t j) const
+{
+    const float a = (static_cast<float>(i) + 0.5f - static_cast<float>(v.width) * 0.5f) * v.pixelSize;
+    const float b = (static_cast<float>(v.height) * 0.5f - static_cast<float>(j) - 0.5f) * v.pixelSize;
+    Ray ray;
+    ray.ox = v.cx + v.rx * a + v.ux * b;
+    ray.oy = v.cy + v.ry * a + v.uy * b;
+    ray.oz = v.cz + v.rz * a + v.uz * b;
+    ray.dx = v.fx;
+    ray.dy = v.fy;
+    ray.dz = v.fz;
+
+    // Clip to box [0, size] along each axis
+    float tNear = 0.0f, tFar = std::numeric_limits<float>::max();
+    auto clip = [&](float o, float d, size_t n) {
+        if (std::abs(d) < 1e-6f)
+            return o >= 0.0f && o <= static_cast<float>(n);
+        const float t0 = -o / d;
+        const float t1 = (static_cast<float>(n) - o) / d;
+        tNear = std::max(tNear, std::min(t0, t1));
+        tFar = std::min(tFar, std::max(t0, t1));
+        return true;
+    };
+    const bool inside = clip(ray.ox, ray.dx, m_width) && clip(ray.oy, ray.dy, m_height) && clip(ray.oz, ray.dz, m_depth);
+    ray.kBegin = static_cast<int>(std::ceil(tNear / RAY_STEP));
+    ray.kEnd = inside && tNear <= tFar ? static_cast<int>(std::floor(tFar / RAY_STEP)) + 1 : ray.kBegin;
+    return ray;
+}
+
+
+// Brick around middle of samples [k, k + 8), all of them are within 3.5 voxels
+// from it, so in that brick or its neighbours
+inline size_t SlimeMoldVolume::Private::chunkBrick(const Ray& ray, int k) const
+{
+    const float t = (static_cast<float>(k) + 3.5f) * RAY_STEP;
+    const int x = std::clamp(static_cast<int>(std::floor(ray.ox + ray.dx * t)), 0, static_cast<int>(m_width) - 1) >> BRICK_SHIFT;
+    const int y = std::clamp(static_cast<int>(std::floor(ray.oy + ray.dy * t)), 0, static_cast<int>(m_height) - 1) >> BRICK_SHIFT;
+    const int z = std::clamp(static_cast<int>(std::floor(ray.oz + ray.dz * t)), 0, static_cast<int>(m_depth) - 1) >> BRICK_SHIFT;
+    return (static_cast<size_t>(z) * m_bricksY + y) * m_bricksX + x;
+}
+
+
+#if defined(USE_AVX2)
+// Trail at samples [k, k + n) of ray, n <= 8, lanes past n repeat last sample
+inline __m256 SlimeMoldVolume::Private::raySamplesAvx2(const Ray& ray, int k, int n) const
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i ks = _mm256_min_epi32(_mm256_add_epi32(_mm256_set1_epi32(k), lane), _mm256_set1_epi32(k + n - 1));
+    const __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(ks), _mm256_set1_ps(RAY_STEP));
+    const __m256i zero = _mm256_setzero_si256();
+    auto voxel = [&](float o, float d, size_t size) {
+        const __m256 p = _mm256_add_ps(_mm256_set1_ps(o), _mm256_mul_ps(_mm256_set1_ps(d), t));
+        const __m256i i = _mm256_cvttps_epi32(_mm256_floor_ps(p));
+        return _mm256_min_epi32(_mm256_max_epi32(i, zero), _mm256_set1_epi32(static_cast<int>(size) - 1));
+    };
+    const __m256i xi = voxel(ray.ox, ray.dx, m_width);
+    const __m256i yi = voxel(ray.oy, ray.dy, m_height);
+    const __m256i zi = voxel(ray.oz, ray.dz, m_depth);
+    const __m256i mask = _mm256_set1_epi32(BRICK_MASK);
+    const __m256i brick = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_srli_epi32(zi, BRICK_SHIFT), _mm256_set1_epi32(static_cast<int>(m_bricksY))),
+        _mm256_srli_epi32(yi, BRICK_SHIFT)), _mm256_set1_epi32(static_cast<int>(m_bricksX))),
+        _mm256_srli_epi32(xi, BRICK_SHIFT));
+    const __m256i index = _mm256_or_si256(
+        _mm256_or_si256(_mm256_slli_epi32(brick, 3 * BRICK_SHIFT), _mm256_slli_epi32(_mm256_and_si256(zi, mask), 2 * BRICK_SHIFT)),
+        _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(yi, mask), BRICK_SHIFT), _mm256_and_si256(xi, mask)));
+    return _mm256_i32gather_ps(m_volume.data(), index, 4);
+}
+#endif
+
+
+// Trail at samples [k, k + n) of ray, voxels are clamped to volume
+inline void SlimeMoldVolume::Private::raySamples(const Ray& ray, int k, int n, float* values, bool simd) const
+{
+#if defined(USE_AVX2)
+    if (simd) {
+        _mm256_storeu_ps(values, raySamplesAvx2(ray, k, n));
+        return;
+    }
+#endif
+    (void)simd;
+    for (int j = 0; j < n; ++j) {
+        const float t = static_cast<float>(k + j) * RAY_STEP;
+        const int x = std::clamp(static_cast<int>(std::floor(ray.ox + ray.dx * t)), 0, static_cast<int>(m_width) - 1);
+        const int y = std::clamp(static_cast<int>(std::floor(ray.oy + ray.dy * t)), 0, static_cast<int>(m_height) - 1);
+        const int z = std::clamp(static_cast<int>(std::floor(ray.oz + ray.dz * t)), 0, static_cast<int>(m_depth) - 1);
+        values[j] = m_volume[voxelIndex(x, y, z)];
+    }
+}
+
+
+// Rays go in chunks of 8 samples, chunk is skipped when maximum near its brick
+// is too low to change result
+float SlimeMoldVolume::Private::marchMip(const Ray& ray, bool simd) const
+{
+    float value = 0.0f;
+#if defined(USE_AVX2)
+    // Maximum does not depend on order, lanes keep their own until the end
+    if (simd) {
+        __m256 vmax = _mm256_setzero_ps();
+        for (int k = ray.kBegin; k < ray.kEnd; k += 8) {
+            if (m_nearMax[chunkBrick(ray, k)] <= value)
+                continue;
+            vmax = _mm256_max_ps(vmax, raySamplesAvx2(ray, k, std::min(8, ray.kEnd - k)));
+            __m128 m4 = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+            m4 = _mm_max_ps(m4, _mm_movehl_ps(m4, m4));
+            value = _mm_cvtss_f32(_mm_max_ss(m4, _mm_shuffle_ps(m4, m4, 1)));
+        }
+        return value;
+    }
+#endif
+    float samples[8];
+    for (int k = ray.kBegin; k < ray.kEnd; k += 8) {
+        if (m_nearMax[chunkBrick(ray, k)] <= value)
+            continue;
+        const int n = std::min(8, ray.kEnd - k);
+        raySamples(ray, k, n, samples, simd);
+        for (int j = 0; j < n; ++j)
+            value = std::max(value, samples[j]);
+    }
+    return value;
+}
+
+
+float SlimeMoldVolume::Private::marchEmission(const Ray& ray, bool simd) const
+{
+    (void)simd;
+    float value = 0.0f;
+    float transmittance = 1.0f;
+    alignas(32) float samples[8];
+    alignas(32) float alphas[8];
+    for (int k = ray.kBegin; k < ray.kEnd && transmittance >= OPAQUE_LEVEL; k += 8) {
+        if (m_nearMax[chunkBrick(ray, k)] < EMPTY_LEVEL)
+            continue;
+        const int n = std::min(8, ray.kEnd - k);
+#if defined(USE_AVX2)
+        if (simd) {
+            const __m256 v = raySamplesAvx2(ray, k, n);
+            const __m256 a = _mm256_mul_ps(v, _mm256_set1_ps(ABSORPTION));
+            const __m256 alpha = _mm256_and_ps(_mm256_cmp_ps(v, _mm256_set1_ps(EMPTY_LEVEL), _CMP_GE_OQ),
+                _mm256_div_ps(a, _mm256_add_ps(_mm256_set1_ps(1.0f), a)));
+            _mm256_store_ps(samples, v);
+            _mm256_store_ps(alphas, alpha);
+        } else
+#endif
+        {
+            raySamples(ray, k, n, samples, false);
+            for (int j = 0; j < n; ++j)
+                alphas[j] = opacity(samples[j]);
+        }
+        // Transparent samples add 0 and keep transmittance exactly
+        for (int j = 0; j < n; ++j) {
+            value += transmittance * alphas[j] * samples[j];
+            transmittance *= 1.0f - alphas[j];
+        }
+    }
+    return value;
+}
+
+
+SlimeMoldVolume::SlimeMoldVolume(size_t width, size_t height, size_t depth, size_t numAgents, uint32_t seed)
+    : m_p(std::make_unique<Private>(width, height, depth, numAgents, seed))
+{
+}
+
+
+SlimeMoldVolume::~SlimeMoldVolume() = default;
+
+
+void SlimeMoldVolume::step(const AgentPreset& preset)
+{
+    auto& p = *m_p;
+    if (p.m_steps++ % SORT_INTERVAL == 0)
+        p.sortAgents();
+    p.moveAgents(p.makeMoveParams(preset));
+    p.deposit();
+    p.diffuse(preset.evaporate);
+}
+
+
+void SlimeMoldVolume::reset()
+{
+    auto& p = *m_p;
+    std::fill(p.m_volume.begin(), p.m_volume.end(), 0.0f);
+    std::fill(p.m_brickMax.begin(), p.m_brickMax.end(), 0.0f);
+    std::fill(p.m_nearMax.begin(), p.m_nearMax.end(), 0.0f);
+    p.m_steps = 0;
+    p.resetAgents();
+}
+
+
+void SlimeMoldVolume::reset(uint32_t seed)
+{
+    m_p->m_rng.seed(seed);
+    reset();
+}
+
+
+void SlimeMoldVolume::setKernels(SlimeMoldSimulation::Kernels kernels)
+{
+    m_p->m_kernels = kernels;
+}
+
+
+SlimeMoldSimulation::Kernels SlimeMoldVolume::kernels() const
+{
+    return m_p->m_kernels;
+}
+
+
+size_t SlimeMoldVolume::width() const
+{
+    return m_p->m_width;
+}
+
+
+size_t SlimeMoldVolume::height() const
+{
+    return m_p->m_height;
+}
+
+
+size_t SlimeMoldVolume::depth() const
+{
+    return m_p->m_depth;
+}
+
+
+size_t SlimeMoldVolume::numAgents() const
+{
+    return m_p->m_numAgents;
+}
+
+
+float SlimeMoldVolume::voxel(size_t x, size_t y, size_t z) const
+{
+    return m_p->m_volume[m_p->voxelIndex(static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(z))];
+}
+
+
+void SlimeMoldVolume::render(float* image, size_t width, size_t height, const Camera& camera, Render mode) const
+{
+    const auto& p = *m_p;
+    const bool simd = p.m_kernels == SlimeMoldSimulation::KERNELS_SIMD;
+    const View view = p.makeView(camera, width, height);
+    ThreadPool::global().parallelFor(height, ROW_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+            for (size_t i = 0; i < width; ++i) {
+                const Ray ray = p.makeRay(view, i, j);
+                image[j * width + i] = mode == RENDER_MIP ? p.marchMip(ray, simd) : p.marchEmission(ray, simd);
+            }
+        }
+    });
+}
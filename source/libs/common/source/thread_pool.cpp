@@ -0,0 +1,355 @@
+//! \file thread_pool.cpp
+#include "common/thread_pool.h"
+#include "common/cpu_topology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define THREAD_POOL_SERIAL 1
+#else
+#define THREAD_POOL_SERIAL 0
+#endif
+
+#if !THREAD_POOL_SERIAL && defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#define THREAD_POOL_AFFINITY 1
+#else
+#define THREAD_POOL_AFFINITY 0
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Set on worker threads and on caller thread while it processes chunks.
+// Used to run nested loops serially instead of deadlocking.
+thread_local bool t_insideLoop = false;
+
+
+// Chunk range [next, end) of a thread packed in one word, owner takes chunks
+// from front and thieves take upper half, both by compare and swap
+constexpr uint64_t packRange(uint32_t next, uint32_t end)
+{
+    return (static_cast<uint64_t>(end) << 32) | next;
+}
+
+
+// Thread state, on its own cache line
+struct alignas(64) Slot
+{
+    std::atomic<uint64_t> range = 0;
+    std::atomic<uint64_t> busyNs = 0;
+    std::atomic<uint64_t> chunks = 0;
+    std::atomic<uint64_t> stolenChunks = 0;
+    int cpu = -1;
+    uint32_t capacity = 1024;
+};
+
+
+bool pinThread([[maybe_unused]] std::thread& thread, [[maybe_unused]] int cpu)
+{
+#if THREAD_POOL_AFFINITY
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+} // anonymous namespace
+
+
+class ThreadPool::Private final
+{
+public:
+    explicit Private(size_t numThreads);
+    ~Private();
+
+    void startWorkers(size_t numThreads, const std::vector<int>& cpus);
+    void stopWorkers();
+    void workerLoop(size_t self, size_t seenGeneration);
+    void splitChunks(size_t nChunks);
+    bool popChunk(Slot& slot, size_t& chunk);
+    bool stealChunks(size_t self);
+    void runChunks(size_t self);
+
+    std::vector<std::thread> workers;
+    //! Slot 0 is caller, slot i is worker i - 1
+    std::unique_ptr<Slot[]> slots;
+    size_t numSlots = 0;
+
+    //! Serializes callers, busy pool means serial execution
+    std::mutex callMutex;
+
+    //! Guards job description and worker state below
+    std::mutex mutex;
+    std::condition_variable wakeCv;
+    std::condition_variable doneCv;
+    size_t generation = 0;
+    size_t activeWorkers = 0;
+    bool stop = false;
+
+    // Current job
+    const RangeFunction* fn = nullptr;
+    size_t count = 0;
+    size_t chunkSize = 1;
+};
+
+
+ThreadPool::Private::Private(size_t numThreads)
+{
+    startWorkers(numThreads, {});
+}
+
+
+ThreadPool::Private::~Private()
+{
+    stopWorkers();
+}
+
+
+void ThreadPool::Private::startWorkers(size_t numThreads, const std::vector<int>& cpus)
+{
+#if THREAD_POOL_SERIAL
+    numThreads = 1;
+#else
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    stop = false;
+    numSlots = numThreads;
+    slots = std::make_unique<Slot[]>(numSlots);
+    const std::vector<CpuInfo> topology = cpus.empty() ? std::vector<CpuInfo>() : cpuTopology();
+    workers.reserve(numThreads - 1);
+    // Generation is passed, worker starting late must not take next job for one it has seen
+    for (size_t i = 1; i < numThreads; ++i) {
+        workers.emplace_back([this, i, g = generation] { workerLoop(i, g); });
+        if (cpus.empty())
+            continue;
+        const int cpu = cpus[(i - 1) % cpus.size()];
+        if (!pinThread(workers.back(), cpu))
+            continue;
+        slots[i].cpu = cpu;
+        const auto info = std::ranges::find(topology, cpu, &CpuInfo::id);
+        if (info != topology.end())
+            slots[i].capacity = std::max<uint32_t>(info->capacity, 1);
+    }
+}
+
+
+void ThreadPool::Private::stopWorkers()
+{
+    {
+        std::lock_guard lock(mutex);
+        stop = true;
+    }
+    wakeCv.notify_all();
+    for (auto& t : workers)
+        t.join();
+    workers.clear();
+}
+
+
+void ThreadPool::Private::workerLoop(size_t self, size_t seenGeneration)
+{
+    t_insideLoop = true;
+    for (;;) {
+        {
+            std::unique_lock lock(mutex);
+            wakeCv.wait(lock, [&] { return stop || generation != seenGeneration; });
+            if (stop)
+                return;
+            seenGeneration = generation;
+        }
+        runChunks(self);
+        {
+            std::lock_guard lock(mutex);
+            if (--activeWorkers == 0)
+                doneCv.notify_one();
+        }
+    }
+}
+
+
+// Contiguous ranges proportional to capacity, so that same thread gets same
+// part of data every step and slow cores get less of it
+void ThreadPool::Private::splitChunks(size_t nChunks)
+{
+    uint64_t totalCapacity = 0;
+    for (size_t i = 0; i < numSlots; ++i)
+        totalCapacity += slots[i].capacity;
+    uint64_t capacity = 0;
+    uint32_t begin = 0;
+    for (size_t i = 0; i < numSlots; ++i) {
+        capacity += slots[i].capacity;
+        const auto end = static_cast<uint32_t>(nChunks * capacity / totalCapacity);
+        slots[i].range.store(packRange(begin, end), std::memory_order_relaxed);
+        begin = end;
+    }
+}
+
+
+bool ThreadPool::Private::popChunk(Slot& slot, size_t& chunk)
+{
+    uint64_t range = slot.range.load(std::memory_order_acquire);
+    for (;;) {
+        const auto next = static_cast<uint32_t>(range);
+        const auto end = static_cast<uint32_t>(range >> 32);
+        if (next >= end)
+            return false;
+        if (slot.range.compare_exchange_weak(range, packRange(next + 1, end), std::memory_order_acq_rel)) {
+            chunk = next;
+            return true;
+        }
+    }
+}
+
+
+// Takes upper half of largest remaining range, false when all are empty.
+// Chunks are never returned to a range, so a range value cannot repeat (no ABA).
+bool ThreadPool::Private::stealChunks(size_t self)
+{
+    for (;;) {
+        size_t victim = numSlots;
+        uint32_t largest = 0;
+        for (size_t i = 0; i < numSlots; ++i) {
+            const uint64_t range = slots[i].range.load(std::memory_order_relaxed);
+            const auto next = static_cast<uint32_t>(range);
+            const auto end = static_cast<uint32_t>(range >> 32);
+            if (i != self && next < end && end - next > largest) {
+                largest = end - next;
+                victim = i;
+            }
+        }
+        if (victim == numSlots)
+            return false;
+        uint64_t range = slots[victim].range.load(std::memory_order_acquire);
+        const auto next = static_cast<uint32_t>(range);
+        const auto end = static_cast<uint32_t>(range >> 32);
+        if (next >= end)
+            continue;
+        const uint32_t mid = next + (end - next) / 2;
+        if (slots[victim].range.compare_exchange_strong(range, packRange(next, mid), std::memory_order_acq_rel)) {
+            slots[self].range.store(packRange(mid, end), std::memory_order_release);
+            slots[self].stolenChunks.fetch_add(end - mid, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+
+void ThreadPool::Private::runChunks(size_t self)
+{
+    Slot& slot = slots[self];
+    for (;;) {
+        size_t chunk = 0;
+        if (!popChunk(slot, chunk)) {
+            if (!stealChunks(self))
+                break;
+            continue;
+        }
+        const size_t begin = chunk * chunkSize;
+        const auto start = Clock::now();
+        (*fn)(begin, std::min(begin + chunkSize, count));
+        slot.busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(),
+            std::memory_order_relaxed);
+        slot.chunks.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : m_p(std::make_unique<Private>(numThreads))
+{
+}
+
+
+ThreadPool::~ThreadPool() = default;
+
+
+size_t ThreadPool::size() const noexcept
+{
+    return m_p->workers.size() + 1;
+}
+
+
+void ThreadPool::resize(size_t numThreads, const std::vector<int>& cpus)
+{
+    std::lock_guard lock(m_p->callMutex);
+    m_p->stopWorkers();
+    m_p->startWorkers(numThreads, cpus);
+}
+
+
+void ThreadPool::parallelFor(size_t count, size_t chunkSize, const RangeFunction& fn)
+{
+    if (count == 0)
+        return;
+    chunkSize = std::max<size_t>(chunkSize, 1);
+    if (m_p->workers.empty() || t_insideLoop || count <= chunkSize || !m_p->callMutex.try_lock()) {
+        // Same ranges as parallel run
+        const auto start = Clock::now();
+        for (size_t begin = 0; begin < count; begin += chunkSize)
+            fn(begin, std::min(begin + chunkSize, count));
+        // Caller of pool without workers, other serial runs overlap pool loops
+        if (m_p->workers.empty() && !t_insideLoop) {
+            Slot& slot = m_p->slots[0];
+            slot.busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(),
+                std::memory_order_relaxed);
+            slot.chunks.fetch_add((count + chunkSize - 1) / chunkSize, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_p->mutex);
+        m_p->fn = &fn;
+        m_p->count = count;
+        m_p->chunkSize = chunkSize;
+        m_p->splitChunks((count + chunkSize - 1) / chunkSize);
+        m_p->activeWorkers = m_p->workers.size();
+        ++m_p->generation;
+    }
+    m_p->wakeCv.notify_all();
+
+    t_insideLoop = true;
+    m_p->runChunks(0);
+    t_insideLoop = false;
+
+    {
+        std::unique_lock lock(m_p->mutex);
+        m_p->doneCv.wait(lock, [&] { return m_p->activeWorkers == 0; });
+        m_p->fn = nullptr;
+    }
+    m_p->callMutex.unlock();
+}
+
+
+std::vector<ThreadPool::WorkerStats> ThreadPool::stats() const
+{
+    std::vector<WorkerStats> result(m_p->numSlots);
+    for (size_t i = 0; i < m_p->numSlots; ++i) {
+        const Slot& slot = m_p->slots[i];
+        result[i].cpu = slot.cpu;
+        result[i].busySeconds = slot.busyNs.load(std::memory_order_relaxed) * 1e-9;
+        result[i].chunks = slot.chunks.load(std::memory_order_relaxed);
+        result[i].stolenChunks = slot.stolenChunks.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+
+ThreadPool& ThreadPool::global()
+{
+    static ThreadPool pool;
+    return pool;
+}
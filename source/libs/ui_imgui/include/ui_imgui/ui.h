@@ -27,6 +27,7 @@ public:
     [[nodiscard]] bool initialized() const noexcept;
 
 private:
+    //! Initial window, it is resizable and simulation is scaled to it
     static constexpr int SIMULATION_WIDTH  = 640;
     static constexpr int SIMULATION_HEIGHT = 480;
     static constexpr int SIDEPANEL_WIDTH   = 224;
@@ -1,5 +1,6 @@
 //! \file ui.cpp
 #include "ui_imgui/ui.h"
+#include "common/colormap.h"
 #include "common/slime_mold_viewmodel.h"
 #include "common/presets.h"
 #include "common/colors.h"
@@ -10,11 +11,57 @@
 #include <backends/imgui_impl_sdl3.h>
 #include <backends/imgui_impl_sdlrenderer3.h>
 
+#include <algorithm>
 #include <string>
 #include <array>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
 
 // TODO: initialization error handling
 
+namespace {
+
+//! Shared memory object for external consumers, see frame_server.h
+constexpr const char* SHARED_FRAMES_NAME = "/slime_mold";
+
+//! Event log written when recording stops, replay by slime_mold_replay
+constexpr const char* RECORDING_PATH = "slime_mold.smlog";
+
+//! Raw field stream for analysis tools, read by slime_mold_field_stream
+constexpr const char* FIELD_STREAM_PATH = "slime_mold.smfs";
+
+//! Input maps (binary PGM/PPM) loaded from working directory, see input_map.h
+constexpr const char* OBSTACLES_PATH  = "obstacles.pgm";
+constexpr const char* ATTRACTORS_PATH = "attractors.pgm";
+
+//! Simulation resolutions, display is scaled from them to fit window
+struct Resolution {
+    int width, height;
+    const char* label;
+};
+constexpr std::array<Resolution, 4> RESOLUTIONS = {{
+    { 320, 240, "320 x 240" },
+    { 640, 480, "640 x 480" },
+    { 1280, 960, "1280 x 960" },
+    { 1920, 1440, "1920 x 1440" },
+}};
+constexpr int DEFAULT_RESOLUTION = 1;
+
+//! 2D field or volumes of given edge in voxels, see slime_mold_volume.h
+struct VolumeMode {
+    size_t size;
+    const char* label;
+};
+constexpr std::array<VolumeMode, 3> VOLUME_MODES = {{
+    { 0, "2D field" },
+    { 128, "3D 128^3" },
+    { 256, "3D 256^3" },
+}};
+constexpr float ORBIT_SPEED = 0.3f;     // radians per second
+
+} // anonymous namespace
+
 class Ui::Private final
 {
 public:
@@ -29,40 +76,111 @@ public:
     bool done = false;
     bool initialized = false;
 
-    SlimeMoldViewModel viewModel;
+    //! Replaced when resolution changes, at start of frame
+    std::unique_ptr<SlimeMoldViewModel> viewModel;
     std::vector<uint8_t> pixels;
+    int resolution = DEFAULT_RESOLUTION;
+    int requestedResolution = DEFAULT_RESOLUTION;
+    void applyResolution();
+
+    //! Display in pixels of window (more than its size on HiDPI screens),
+    //! centered in area left of side panel with aspect of simulation
+    int textureWidth = 0;
+    int textureHeight = 0;
+    SDL_FRect displayRect = {};
+    colormap::Filter displayFilter = colormap::FILTER_BILINEAR;
+    void fitDisplay();
+
+    //! Volumetric mode, kept when resolution changes, camera orbits when enabled
+    int volumeMode = 0;
+    bool orbit = true;
 
     uint64_t last_counter = 0;
 
     // Holds copy of agent for ImGUI updates
     AgentPreset agent;
+
+    // Requested steps per frame, governor may do fewer
+    int stepsPerFrame = 1;
+    int lifecycleMaxAge = 2000;
+    float spawnThreshold = 20.0f;
+    float morphSeconds = 0.0f;
+    float showHoldSeconds = 10.0f;
+    int fieldStreamEvery = 10;
 };
 
 
 Ui::Private::Private()
-    : viewModel(Ui::SIMULATION_WIDTH, Ui::SIMULATION_HEIGHT)
+    : viewModel(std::make_unique<SlimeMoldViewModel>(RESOLUTIONS[DEFAULT_RESOLUTION].width, RESOLUTIONS[DEFAULT_RESOLUTION].height))
+{
+}
+
+
+void Ui::Private::applyResolution()
+{
+    if (requestedResolution == resolution)
+        return;
+    // Presets and their edits carry over, other settings start from defaults
+    const size_t preset = viewModel->selectedPreset();
+    const size_t palettePreset = viewModel->selectedPalette();
+    const AgentPreset edited = viewModel->agent();
+    const auto palette = viewModel->palette();
+    viewModel.reset();
+    const Resolution& r = RESOLUTIONS[requestedResolution];
+    viewModel = std::make_unique<SlimeMoldViewModel>(r.width, r.height);
+    viewModel->selectAgentPreset(preset);
+    viewModel->selectPalettePreset(palettePreset);
+    viewModel->setAgent(edited);
+    viewModel->setPalette(palette);
+    viewModel->setStepsPerFrame(stepsPerFrame);
+    viewModel->setVolume(VOLUME_MODES[volumeMode].size);
+    resolution = requestedResolution;
+    textureWidth = 0;
+}
+
+
+void Ui::Private::fitDisplay()
 {
-    pixels.resize(Ui::SIMULATION_WIDTH * Ui::SIMULATION_HEIGHT * 4);
+    int windowWidth = 0, windowHeight = 0;
+    SDL_GetWindowSize(window, &windowWidth, &windowHeight);
+    const float density = SDL_GetWindowPixelDensity(window);
+    const float areaWidth = std::max(windowWidth - Ui::SIDEPANEL_WIDTH, 1) * density;
+    const float areaHeight = std::max(windowHeight, 1) * density;
+    const Resolution& r = RESOLUTIONS[resolution];
+    const float fit = std::min(areaWidth / r.width, areaHeight / r.height);
+    const int width = std::max(1, static_cast<int>(r.width * fit));
+    const int height = std::max(1, static_cast<int>(r.height * fit));
+    displayRect = { std::floor((areaWidth - width) / 2), std::floor((areaHeight - height) / 2),
+        static_cast<float>(width), static_cast<float>(height) };
+    if (width == textureWidth && height == textureHeight)
+        return;
+
+    SDL_DestroyTexture(texture);
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB32, SDL_TEXTUREACCESS_STREAMING, width, height);
+    // Texture is drawn 1:1, scaling is done by colormap
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+    textureWidth = width;
+    textureHeight = height;
+    pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+    viewModel->setDisplay(width, height, displayFilter);
 }
 
 
 Ui::Ui()
     : m_p(std::make_unique<Private>())
 {
+    // Approximate color conversions are good enough for 8-bit palette and make palette edits cheap
+    color::setUseLookupTables(true);
     SDL_Init(SDL_INIT_VIDEO);
-    m_p->window = SDL_CreateWindow("Slime Mold", TOTAL_WIDTH, SIMULATION_HEIGHT, 0);
+    m_p->window = SDL_CreateWindow("Slime Mold", TOTAL_WIDTH, SIMULATION_HEIGHT,
+        SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY);
     if (!m_p->window) {
         SDL_Log("Failed to create window: %s", SDL_GetError());
         return;
     }
+    SDL_SetWindowMinimumSize(m_p->window, SIDEPANEL_WIDTH + 160, 240);
     m_p->renderer = SDL_CreateRenderer(m_p->window, nullptr);
-    m_p->texture = SDL_CreateTexture(
-        m_p->renderer,
-        SDL_PIXELFORMAT_ARGB32,
-        SDL_TEXTUREACCESS_STREAMING,
-        SIMULATION_WIDTH,
-        SIMULATION_HEIGHT
-    );
+    // Texture is created by first frame, it follows window size
 
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -122,8 +240,11 @@ void Ui::processEvent(union SDL_Event* e)
 
 void Ui::frame() 
 {
+    m_p->applyResolution();
+    m_p->fitDisplay();
+
     // Make references for easy access, copy agent
-    auto& vm = m_p->viewModel;
+    auto& vm = *m_p->viewModel;
     auto& agent = m_p->agent;
     agent = vm.agent();
 
@@ -141,8 +262,10 @@ void Ui::frame()
     m_p->last_counter = current_counter;
 
     // Position the sidebar on the right side
-    ImGui::SetNextWindowPos(ImVec2(SIMULATION_WIDTH, 0));
-    ImGui::SetNextWindowSize(ImVec2(SIDEPANEL_WIDTH, SIMULATION_HEIGHT));
+    int windowWidth = 0, windowHeight = 0;
+    SDL_GetWindowSize(m_p->window, &windowWidth, &windowHeight);
+    ImGui::SetNextWindowPos(ImVec2(static_cast<float>(windowWidth - SIDEPANEL_WIDTH), 0));
+    ImGui::SetNextWindowSize(ImVec2(SIDEPANEL_WIDTH, static_cast<float>(windowHeight)));
     ImGui::Begin("Parameters", nullptr,
         ImGuiWindowFlags_NoResize |
         ImGuiWindowFlags_NoMove |
@@ -151,6 +274,9 @@ void Ui::frame()
     ImGui::PushItemWidth(-1); // Use full available width for sliders
     ImGui::Spacing();
     ImGui::Text("FPS %.1f", fps);
+    const auto governor = vm.governorStats();
+    ImGui::Text("Step %.2f ms x%zu, Color %.2f ms", governor.stepMs, governor.stepsPerFrame, governor.colormapMs);
+    ImGui::Text("Agents %zu / %zu", governor.activeAgents, governor.maxAgents);
 
     ImGui::Text("Simulation Parameters");
     ImGui::Separator();
@@ -162,7 +288,9 @@ void Ui::frame()
     }
 
     ImGui::Text("Sensor Distance");
-    if (ImGui::SliderFloat("##sensor_dist", &agent.sensor_dist, 1.0f, 12.0f)) {
+    // Pyramid makes far sensors as cheap as near ones
+    const float maxSensorDist = vm.sensorPyramid() ? 48.0f : 12.0f;
+    if (ImGui::SliderFloat("##sensor_dist", &agent.sensor_dist, 1.0f, maxSensorDist)) {
         vm.setAgent(agent);
     }
 
@@ -181,10 +309,158 @@ void Ui::frame()
         vm.setAgent(agent);
     }
 
+    bool bilinear = vm.bilinearSampling();
+    if (ImGui::Checkbox("Bilinear sensors", &bilinear)) {
+        vm.setBilinearSampling(bilinear);
+    }
+    constexpr std::array<const char*, SlimeMoldSimulation::BOUNDARY_END> boundaryLabels = { "Wrap", "Reflect", "Absorb" };
+    int boundary = vm.boundary();
+    ImGui::Text("Edges");
+    if (ImGui::Combo("##boundary", &boundary, boundaryLabels.data(), static_cast<int>(boundaryLabels.size()))) {
+        vm.setBoundary(static_cast<SlimeMoldSimulation::Boundary>(boundary));
+    }
+    bool compact = vm.compactAgents();
+    if (ImGui::Checkbox("Compact agents", &compact)) {
+        vm.setCompactAgents(compact);
+    }
+    bool pyramid = vm.sensorPyramid();
+    if (ImGui::Checkbox("Long range sensors", &pyramid)) {
+        vm.setSensorPyramid(pyramid);
+    }
+
+    bool lifecycle = vm.lifecycleEnabled();
+    bool lifecycleChanged = ImGui::Checkbox("Birth and death", &lifecycle);
+    if (lifecycle) {
+        ImGui::Text("Max Age / Spawn Trail");
+        lifecycleChanged |= ImGui::SliderInt("##max_age", &m_p->lifecycleMaxAge, 0, 10000);
+        lifecycleChanged |= ImGui::SliderFloat("##spawn_threshold", &m_p->spawnThreshold, 1.0f, 100.0f);
+    }
+    if (lifecycleChanged) {
+        vm.setLifecycle(lifecycle, static_cast<uint32_t>(m_p->lifecycleMaxAge), m_p->spawnThreshold);
+    }
+
+#if !defined(__EMSCRIPTEN__)
+    bool inputMap = vm.hasInputMap();
+    // Event log does not hold input maps
+    ImGui::BeginDisabled(vm.recording());
+    if (ImGui::Checkbox("Input maps", &inputMap)) {
+        if (!inputMap)
+            vm.clearInputMap();
+        else if (!vm.loadInputMap(OBSTACLES_PATH, ATTRACTORS_PATH))
+            SDL_Log("Failed to load %s or %s", OBSTACLES_PATH, ATTRACTORS_PATH);
+    }
+    if (inputMap) {
+        float strength = vm.attractorStrength();
+        ImGui::Text("Attractor Strength");
+        if (ImGui::SliderFloat("##attractor_strength", &strength, -2.0f, 2.0f)) {
+            vm.setAttractorStrength(strength);
+        }
+    }
+    ImGui::EndDisabled();
+#endif
+
     ImGui::Spacing();
     if (ImGui::Button("Reset")) {
         vm.reset();
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset Agents")) {
+        vm.resetAgents();
+    }
+    constexpr std::array<const char*, SlimeMoldSimulation::SPAWN_END> spawnLabels = { "Uniform", "Disc", "Ring", "Image", "Poisson disc" };
+    int spawnMode = vm.spawnMode();
+    if (ImGui::Combo("##spawn_mode", &spawnMode, spawnLabels.data(), static_cast<int>(spawnLabels.size()))) {
+        vm.setSpawnMode(static_cast<SlimeMoldSimulation::SpawnMode>(spawnMode));
+    }
+
+    ImGui::Text("Resolution (restarts)");
+    std::array<const char*, RESOLUTIONS.size()> resolutionLabels;
+    std::ranges::transform(RESOLUTIONS, resolutionLabels.begin(), &Resolution::label);
+    ImGui::Combo("##resolution", &m_p->requestedResolution, resolutionLabels.data(), static_cast<int>(resolutionLabels.size()));
+    ImGui::Text("Display %zu x %zu", vm.displayWidth(), vm.displayHeight());
+    constexpr std::array<const char*, colormap::FILTER_END> filterLabels = { "Nearest", "Bilinear", "Lanczos" };
+    int filter = m_p->displayFilter;
+    if (ImGui::Combo("##display_filter", &filter, filterLabels.data(), static_cast<int>(filterLabels.size()))) {
+        m_p->displayFilter = static_cast<colormap::Filter>(filter);
+        vm.setDisplay(vm.displayWidth(), vm.displayHeight(), m_p->displayFilter);
+    }
+
+    ImGui::Text("Mode");
+    std::array<const char*, VOLUME_MODES.size()> volumeLabels;
+    std::ranges::transform(VOLUME_MODES, volumeLabels.begin(), &VolumeMode::label);
+    if (ImGui::Combo("##volume_mode", &m_p->volumeMode, volumeLabels.data(), static_cast<int>(volumeLabels.size()))) {
+        vm.setVolume(VOLUME_MODES[m_p->volumeMode].size);
+    }
+    if (vm.volumeSize() != 0) {
+        constexpr std::array<const char*, SlimeMoldVolume::RENDER_END> renderLabels = { "Maximum", "Emission" };
+        auto camera = vm.volumeCamera();
+        int render = vm.volumeRender();
+        bool viewChanged = ImGui::Combo("##volume_render", &render, renderLabels.data(), static_cast<int>(renderLabels.size()));
+        ImGui::Checkbox("Orbit", &m_p->orbit);
+        ImGui::Text("Yaw / Pitch / Zoom");
+        viewChanged |= ImGui::SliderFloat("##yaw", &camera.yaw, -std::numbers::pi_v<float>, std::numbers::pi_v<float>);
+        viewChanged |= ImGui::SliderFloat("##pitch", &camera.pitch, -1.5f, 1.5f);
+        viewChanged |= ImGui::SliderFloat("##zoom", &camera.zoom, 0.5f, 4.0f);
+        if (m_p->orbit) {
+            camera.yaw = std::remainder(camera.yaw + ORBIT_SPEED * delta_time, 2.0f * std::numbers::pi_v<float>);
+            viewChanged = true;
+        }
+        if (viewChanged) {
+            vm.setVolumeView(camera, static_cast<SlimeMoldVolume::Render>(render));
+        }
+    }
+
+    ImGui::Text("Steps per Frame");
+    if (ImGui::SliderInt("##steps_per_frame", &m_p->stepsPerFrame, 1, 4)) {
+        vm.setStepsPerFrame(m_p->stepsPerFrame);
+    }
+    bool pipelined = vm.pipelined();
+    if (ImGui::Checkbox("Overlap steps and drawing", &pipelined)) {
+        vm.setPipelined(pipelined);
+    }
+    bool pinned = vm.pinnedThreads();
+    if (ImGui::Checkbox("Pin threads to cores", &pinned)) {
+        vm.setPinnedThreads(pinned);
+    }
+    if (ImGui::TreeNode("Thread load")) {
+        const auto workers = vm.workerStats();
+        for (size_t i = 0; i < workers.size(); ++i) {
+            char label[64];
+            if (workers[i].cpu >= 0)
+                snprintf(label, sizeof(label), "CPU %d, stolen %.0f%%", workers[i].cpu, workers[i].stolen * 100.0f);
+            else
+                snprintf(label, sizeof(label), "%s, stolen %.0f%%", i == 0 ? "Caller" : "Unpinned", workers[i].stolen * 100.0f);
+            ImGui::ProgressBar(workers[i].utilization, ImVec2(-1.0f, 0.0f), label);
+        }
+        ImGui::TreePop();
+    }
+    bool profiling = vm.phaseProfiling();
+    if (ImGui::Checkbox("Profile phases", &profiling)) {
+        vm.setPhaseProfiling(profiling);
+    }
+    if (profiling) {
+        static constexpr const char* PHASE_NAMES[] = { "Move", "Deposit", "Sort", "Lifecycle", "Diffuse" };
+        const auto phases = vm.phaseStats();
+        if (!phases.empty() && phases[0].cycles < 0.0f)
+            ImGui::TextDisabled("Hardware counters not available");
+        else if (!phases.empty())
+            ImGui::TextDisabled("Counting %zu threads", phases[0].threads);
+        for (const auto& ph : phases) {
+            ImGui::Text("%-9s %6.3f ms", PHASE_NAMES[ph.phase], ph.msPerStep);
+            if (ph.cycles < 0.0f)
+                continue;
+            ImGui::SameLine();
+            ImGui::Text("%6.1f cyc %6.1f ins %5.2f LLC %5.2f TLB /%s", ph.cycles, ph.instructions,
+                ph.llcMisses, ph.dtlbMisses, ph.perCell ? "cell" : "agent");
+        }
+    }
+    bool governed = governor.enabled;
+    float budgetMs = governor.budgetMs;
+    bool governorChanged = ImGui::Checkbox("Frame budget (ms)", &governed);
+    governorChanged |= ImGui::SliderFloat("##frame_budget", &budgetMs, 2.0f, 33.0f);
+    if (governorChanged) {
+        vm.setGovernor(governed, budgetMs);
+    }
     ImGui::Separator();
     ImGui::Spacing();
     ImGui::Text("Color Palette");
@@ -202,6 +478,16 @@ void Ui::frame()
     if (ImGui::SliderFloat("##palette_mid", &agent.palette_mid, 0.0f, 1.0f)) {
         vm.setAgent(agent);
     }
+
+    ImGui::Text("Tone Mapping");
+    constexpr std::array<const char*, SlimeMoldViewModel::TONEMAP_END> toneLabels = { "Fixed", "Percentile", "Logarithmic" };
+    int toneMapping = vm.toneMapping();
+    if (ImGui::Combo("##tone_mapping", &toneMapping, toneLabels.data(), static_cast<int>(toneLabels.size()))) {
+        vm.setToneMapping(static_cast<SlimeMoldViewModel::ToneMapping>(toneMapping));
+    }
+    const auto stats = vm.fieldStats();
+    ImGui::Text("Max %.1f Mean %.2f", stats.max, stats.mean);
+    ImGui::Text("P99.5 %.1f Exposure %.1f", stats.percentile, stats.exposure);
 #if 0
     // Maybe hide this, LCH is superior and least boring
     ImGui::Text("Color interpolation");
@@ -219,7 +505,10 @@ void Ui::frame()
         for (int i = 0; i < presetAgents().size(); i++) {
             bool is_selected = (vm.selectedPreset() == i);
             if (ImGui::Selectable(presetAgents()[i].name.data(), is_selected)) {
-                vm.selectAgentPreset(i);
+                if (m_p->morphSeconds > 0.0f)
+                    vm.morphToPresets(i, vm.selectedPalette(), m_p->morphSeconds);
+                else
+                    vm.selectAgentPreset(i);
             }
             if (is_selected) {
                 ImGui::SetItemDefaultFocus();
@@ -232,7 +521,10 @@ void Ui::frame()
         for (int i = 0; i < presetPalettes().size(); i++) {
             bool is_selected = (vm.selectedPalette() == i);
             if (ImGui::Selectable(presetPalettes()[i].name.data(), is_selected)) {
-                vm.selectPalettePreset(i);
+                if (m_p->morphSeconds > 0.0f)
+                    vm.morphToPresets(vm.selectedPreset(), i, m_p->morphSeconds);
+                else
+                    vm.selectPalettePreset(i);
             }
             if (is_selected) {
                 ImGui::SetItemDefaultFocus();
@@ -241,6 +533,58 @@ void Ui::frame()
         ImGui::EndCombo();
     }
 
+    ImGui::Text("Morph (s) / Show Hold (s)");
+    ImGui::SliderFloat("##morph_seconds", &m_p->morphSeconds, 0.0f, 30.0f);
+    bool show = vm.showEnabled();
+    bool showChanged = ImGui::Checkbox("Show", &show);
+    ImGui::SameLine();
+    showChanged |= ImGui::SliderFloat("##show_hold", &m_p->showHoldSeconds, 1.0f, 120.0f);
+    if (showChanged) {
+        vm.setShow(show, m_p->showHoldSeconds, std::max(m_p->morphSeconds, 1.0f));
+    }
+
+#if !defined(__EMSCRIPTEN__)
+    bool sharing = vm.publishing();
+    if (ImGui::Checkbox("Share frames", &sharing)) {
+        if (sharing)
+            vm.startPublishing(SHARED_FRAMES_NAME);
+        else
+            vm.stopPublishing();
+    }
+
+    bool streaming = vm.fieldStreaming();
+    if (ImGui::Checkbox("Stream field", &streaming)) {
+        if (streaming) {
+            if (!vm.startFieldStream(FIELD_STREAM_PATH, m_p->fieldStreamEvery))
+                SDL_Log("Failed to create %s", FIELD_STREAM_PATH);
+        }
+        else if (vm.stopFieldStream()) {
+            SDL_Log("Field stream saved to %s", FIELD_STREAM_PATH);
+        }
+        else {
+            SDL_Log("Failed to write field stream %s", FIELD_STREAM_PATH);
+        }
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(streaming);
+    ImGui::SliderInt("##field_stream_every", &m_p->fieldStreamEvery, 1, 100, "every %d steps");
+    ImGui::EndDisabled();
+
+    bool recording = vm.recording();
+    if (ImGui::Checkbox("Record (restarts)", &recording)) {
+        if (recording) {
+            if (!vm.startRecording())
+                SDL_Log("Input maps are not recorded, clear them to record");
+        }
+        else if (vm.stopRecording(RECORDING_PATH)) {
+            SDL_Log("Recording saved to %s", RECORDING_PATH);
+        }
+        else {
+            SDL_Log("Failed to save recording to %s", RECORDING_PATH);
+        }
+    }
+#endif
+
     ImGui::PopItemWidth();
     ImGui::End();
 
@@ -250,12 +594,9 @@ void Ui::frame()
     SDL_SetRenderDrawColor(m_p->renderer, 40, 40, 40, 255);
     SDL_RenderClear(m_p->renderer);
 
-    // Define the destination rectangle for the main simulation area
-    constexpr SDL_FRect mainRect = { 0, 0, SIMULATION_WIDTH, SIMULATION_HEIGHT };
-
-    // Upload pixel data and render simulation
-    SDL_UpdateTexture(m_p->texture, nullptr, m_p->pixels.data(), SIMULATION_WIDTH * 4);
-    SDL_RenderTexture(m_p->renderer, m_p->texture, nullptr, &mainRect);
+    // Upload pixel data and render simulation, render coordinates are pixels
+    SDL_UpdateTexture(m_p->texture, nullptr, m_p->pixels.data(), m_p->textureWidth * 4);
+    SDL_RenderTexture(m_p->renderer, m_p->texture, nullptr, &m_p->displayRect);
 
     // Render ImGui on top
     ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), m_p->renderer);